@@ -14,11 +14,17 @@ list(TRANSFORM TRACY_COMMON_SOURCES PREPEND "${TRACY_COMMON_DIR}/")
 set(TRACY_SERVER_DIR ${CMAKE_CURRENT_LIST_DIR}/../server)
 
 set(TRACY_SERVER_SOURCES
+    TracyAnalysisEngine.cpp
+    TracyCompare.cpp
+    TracyCriticalPath.cpp
+    TracyLockAnalysis.cpp
     TracyMemory.cpp
     TracyMmap.cpp
     TracyPrint.cpp
+    TracySchedulerAnalysis.cpp
     TracySysUtil.cpp
     TracyTaskDispatch.cpp
+    TracyTextIndex.cpp
     TracyTextureCompression.cpp
     TracyThreadCompress.cpp
     TracyWorker.cpp
@@ -13,6 +13,7 @@ option(DOWNLOAD_GLFW "Force download glfw" OFF)
 option(DOWNLOAD_FREETYPE "Force download freetype" OFF)
 option(DOWNLOAD_LIBCURL "Force download libcURL" OFF)
 option(DOWNLOAD_PUGIXML "Force download pugixml" OFF)
+option(DOWNLOAD_ZLIB "Force download zlib" OFF)
 
 # capstone
 
@@ -115,6 +116,27 @@ CPMAddPackage(
     SOURCE_SUBDIR build/cmake
 )
 
+# zlib
+
+pkg_check_modules(ZLIB zlib)
+if(ZLIB_FOUND AND NOT DOWNLOAD_ZLIB)
+    add_library(TracyZlib INTERFACE)
+    target_include_directories(TracyZlib INTERFACE ${ZLIB_INCLUDE_DIRS})
+    target_link_libraries(TracyZlib INTERFACE ${ZLIB_LINK_LIBRARIES})
+else()
+    CPMAddPackage(
+        NAME zlib
+        GITHUB_REPOSITORY madler/zlib
+        GIT_TAG v1.3.1
+        OPTIONS
+            "ZLIB_BUILD_EXAMPLES OFF"
+        EXCLUDE_FROM_ALL TRUE
+    )
+    add_library(TracyZlib INTERFACE)
+    target_include_directories(TracyZlib INTERFACE ${zlib_SOURCE_DIR} ${zlib_BINARY_DIR})
+    target_link_libraries(TracyZlib INTERFACE zlibstatic)
+endif()
+
 # Diff Template Library
 
 set(DTL_DIR "${ROOT_DIR}/dtl")
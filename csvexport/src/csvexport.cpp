@@ -4,16 +4,23 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #include <math.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
+#include "../../server/TracyCharUtil.hpp"
 #include "../../server/TracyFileRead.hpp"
+#include "../../server/TracyPrint.hpp"
+#include "../../server/TracyTaskDispatch.hpp"
 #include "../../server/TracyWorker.hpp"
 #include "../../getopt/getopt.h"
 
@@ -32,6 +39,8 @@ void print_usage_exit(int e)
     fprintf(stderr, "  -g, --gpu         Report each gpu zone event\n" );
     fprintf(stderr, "  -m, --messages    Report only messages\n");
     fprintf(stderr, "  -p, --plot        Report plot data (only with -u)\n");
+    fprintf(stderr, "  -j, --jobs arg    Number of export threads (default: all cores)\n");
+    fprintf(stderr, "  -b, --binary arg  Write zone events to a columnar binary file (only with -u, not with -g)\n");
 
     exit(e);
 }
@@ -46,6 +55,8 @@ struct Args {
     bool show_gpu;
     bool unwrapMessages;
     bool plot;
+    int jobs;
+    const char* binary_file;
 };
 
 Args parse_args(int argc, char** argv)
@@ -55,7 +66,7 @@ Args parse_args(int argc, char** argv)
         print_usage_exit(1);
     }
 
-    Args args = { "", ",", "", false, false, false, false, false, false };
+    Args args = { "", ",", "", false, false, false, false, false, false, 0, nullptr };
 
     struct option long_opts[] = {
         { "help", no_argument, NULL, 'h' },
@@ -67,11 +78,13 @@ Args parse_args(int argc, char** argv)
         { "gpu", no_argument, NULL, 'g' },
         { "messages", no_argument, NULL, 'm' },
         { "plot", no_argument, NULL, 'p' },
+        { "jobs", required_argument, NULL, 'j' },
+        { "binary", required_argument, NULL, 'b' },
         { NULL, 0, NULL, 0 }
     };
 
     int c;
-    while ((c = getopt_long(argc, argv, "hf:s:ceugmp", long_opts, NULL)) != -1)
+    while ((c = getopt_long(argc, argv, "hf:s:ceugmpj:b:", long_opts, NULL)) != -1)
     {
         switch (c)
         {
@@ -102,6 +115,12 @@ Args parse_args(int argc, char** argv)
         case 'p':
             args.plot = true;
             break;
+        case 'j':
+            args.jobs = atoi(optarg);
+            break;
+        case 'b':
+            args.binary_file = optarg;
+            break;
         default:
             print_usage_exit(1);
             break;
@@ -115,6 +134,17 @@ Args parse_args(int argc, char** argv)
 
     args.trace_file = argv[optind];
 
+    if (args.binary_file && !args.unwrap)
+    {
+        fprintf(stderr, "Binary output requires -u\n");
+        print_usage_exit(1);
+    }
+    if (args.binary_file && args.show_gpu)
+    {
+        fprintf(stderr, "Binary output is not available for GPU zones\n");
+        print_usage_exit(1);
+    }
+
     return args;
 }
 
@@ -193,6 +223,235 @@ int64_t GetZoneChildTimeFast(
     return time;
 }
 
+void append_int(std::string& out, int64_t val)
+{
+    char buf[32];
+    const auto end = std::to_chars(buf, buf + sizeof(buf), val).ptr;
+    out.append(buf, end);
+}
+
+void append_int(std::string& out, uint64_t val)
+{
+    char buf[32];
+    const auto end = std::to_chars(buf, buf + sizeof(buf), val).ptr;
+    out.append(buf, end);
+}
+
+// Same output as std::to_string(double)
+void append_real(std::string& out, double val)
+{
+    char buf[512];
+    const auto end = tracy::PrintFloat(buf, buf + sizeof(buf), val, 6);
+    out.append(buf, end);
+}
+
+void write_out(const std::string& out)
+{
+    fwrite(out.data(), 1, out.size(), stdout);
+}
+
+// Zone lists are split into chunks of at most this many zones, which are exported in
+// parallel. Chunks are processed in waves and written out in order, so the output does
+// not depend on the number of threads and only one wave has to be buffered at a time.
+constexpr size_t ChunkSize = 16 * 1024;
+
+struct ExportChunk
+{
+    size_t selected;    // index of the selected source location
+    size_t begin;
+    size_t end;
+    uint64_t row;       // index of the first row of the chunk in the output
+};
+
+template<typename GetSize>
+std::vector<ExportChunk> make_chunks(size_t count, GetSize get_size)
+{
+    std::vector<ExportChunk> chunks;
+    uint64_t row = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t size = get_size(i);
+        for (size_t j = 0; j < size; j += ChunkSize)
+        {
+            const auto end = std::min(j + ChunkSize, size);
+            chunks.push_back(ExportChunk { i, j, end, row });
+            row += end - j;
+        }
+    }
+    return chunks;
+}
+
+// Calls process(chunk index, slot in wave) for every chunk on the thread pool, and
+// flush(wave begin, wave end) on the calling thread after each wave is done.
+template<typename Process, typename Flush>
+void run_waves(tracy::TaskDispatch& td, size_t count, size_t wave, Process&& process, Flush&& flush)
+{
+    for (size_t i = 0; i < count; i += wave)
+    {
+        const auto end = std::min(i + wave, count);
+        for (size_t j = i; j < end; j++)
+        {
+            td.Queue([&process, i, j] { process(j, j - i); });
+        }
+        td.Sync();
+        flush(i, end);
+    }
+}
+
+// Columnar binary output for zone events, meant to be memory-mapped, e.g. with numpy.memmap.
+// Values are written in the host byte order, which is little-endian on all platforms supported by
+// Tracy. The file starts with a 64 byte header:
+//   char     magic[8]        "TRACYCOL"
+//   uint32_t version         1
+//   uint32_t columns         number of column descriptors following the header
+//   uint64_t rows            number of values in each column
+//   uint64_t srclocOffset    source location table, srclocCount entries of uint32_t { name, file, line, reserved }
+//   uint64_t srclocCount
+//   uint64_t stringOffset    string table, uint64_t offsets[stringCount+1] followed by the character data
+//   uint64_t stringCount
+// Each column descriptor is 40 bytes: char name[24], uint32_t type (0: uint32, 1: int64, 2: uint64),
+// uint32_t reserved, uint64_t offset. Column data is 64 byte aligned. String i spans the character
+// data range [offsets[i], offsets[i+1]) and is not NUL-terminated.
+// Zone columns:
+//   srcloc        uint32  index into the source location table
+//   start_ns      int64   zone start time
+//   exec_time_ns  int64   zone duration, or self time with -e
+//   thread        uint64  thread id
+//   text          uint32  index into the string table, 0xFFFFFFFF if the zone has no text
+class ColumnarWriter
+{
+public:
+    enum ColumnType : uint32_t { U32, I64, U64 };
+
+    ColumnarWriter(FILE* f, uint64_t rows)
+        : m_file(f)
+        , m_rows(rows)
+    {
+    }
+
+    ~ColumnarWriter()
+    {
+        fclose(m_file);
+    }
+
+    void AddColumn(const char* name, ColumnType type)
+    {
+        m_columns.push_back(Column { name, type, 0 });
+    }
+
+    // Must be called after all columns are added and before any data is written.
+    void Layout()
+    {
+        uint64_t offset = Align(HeaderSize + m_columns.size() * DescriptorSize);
+        for (auto& col : m_columns)
+        {
+            col.offset = offset;
+            offset = Align(offset + m_rows * TypeSize(col.type));
+        }
+        m_end = offset;
+    }
+
+    void WriteColumn(size_t column, uint64_t row, const void* data, uint64_t count)
+    {
+        auto& col = m_columns[column];
+        const auto size = TypeSize(col.type);
+        Seek(col.offset + row * size);
+        fwrite(data, size, count, m_file);
+    }
+
+    uint32_t AddString(const char* str)
+    {
+        auto it = m_stringMap.find(str);
+        if (it != m_stringMap.end()) return it->second;
+        const auto idx = uint32_t(m_stringOffsets.size());
+        m_stringOffsets.push_back(m_stringData.size());
+        m_stringData.append(str);
+        m_stringMap.emplace(str, idx);
+        return idx;
+    }
+
+    void AddSourceLocation(const char* name, const char* file, uint32_t line)
+    {
+        m_srcloc.push_back(AddString(name));
+        m_srcloc.push_back(AddString(file));
+        m_srcloc.push_back(line);
+        m_srcloc.push_back(0);
+    }
+
+    bool Finish()
+    {
+        const auto srclocOffset = m_end;
+        Seek(srclocOffset);
+        fwrite(m_srcloc.data(), sizeof(uint32_t), m_srcloc.size(), m_file);
+
+        const auto stringOffset = Align(srclocOffset + m_srcloc.size() * sizeof(uint32_t));
+        const uint64_t stringCount = m_stringOffsets.size();
+        m_stringOffsets.push_back(m_stringData.size());
+        Seek(stringOffset);
+        fwrite(m_stringOffsets.data(), sizeof(uint64_t), m_stringOffsets.size(), m_file);
+        fwrite(m_stringData.data(), 1, m_stringData.size(), m_file);
+
+        char header[HeaderSize] = {};
+        memcpy(header, "TRACYCOL", 8);
+        const uint32_t version = 1;
+        const uint32_t columns = uint32_t(m_columns.size());
+        const uint64_t srclocCount = m_srcloc.size() / 4;
+        memcpy(header + 8, &version, 4);
+        memcpy(header + 12, &columns, 4);
+        memcpy(header + 16, &m_rows, 8);
+        memcpy(header + 24, &srclocOffset, 8);
+        memcpy(header + 32, &srclocCount, 8);
+        memcpy(header + 40, &stringOffset, 8);
+        memcpy(header + 48, &stringCount, 8);
+        Seek(0);
+        fwrite(header, 1, HeaderSize, m_file);
+
+        for (auto& col : m_columns)
+        {
+            char desc[DescriptorSize] = {};
+            strncpy(desc, col.name, 23);
+            memcpy(desc + 24, &col.type, 4);
+            memcpy(desc + 32, &col.offset, 8);
+            fwrite(desc, 1, DescriptorSize, m_file);
+        }
+
+        return fflush(m_file) == 0 && !ferror(m_file);
+    }
+
+private:
+    enum { HeaderSize = 64, DescriptorSize = 40 };
+
+    struct Column
+    {
+        const char* name;
+        ColumnType type;
+        uint64_t offset;
+    };
+
+    static uint64_t Align(uint64_t offset) { return (offset + 63) & ~uint64_t(63); }
+    static uint64_t TypeSize(ColumnType type) { return type == U32 ? 4 : 8; }
+
+    void Seek(uint64_t offset)
+    {
+#ifdef _WIN32
+        _fseeki64(m_file, int64_t(offset), SEEK_SET);
+#else
+        fseeko(m_file, off_t(offset), SEEK_SET);
+#endif
+    }
+
+    FILE* m_file;
+    uint64_t m_rows;
+    uint64_t m_end = 0;
+    std::vector<Column> m_columns;
+    std::vector<uint32_t> m_srcloc;
+    std::vector<uint64_t> m_stringOffsets;
+    std::string m_stringData;
+    // Keys point to worker strings, which outlive the writer. The same text may be
+    // held by distinct worker strings, so keys are matched by content.
+    std::unordered_map<const char*, uint32_t, tracy::charutil::Hasher, tracy::charutil::Comparator> m_stringMap;
+};
+
 int main(int argc, char** argv)
 {
 #ifdef _WIN32
@@ -216,6 +475,10 @@ int main(int argc, char** argv)
 
     auto worker = tracy::Worker(*f);
 
+    const int jobs = args.jobs > 0 ? args.jobs : std::max(1, int(std::thread::hardware_concurrency()));
+    const size_t wave = size_t(jobs) * 4;
+    const std::string sep = args.separator;
+
     if (args.unwrapMessages) 
     {
         const auto& msgs = worker.GetMessages();
@@ -229,16 +492,20 @@ int main(int argc, char** argv)
             std::string headerForMessages = join(columnsForMessages, args.separator);
             printf("%s\n", headerForMessages.data());
 
+            std::string out;
             for(auto& it : msgs)
             {
-                std::vector<std::string> values(columnsForMessages.size());
-
-                values[0] = worker.GetString(it->ref);
-                values[1] = std::to_string(it->time);
-
-                std::string row = join(values, args.separator);
-                printf("%s\n", row.data());
+                out += worker.GetString(it->ref);
+                out += sep;
+                append_int(out, it->time);
+                out += '\n';
+                if (out.size() > 1024 * 1024)
+                {
+                    write_out(out);
+                    out.clear();
+                }
             }
+            write_out(out);
         }
         else
         {
@@ -253,6 +520,16 @@ int main(int argc, char** argv)
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 
+    tracy::TaskDispatch td(jobs, "Export");
+    std::vector<std::string> buffers(wave);
+    const auto flush_buffers = [&buffers](size_t begin, size_t end) {
+        for (size_t i = 0; i < end - begin; i++)
+        {
+            write_out(buffers[i]);
+            buffers[i].clear();
+        }
+    };
+
     if (args.show_gpu)
     {
         auto& gpu_slz = worker.GetGpuSourceLocationZones();
@@ -286,32 +563,33 @@ int main(int argc, char** argv)
         std::string header = join(columns, args.separator);
         printf("%s\n", header.data());
 
-        const auto last_time = worker.GetLastTime();
+        // Leading columns are the same for every zone of a source location
+        std::vector<std::string> prefixes;
         for (auto& it : gpu_slz_selected)
         {
-            std::vector<std::string> values( columns.size() );
-
-            values[0] = get_name( it->first, worker );
-
             const auto& srcloc = worker.GetSourceLocation( it->first );
-            values[1] = worker.GetString( srcloc.file );
+            prefixes.emplace_back( std::string( get_name( it->first, worker ) ) + sep + worker.GetString( srcloc.file ) + sep );
+        }
 
-            const auto& zone_data = it->second;
-            for (const auto& zone_thread_data : zone_data.zones)
+        const auto chunks = make_chunks(gpu_slz_selected.size(), [&](size_t i) { return gpu_slz_selected[i]->second.zones.size(); });
+        run_waves(td, chunks.size(), wave, [&](size_t idx, size_t slot) {
+            const auto& chunk = chunks[idx];
+            const auto& prefix = prefixes[chunk.selected];
+            const auto zones = gpu_slz_selected[chunk.selected]->second.zones.data();
+            auto& out = buffers[slot];
+            for (size_t i = chunk.begin; i < chunk.end; i++)
             {
-                tracy::GpuEvent* gpu_event = zone_thread_data.Zone();
+                const tracy::GpuEvent* gpu_event = zones[i].Zone();
                 const auto start = gpu_event->GpuStart();
                 const auto end = gpu_event->GpuEnd();
 
-                values[2] = std::to_string( start );
-
-                auto timespan = end - start;
-                values[3] = std::to_string( timespan );
-
-                std::string row = join( values, args.separator );
-                printf( "%s\n", row.data() );
+                out += prefix;
+                append_int(out, start);
+                out += sep;
+                append_int(out, end - start);
+                out += '\n';
             }
-        }
+        }, flush_buffers);
         return 0;
     }
 
@@ -340,6 +618,93 @@ int main(int argc, char** argv)
         }
     }
 
+    const auto chunks = make_chunks(slz_selected.size(), [&](size_t i) { return slz_selected[i]->second.zones.size(); });
+
+    if (args.binary_file)
+    {
+        FILE* bf = fopen(args.binary_file, "wb");
+        if (!bf)
+        {
+            fprintf(stderr, "Could not open file %s\n", args.binary_file);
+            return 1;
+        }
+
+        const uint64_t rows = chunks.empty() ? 0 : chunks.back().row + chunks.back().end - chunks.back().begin;
+        ColumnarWriter writer(bf, rows);
+        writer.AddColumn("srcloc", ColumnarWriter::U32);
+        writer.AddColumn("start_ns", ColumnarWriter::I64);
+        writer.AddColumn("exec_time_ns", ColumnarWriter::I64);
+        writer.AddColumn("thread", ColumnarWriter::U64);
+        writer.AddColumn("text", ColumnarWriter::U32);
+        writer.Layout();
+
+        for (auto& it : slz_selected)
+        {
+            const auto& srcloc = worker.GetSourceLocation(it->first);
+            writer.AddSourceLocation(get_name(it->first, worker), worker.GetString(srcloc.file), srcloc.line);
+        }
+
+        // Column values for one wave of chunks
+        uint64_t waveRows = 0;
+        for (size_t i = 0; i < chunks.size(); i += wave)
+        {
+            const auto& last = chunks[std::min(i + wave, chunks.size()) - 1];
+            waveRows = std::max(waveRows, last.row + last.end - last.begin - chunks[i].row);
+        }
+        std::vector<uint32_t> srclocCol(waveRows);
+        std::vector<int64_t> startCol(waveRows);
+        std::vector<int64_t> timeCol(waveRows);
+        std::vector<uint64_t> threadCol(waveRows);
+        std::vector<const char*> textPtr(waveRows);
+        std::vector<uint32_t> textCol(waveRows);
+        uint64_t waveRow = 0;
+
+        run_waves(td, chunks.size(), wave, [&](size_t idx, size_t) {
+            const auto& chunk = chunks[idx];
+            const auto zones = slz_selected[chunk.selected]->second.zones.data();
+            const auto base = chunk.row - waveRow;
+            for (size_t i = chunk.begin; i < chunk.end; i++)
+            {
+                const auto row = base + i - chunk.begin;
+                const auto zone_event = zones[i].Zone();
+                const auto start = zone_event->Start();
+                auto timespan = zone_event->End() - start;
+                if (args.self_time) {
+                    timespan -= GetZoneChildTimeFast(worker, *zone_event);
+                }
+                srclocCol[row] = uint32_t(chunk.selected);
+                startCol[row] = start;
+                timeCol[row] = timespan;
+                threadCol[row] = worker.DecompressThread(zones[i].Thread());
+                const char* text = nullptr;
+                if (worker.HasZoneExtra(*zone_event)) {
+                    const auto& extra = worker.GetZoneExtra(*zone_event);
+                    if (extra.text.Active()) text = worker.GetString(extra.text);
+                }
+                textPtr[row] = text;
+            }
+        }, [&](size_t begin, size_t end) {
+            const auto count = chunks[end-1].row + chunks[end-1].end - chunks[end-1].begin - waveRow;
+            for (size_t i = 0; i < count; i++)
+            {
+                textCol[i] = textPtr[i] ? writer.AddString(textPtr[i]) : 0xFFFFFFFF;
+            }
+            writer.WriteColumn(0, waveRow, srclocCol.data(), count);
+            writer.WriteColumn(1, waveRow, startCol.data(), count);
+            writer.WriteColumn(2, waveRow, timeCol.data(), count);
+            writer.WriteColumn(3, waveRow, threadCol.data(), count);
+            writer.WriteColumn(4, waveRow, textCol.data(), count);
+            waveRow += count;
+        });
+
+        if (!writer.Finish())
+        {
+            fprintf(stderr, "Could not write file %s\n", args.binary_file);
+            return 1;
+        }
+        return 0;
+    }
+
     std::vector<const char*> columns;
     if (args.unwrap)
     {
@@ -357,63 +722,84 @@ int main(int argc, char** argv)
     std::string header = join(columns, args.separator);
     printf("%s\n", header.data());
 
-    const auto last_time = worker.GetLastTime();
-    for(auto& it : slz_selected)
+    // Leading columns are the same for every zone of a source location
+    std::vector<std::string> prefixes;
+    for (auto& it : slz_selected)
     {
-        std::vector<std::string> values(columns.size());
-
-        values[0] = get_name(it->first, worker);
-
         const auto& srcloc = worker.GetSourceLocation(it->first);
-        values[1] = worker.GetString(srcloc.file);
-        values[2] = std::to_string(srcloc.line);
-
-        const auto& zone_data = it->second;
+        auto& prefix = prefixes.emplace_back(get_name(it->first, worker));
+        prefix += sep;
+        prefix += worker.GetString(srcloc.file);
+        prefix += sep;
+        append_int(prefix, int64_t(srcloc.line));
+        prefix += sep;
+    }
 
-        if (args.unwrap)
-        {
-            int i = 0;
-            for (const auto& zone_thread_data : zone_data.zones) {
-                const auto zone_event = zone_thread_data.Zone();
-                const auto tId = zone_thread_data.Thread();
+    const auto last_time = worker.GetLastTime();
+    if (args.unwrap)
+    {
+        run_waves(td, chunks.size(), wave, [&](size_t idx, size_t slot) {
+            const auto& chunk = chunks[idx];
+            const auto& prefix = prefixes[chunk.selected];
+            const auto zones = slz_selected[chunk.selected]->second.zones.data();
+            auto& out = buffers[slot];
+            for (size_t i = chunk.begin; i < chunk.end; i++)
+            {
+                const auto zone_event = zones[i].Zone();
+                const auto tId = zones[i].Thread();
                 const auto start = zone_event->Start();
                 const auto end = zone_event->End();
 
-                values[3] = std::to_string(start);
-
                 auto timespan = end - start;
                 if (args.self_time) {
                     timespan -= GetZoneChildTimeFast(worker, *zone_event);
                 }
-                values[4] = std::to_string(timespan);
-                values[5] = std::to_string(tId);
+
+                out += prefix;
+                append_int(out, start);
+                out += sep;
+                append_int(out, timespan);
+                out += sep;
+                append_int(out, uint64_t(tId));
+                out += sep;
                 if (worker.HasZoneExtra(*zone_event)) {
                     const auto& text = worker.GetZoneExtra(*zone_event).text;
                     if (text.Active()) {
-                        values[6] = worker.GetString(text);
+                        out += worker.GetString(text);
                     }
                 }
-
-                std::string row = join(values, args.separator);
-                printf("%s\n", row.data());
+                out += '\n';
             }
-        }
-        else
+        }, flush_buffers);
+    }
+    else
+    {
+        std::string out;
+        for (size_t i = 0; i < slz_selected.size(); i++)
         {
+            const auto& zone_data = slz_selected[i]->second;
+            out += prefixes[i];
+
             const auto time = args.self_time ? zone_data.selfTotal : zone_data.total;
-            values[3] = std::to_string(time);
-            values[4] = std::to_string(100. * time / last_time);
+            append_int(out, time);
+            out += sep;
+            append_real(out, 100. * time / last_time);
+            out += sep;
 
-            values[5] = std::to_string(zone_data.zones.size());
+            append_int(out, uint64_t(zone_data.zones.size()));
+            out += sep;
 
             const auto avg = (args.self_time ? zone_data.selfTotal : zone_data.total)
                 / zone_data.zones.size();
-            values[6] = std::to_string(avg);
+            append_int(out, uint64_t(avg));
+            out += sep;
 
             const auto tmin = args.self_time ? zone_data.selfMin : zone_data.min;
             const auto tmax = args.self_time ? zone_data.selfMax : zone_data.max;
-            values[7] = std::to_string(tmin);
-            values[8] = std::to_string(tmax);
+            append_int(out, tmin);
+            out += sep;
+            append_int(out, tmax);
+            out += sep;
 
             const auto sz = zone_data.zones.size();
             const auto ss = zone_data.sumSq
@@ -422,32 +808,40 @@ int main(int argc, char** argv)
             double std = 0;
             if( sz > 1 )
                 std = sqrt(ss / (sz - 1));
-            values[9] = std::to_string(std);
-
-            std::string row = join(values, args.separator);
-            printf("%s\n", row.data());
+            append_real(out, std);
+            out += '\n';
         }
+        write_out(out);
     }
 
     if(args.plot && args.unwrap)
     {
         auto& plots = worker.GetPlots();
+        std::string out;
         for(const auto& plot : plots)
         {
-            std::vector<std::string> values(columns.size());
-            values[0] = worker.GetString(plot->name);
+            std::string prefix = worker.GetString(plot->name);
+            prefix += sep;
+            prefix += sep;
+            prefix += sep;
 
             for(const auto& val : plot->data)
             {
-                if (args.unwrap)
+                out += prefix;
+                append_int(out, val.time.Val());
+                out += sep;
+                out += sep;
+                out += sep;
+                append_real(out, val.val);
+                out += '\n';
+                if (out.size() > 1024 * 1024)
                 {
-                    values[3] = std::to_string(val.time.Val());
-                    values[6] = std::to_string(val.val);
+                    write_out(out);
+                    out.clear();
                 }
-                std::string row = join(values, args.separator);
-                printf("%s\n", row.data());
             }
         }
+        write_out(out);
     }
 
     return 0;
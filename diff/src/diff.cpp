@@ -0,0 +1,506 @@
+#ifdef _WIN32
+#  include <windows.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../server/TracyCompare.hpp"
+#include "../../server/TracyFileRead.hpp"
+#include "../../server/TracyTaskDispatch.hpp"
+#include "../../server/TracyWorker.hpp"
+#include "../../getopt/getopt.h"
+
+enum { ExitOk = 0, ExitError = 1, ExitRegression = 2 };
+
+void print_usage_exit(int e)
+{
+    fprintf(stderr, "Compare timings of two traces and report regressions\n");
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  tracy-diff [OPTION...] <baseline trace> <current trace>\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -h, --help             Print usage\n");
+    fprintf(stderr, "  -f, --format arg       Output format, csv or json (default: csv)\n");
+    fprintf(stderr, "  -o, --output arg       Output file (default: stdout)\n");
+    fprintf(stderr, "  -t, --threshold arg    Regression threshold of mean time, in percent (default: 5)\n");
+    fprintf(stderr, "  -p, --pvalue arg       Significance level (default: 0.01)\n");
+    fprintf(stderr, "  -z, --zone arg         Fail on regression of the named zone (can be repeated)\n");
+    fprintf(stderr, "  -a, --all-zones        Fail on regression of any zone\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Frame set regressions always fail. Exit code is %i if a regression was found.\n", ExitRegression);
+    fprintf(stderr, "Zones matched by name only, without the source file, never fail.\n");
+
+    exit(e);
+}
+
+struct Args {
+    const char* baseline;
+    const char* current;
+    const char* output;
+    bool json;
+    double threshold;
+    double pvalue;
+    bool all_zones;
+    std::vector<const char*> zones;
+};
+
+Args parse_args(int argc, char** argv)
+{
+    if (argc == 1)
+    {
+        print_usage_exit(ExitError);
+    }
+
+    Args args = { "", "", nullptr, false, 5, 0.01, false, {} };
+
+    struct option long_opts[] = {
+        { "help", no_argument, NULL, 'h' },
+        { "format", required_argument, NULL, 'f' },
+        { "output", required_argument, NULL, 'o' },
+        { "threshold", required_argument, NULL, 't' },
+        { "pvalue", required_argument, NULL, 'p' },
+        { "zone", required_argument, NULL, 'z' },
+        { "all-zones", no_argument, NULL, 'a' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "hf:o:t:p:z:a", long_opts, NULL)) != -1)
+    {
+        switch (c)
+        {
+        case 'h':
+            print_usage_exit(ExitOk);
+            break;
+        case 'f':
+            if (strcmp(optarg, "json") == 0)
+            {
+                args.json = true;
+            }
+            else if (strcmp(optarg, "csv") != 0)
+            {
+                print_usage_exit(ExitError);
+            }
+            break;
+        case 'o':
+            args.output = optarg;
+            break;
+        case 't':
+            args.threshold = atof(optarg);
+            break;
+        case 'p':
+            args.pvalue = atof(optarg);
+            break;
+        case 'z':
+            args.zones.emplace_back(optarg);
+            break;
+        case 'a':
+            args.all_zones = true;
+            break;
+        default:
+            print_usage_exit(ExitError);
+            break;
+        }
+    }
+
+    if (argc != optind + 2)
+    {
+        print_usage_exit(ExitError);
+    }
+
+    args.baseline = argv[optind];
+    args.current = argv[optind + 1];
+
+    return args;
+}
+
+std::unique_ptr<tracy::Worker> load_trace(const char* fn)
+{
+    auto f = std::unique_ptr<tracy::FileRead>(tracy::FileRead::Open(fn));
+    if (!f)
+    {
+        fprintf(stderr, "Could not open file %s\n", fn);
+        return nullptr;
+    }
+    try
+    {
+        auto worker = std::make_unique<tracy::Worker>(*f);
+        while (!worker->AreSourceLocationZonesReady())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return worker;
+    }
+    catch (const tracy::UnsupportedVersion&)
+    {
+        fprintf(stderr, "%s: file is from a future version of Tracy\n", fn);
+    }
+    catch (const tracy::NotTracyDump&)
+    {
+        fprintf(stderr, "%s: not a Tracy dump\n", fn);
+    }
+    catch (const tracy::FileReadError& e)
+    {
+        fprintf(stderr, "%s: error reading file: %s\n", fn, e.what());
+    }
+    return nullptr;
+}
+
+// Values are reported as current vs baseline. Single-valued rows (threads) have empty
+// distribution columns.
+struct Row
+{
+    const char* kind;
+    std::string name;
+    std::string location;
+    const char* match;
+    uint64_t count[2];
+    double value[2];
+    int64_t median[2];
+    int64_t p99[2];
+    bool distribution;
+    double delta;
+    double pvalue;
+    double effect;
+    bool regression;
+    bool gated;
+};
+
+std::string frame_set_name(const tracy::FrameData& fd, const tracy::Worker& worker)
+{
+    if (fd.name == 0) return "Frames";
+    if (fd.name >> 63 != 0) return "[" + std::to_string(uint32_t(fd.name)) + "] Vsync";
+    return worker.GetString(fd.name);
+}
+
+void frame_sketch(const tracy::FrameData& fd, const tracy::Worker& worker, tracy::LogSketch& sketch, int64_t& total)
+{
+    total = 0;
+    if (fd.frames.empty()) return;
+    sketch.Init(std::max<int64_t>(fd.min, 1), std::max<int64_t>(fd.max, 1));
+    for (size_t i = 0; i < fd.frames.size(); i++)
+    {
+        // Skip the last, unfinished frame
+        if (worker.GetFrameEnd(fd, i) == worker.GetLastTime()) break;
+        const auto t = worker.GetFrameTime(fd, i);
+        sketch.Add(t);
+        total += t;
+    }
+}
+
+void fill_distribution(Row& row, const tracy::LogSketch* sketch, const Args& args)
+{
+    row.distribution = true;
+    for (int i = 0; i < 2; i++)
+    {
+        row.median[i] = sketch[i].Quantile(0.5);
+        row.p99[i] = sketch[i].Quantile(0.99);
+    }
+    double ks;
+    tracy::TraceCompare::Test(sketch[0], sketch[1], ks, row.pvalue, row.effect);
+    row.delta = row.value[1] != 0 ? 100. * (row.value[0] - row.value[1]) / row.value[1] : 0;
+    row.regression = row.delta > args.threshold && row.pvalue < args.pvalue;
+}
+
+void compare_frames(const tracy::Worker& cur, const tracy::Worker& base, const Args& args, std::vector<Row>& rows)
+{
+    for (auto& f0 : cur.GetFrames())
+    {
+        const auto name = frame_set_name(*f0, cur);
+        for (auto& f1 : base.GetFrames())
+        {
+            if (frame_set_name(*f1, base) != name) continue;
+
+            tracy::LogSketch sketch[2];
+            int64_t total[2];
+            frame_sketch(*f0, cur, sketch[0], total[0]);
+            frame_sketch(*f1, base, sketch[1], total[1]);
+            if (sketch[0].Count() == 0 || sketch[1].Count() == 0) break;
+
+            Row row = {};
+            row.kind = "frame";
+            row.name = name;
+            for (int i = 0; i < 2; i++)
+            {
+                row.count[i] = sketch[i].Count();
+                row.value[i] = double(total[i]) / row.count[i];
+            }
+            fill_distribution(row, sketch, args);
+            row.gated = true;
+            rows.emplace_back(std::move(row));
+            break;
+        }
+    }
+}
+
+void compare_zones(tracy::Worker& cur, tracy::Worker& base, const Args& args, std::vector<Row>& rows)
+{
+    tracy::TraceCompare engine(cur, base);
+    {
+        tracy::TaskDispatch td(std::thread::hardware_concurrency(), "Compare");
+        engine.Process(td);
+    }
+
+    for (auto& v : engine.GetResults())
+    {
+        auto& srcloc = cur.GetSourceLocation(v.srcloc[0]);
+        Row row = {};
+        row.kind = "zone";
+        row.name = cur.GetZoneName(srcloc);
+        row.location = std::string(cur.GetString(srcloc.file)) + ":" + std::to_string(srcloc.line);
+        row.match = v.match == tracy::TraceCompare::MatchExact ? "exact" : v.match == tracy::TraceCompare::MatchFile ? "file" : "name";
+        for (int i = 0; i < 2; i++)
+        {
+            row.count[i] = v.count[i];
+            row.value[i] = v.mean[i];
+            row.median[i] = v.median[i];
+            row.p99[i] = v.p99[i];
+        }
+        row.distribution = true;
+        row.pvalue = v.pValue;
+        row.effect = v.effect;
+        row.delta = 100. * (v.mean[0] - v.mean[1]) / v.mean[1];
+        row.regression = row.delta > args.threshold && row.pvalue < args.pvalue;
+        // Zones matched by name only may be unrelated code which happens to share the name.
+        if (v.match != tracy::TraceCompare::MatchName)
+        {
+            row.gated = args.all_zones;
+            for (auto& z : args.zones)
+            {
+                if (row.name == z) row.gated = true;
+            }
+        }
+        rows.emplace_back(std::move(row));
+    }
+}
+
+struct ThreadTime
+{
+    uint64_t count = 0;
+    int64_t busy = 0;
+};
+
+// Threads are matched by name, with same-named threads aggregated. The reported value is
+// the fraction of the capture time spent in top-level zones.
+std::vector<std::pair<std::string, ThreadTime>> thread_times(const tracy::Worker& worker)
+{
+    std::vector<std::pair<std::string, ThreadTime>> ret;
+    for (auto& t : worker.GetThreadData())
+    {
+        std::string name = worker.GetThreadName(t->id);
+        auto it = std::find_if(ret.begin(), ret.end(), [&name](const auto& v) { return v.first == name; });
+        if (it == ret.end())
+        {
+            ret.emplace_back(name, ThreadTime {});
+            it = ret.end() - 1;
+        }
+        it->second.count += t->count;
+        if (t->timeline.is_magic())
+        {
+            auto& vec = *(tracy::Vector<tracy::ZoneEvent>*)&t->timeline;
+            for (auto& z : vec)
+            {
+                if (z.IsEndValid()) it->second.busy += z.End() - z.Start();
+            }
+        }
+        else
+        {
+            for (auto& z : t->timeline)
+            {
+                if (z->IsEndValid()) it->second.busy += z->End() - z->Start();
+            }
+        }
+    }
+    return ret;
+}
+
+void compare_threads(const tracy::Worker& cur, const tracy::Worker& base, const Args& args, std::vector<Row>& rows)
+{
+    const auto t0 = thread_times(cur);
+    const auto t1 = thread_times(base);
+    const double duration[2] = {
+        double(std::max<int64_t>(cur.GetLastTime() - cur.GetFirstTime(), 1)),
+        double(std::max<int64_t>(base.GetLastTime() - base.GetFirstTime(), 1))
+    };
+
+    for (auto& v0 : t0)
+    {
+        auto it = std::find_if(t1.begin(), t1.end(), [&v0](const auto& v) { return v.first == v0.first; });
+        if (it == t1.end()) continue;
+        auto& v1 = *it;
+
+        Row row = {};
+        row.kind = "thread";
+        row.name = v0.first;
+        row.count[0] = v0.second.count;
+        row.count[1] = v1.second.count;
+        row.value[0] = v0.second.busy / duration[0];
+        row.value[1] = v1.second.busy / duration[1];
+        row.pvalue = 1;
+        row.delta = row.value[1] != 0 ? 100. * (row.value[0] - row.value[1]) / row.value[1] : 0;
+        row.regression = row.delta > args.threshold;
+        rows.emplace_back(std::move(row));
+    }
+}
+
+void print_csv_string(FILE* f, const std::string& str)
+{
+    if (str.find_first_of(",\"\n") == std::string::npos)
+    {
+        fputs(str.c_str(), f);
+        return;
+    }
+    fputc('"', f);
+    for (auto c : str)
+    {
+        if (c == '"') fputc('"', f);
+        fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+void print_json_string(FILE* f, const std::string& str)
+{
+    fputc('"', f);
+    for (auto c : str)
+    {
+        switch (c)
+        {
+        case '"': fputs("\\\"", f); break;
+        case '\\': fputs("\\\\", f); break;
+        case '\n': fputs("\\n", f); break;
+        case '\t': fputs("\\t", f); break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                fprintf(f, "\\u%04x", c);
+            }
+            else
+            {
+                fputc(c, f);
+            }
+            break;
+        }
+    }
+    fputc('"', f);
+}
+
+void write_csv(FILE* f, const std::vector<Row>& rows)
+{
+    fprintf(f, "kind,name,location,match,count_base,count_cur,value_base,value_cur,median_base_ns,median_cur_ns,p99_base_ns,p99_cur_ns,delta_perc,p_value,effect,regression\n");
+    for (auto& v : rows)
+    {
+        fprintf(f, "%s,", v.kind);
+        print_csv_string(f, v.name);
+        fputc(',', f);
+        print_csv_string(f, v.location);
+        fprintf(f, ",%s,%" PRIu64 ",%" PRIu64 ",%g,%g,", v.match ? v.match : "", v.count[1], v.count[0], v.value[1], v.value[0]);
+        if (v.distribution)
+        {
+            fprintf(f, "%" PRIi64 ",%" PRIi64 ",%" PRIi64 ",%" PRIi64 ",", v.median[1], v.median[0], v.p99[1], v.p99[0]);
+        }
+        else
+        {
+            fprintf(f, ",,,,");
+        }
+        fprintf(f, "%.2f,%g,%.4f,%i\n", v.delta, v.pvalue, v.effect, v.regression ? 1 : 0);
+    }
+}
+
+void write_json(FILE* f, const std::vector<Row>& rows, const Args& args, int regressions)
+{
+    fprintf(f, "{\n  \"baseline\": ");
+    print_json_string(f, args.baseline);
+    fprintf(f, ",\n  \"current\": ");
+    print_json_string(f, args.current);
+    fprintf(f, ",\n  \"threshold\": %g,\n  \"pValue\": %g,\n  \"regressions\": %i,\n  \"results\": [", args.threshold, args.pvalue, regressions);
+    bool first = true;
+    for (auto& v : rows)
+    {
+        fprintf(f, first ? "\n    { " : ",\n    { ");
+        first = false;
+        fprintf(f, "\"kind\": \"%s\", \"name\": ", v.kind);
+        print_json_string(f, v.name);
+        if (!v.location.empty())
+        {
+            fprintf(f, ", \"location\": ");
+            print_json_string(f, v.location);
+        }
+        if (v.match)
+        {
+            fprintf(f, ", \"match\": \"%s\"", v.match);
+        }
+        fprintf(f, ", \"count\": [%" PRIu64 ", %" PRIu64 "], \"value\": [%g, %g]", v.count[1], v.count[0], v.value[1], v.value[0]);
+        if (v.distribution)
+        {
+            fprintf(f, ", \"median\": [%" PRIi64 ", %" PRIi64 "], \"p99\": [%" PRIi64 ", %" PRIi64 "], \"pValue\": %g, \"effect\": %.4f", v.median[1], v.median[0], v.p99[1], v.p99[0], v.pvalue, v.effect);
+        }
+        fprintf(f, ", \"deltaPerc\": %.2f, \"regression\": %s, \"gated\": %s }", v.delta, v.regression ? "true" : "false", v.gated ? "true" : "false");
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+#ifdef _WIN32
+    if (!AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        AllocConsole();
+        SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), 0x07);
+    }
+#endif
+
+    Args args = parse_args(argc, argv);
+
+    auto base = load_trace(args.baseline);
+    if (!base) return ExitError;
+    auto cur = load_trace(args.current);
+    if (!cur) return ExitError;
+
+    std::vector<Row> rows;
+    compare_frames(*cur, *base, args, rows);
+    compare_zones(*cur, *base, args, rows);
+    compare_threads(*cur, *base, args, rows);
+
+    int regressions = 0;
+    for (auto& v : rows)
+    {
+        if (v.gated && v.regression)
+        {
+            regressions++;
+            fprintf(stderr, "Regression: %s %s (%+.2f%%, p = %g)\n", v.kind, v.name.c_str(), v.delta, v.pvalue);
+        }
+    }
+
+    FILE* f = stdout;
+    if (args.output)
+    {
+        f = fopen(args.output, "wb");
+        if (!f)
+        {
+            fprintf(stderr, "Could not open output file %s\n", args.output);
+            return ExitError;
+        }
+    }
+    if (args.json)
+    {
+        write_json(f, rows, args, regressions);
+    }
+    else
+    {
+        write_csv(f, rows);
+    }
+    if (f != stdout) fclose(f);
+
+    return regressions != 0 ? ExitRegression : ExitOk;
+}
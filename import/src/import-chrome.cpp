@@ -2,14 +2,20 @@
 #  include <windows.h>
 #endif
 
-#include <fstream>
+#include <algorithm>
+#include <deque>
+#include <istream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <streambuf>
 #include <string.h>
+#include <string_view>
 #include <sys/stat.h>
 #include <unordered_map>
+#include <zlib.h>
 #include <zstd.h>
 
 #ifdef _MSC_VER
@@ -20,14 +26,191 @@
 #endif
 
 #include "../../server/TracyFileWrite.hpp"
-#include "../../server/TracyMmap.hpp"
 #include "../../server/TracyWorker.hpp"
 
 using json = nlohmann::json;
 
+// Feeds the JSON parser with the input file contents, a chunk at a time, so that the
+// whole (possibly decompressed) input never has to be held in memory.
+class InputBuf : public std::streambuf
+{
+public:
+    InputBuf( FILE* f, uint64_t size ) : m_file( f ), m_size( size ), m_read( 0 ), m_percent( -1 ), m_buf( new char[BufSize] ) {}
+    virtual ~InputBuf() { delete[] m_buf; fclose( m_file ); }
+
+protected:
+    enum { BufSize = 1024*1024 };
+
+    int_type underflow() override
+    {
+        if( gptr() < egptr() ) return traits_type::to_int_type( *gptr() );
+        const auto sz = Fill( m_buf, BufSize );
+        if( sz == 0 ) return traits_type::eof();
+        setg( m_buf, m_buf, m_buf + sz );
+        return traits_type::to_int_type( *gptr() );
+    }
+
+    virtual size_t Fill( char* dst, size_t size ) { return ReadFile( dst, size ); }
+
+    size_t ReadFile( char* dst, size_t size )
+    {
+        const auto sz = fread( dst, 1, size, m_file );
+        m_read += sz;
+        const int percent = m_size == 0 ? 100 : int( m_read * 100 / m_size );
+        if( percent != m_percent )
+        {
+            m_percent = percent;
+            printf( "\33[2KParsing... %i%%\r", percent );
+            fflush( stdout );
+        }
+        return sz;
+    }
+
+private:
+    FILE* m_file;
+    uint64_t m_size;
+    uint64_t m_read;
+    int m_percent;
+    char* m_buf;
+};
+
+class ZstdInputBuf : public InputBuf
+{
+public:
+    ZstdInputBuf( FILE* f, uint64_t size ) : InputBuf( f, size ), m_ctx( ZSTD_createDStream() ), m_in( new char[BufSize] ), m_zin { m_in, 0, 0 }, m_res( 0 ), m_eof( false )
+    {
+        ZSTD_initDStream( m_ctx );
+    }
+
+    ~ZstdInputBuf() override
+    {
+        ZSTD_freeDStream( m_ctx );
+        delete[] m_in;
+    }
+
+protected:
+    size_t Fill( char* dst, size_t size ) override
+    {
+        ZSTD_outBuffer zout = { dst, size, 0 };
+        for(;;)
+        {
+            if( m_zin.pos == m_zin.size && !m_eof )
+            {
+                m_zin.size = ReadFile( m_in, BufSize );
+                m_zin.pos = 0;
+                m_eof = m_zin.size == 0;
+            }
+            // A zero result means that the last frame was completely decoded and flushed
+            if( m_eof && m_res == 0 ) return 0;
+            m_res = ZSTD_decompressStream( m_ctx, &zout, &m_zin );
+            if( ZSTD_isError( m_res ) )
+            {
+                fprintf( stderr, "\nCouldn't decompress input file (%s)!\n", ZSTD_getErrorName( m_res ) );
+                exit( 1 );
+            }
+            if( zout.pos > 0 ) return zout.pos;
+            if( m_eof )
+            {
+                fprintf( stderr, "\nCouldn't decompress input file (truncated data)!\n" );
+                exit( 1 );
+            }
+        }
+    }
+
+private:
+    ZSTD_DStream* m_ctx;
+    char* m_in;
+    ZSTD_inBuffer m_zin;
+    size_t m_res;
+    bool m_eof;
+};
+
+class GzipInputBuf : public InputBuf
+{
+public:
+    GzipInputBuf( FILE* f, uint64_t size ) : InputBuf( f, size ), m_in( new char[BufSize] ), m_eof( false ), m_memberEnd( false )
+    {
+        memset( &m_zs, 0, sizeof( m_zs ) );
+        // 15 bits of window, +32 to accept both gzip and zlib headers
+        inflateInit2( &m_zs, 15 + 32 );
+    }
+
+    ~GzipInputBuf() override
+    {
+        inflateEnd( &m_zs );
+        delete[] m_in;
+    }
+
+protected:
+    size_t Fill( char* dst, size_t size ) override
+    {
+        m_zs.next_out = (Bytef*)dst;
+        m_zs.avail_out = (uInt)size;
+        while( m_zs.avail_out == size )
+        {
+            if( m_zs.avail_in == 0 && !m_eof )
+            {
+                const auto sz = ReadFile( m_in, BufSize );
+                m_eof = sz == 0;
+                m_zs.next_in = (Bytef*)m_in;
+                m_zs.avail_in = (uInt)sz;
+            }
+            if( m_memberEnd )
+            {
+                // Either the end of input, or another gzip member follows
+                if( m_zs.avail_in == 0 ) break;
+                inflateReset( &m_zs );
+                m_memberEnd = false;
+            }
+            const auto res = inflate( &m_zs, Z_NO_FLUSH );
+            if( res == Z_STREAM_END )
+            {
+                m_memberEnd = true;
+            }
+            else if( res != Z_OK && !( res == Z_BUF_ERROR && !m_eof ) )
+            {
+                fprintf( stderr, "\nCouldn't decompress input file (%s)!\n", m_zs.msg ? m_zs.msg : "truncated data" );
+                exit( 1 );
+            }
+        }
+        return size - m_zs.avail_out;
+    }
+
+private:
+    z_stream m_zs;
+    char* m_in;
+    bool m_eof;
+    bool m_memberEnd;
+};
+
+// Deduplicated storage for the strings referenced by the parsed events. The events
+// themselves only keep 32-bit indices, so that they stay small until the trace is built.
+class StringPool
+{
+public:
+    StringPool() { Intern( std::string() ); }
+
+    uint32_t Intern( std::string&& str )
+    {
+        auto it = m_map.find( str );
+        if( it != m_map.end() ) return it->second;
+        const auto idx = uint32_t( m_data.size() );
+        m_data.emplace_back( std::move( str ) );
+        m_map.emplace( m_data.back(), idx );
+        return idx;
+    }
+
+    const std::string& operator[]( uint32_t idx ) const { return m_data[idx]; }
+
+private:
+    std::deque<std::string> m_data;
+    std::unordered_map<std::string_view, uint32_t> m_map;
+};
+
 void Usage()
 {
     printf( "Usage: import-chrome input.json output.tracy\n\n" );
+    printf( "The input file may be zstd or gzip compressed.\n\n" );
     printf( "The following chrome-tracing phases are supported:\n\n" );
     printf( "  b/B/e/E - Timeline events such as ZoneNamed\n" );
     printf( "  X - Timeline events such as ZoneNamed\n" );
@@ -55,89 +238,39 @@ int main( int argc, char** argv )
     const char* input = argv[1];
     const char* output = argv[2];
 
-    printf( "Loading...\r" );
-    fflush( stdout );
-
-    json j;
-
-    const auto fnsz = strlen( input );
-    if( fnsz > 4 && memcmp( input+fnsz-4, ".zst", 4 ) == 0 )
+    FILE* f = fopen( input, "rb" );
+    if( !f )
     {
-        FILE* f = fopen( input, "rb" );
-        if( !f )
-        {
-            fprintf( stderr, "Cannot open input file!\n" );
-            exit( 1 );
-        }
-        struct stat64 sb;
-        if( stat64( input, &sb ) != 0 )
-        {
-            fprintf( stderr, "Cannot open input file!\n" );
-            fclose( f );
-            exit( 1 );
-        }
-
-        const auto zsz = sb.st_size;
-        auto zbuf = (char*)mmap( nullptr, zsz, PROT_READ, MAP_SHARED, fileno( f ), 0 );
+        fprintf( stderr, "Cannot open input file!\n" );
+        exit( 1 );
+    }
+    struct stat64 sb;
+    if( stat64( input, &sb ) != 0 )
+    {
+        fprintf( stderr, "Cannot open input file!\n" );
         fclose( f );
-        if( !zbuf )
-        {
-            fprintf( stderr, "Cannot mmap input file!\n" );
-            exit( 1 );
-        }
-
-        auto zctx = ZSTD_createDStream();
-        ZSTD_initDStream( zctx );
-
-        enum { tmpSize = 64*1024 };
-        auto tmp = new char[tmpSize];
-
-        ZSTD_inBuffer_s zin = { zbuf, (size_t)zsz };
-        ZSTD_outBuffer_s zout = { tmp, (size_t)tmpSize };
-
-        std::vector<uint8_t> buf;
-        buf.reserve( 1024*1024 );
-
-        while( zin.pos < zin.size )
-        {
-            const auto res = ZSTD_decompressStream( zctx, &zout, &zin );
-            if( ZSTD_isError( res ) )
-            {
-                ZSTD_freeDStream( zctx );
-                delete[] tmp;
-                fprintf( stderr, "Couldn't decompress input file (%s)!\n", ZSTD_getErrorName( res ) );
-                exit( 1 );
-            }
-            if( zout.pos > 0 )
-            {
-                const auto bsz = buf.size();
-                buf.resize( bsz + zout.pos );
-                memcpy( buf.data() + bsz, tmp, zout.pos );
-                zout.pos = 0;
-            }
-        }
+        exit( 1 );
+    }
 
-        ZSTD_freeDStream( zctx );
-        delete[] tmp;
-        munmap( zbuf, zsz );
+    // Compressed inputs are recognized by their magic bytes, regardless of file extension
+    uint8_t magic[4] = {};
+    const auto msz = fread( magic, 1, sizeof( magic ), f );
+    fseek( f, 0, SEEK_SET );
 
-        j = json::parse( buf.begin(), buf.end() );
+    std::unique_ptr<InputBuf> buf;
+    if( msz == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD )
+    {
+        buf = std::make_unique<ZstdInputBuf>( f, sb.st_size );
+    }
+    else if( msz >= 2 && magic[0] == 0x1F && magic[1] == 0x8B )
+    {
+        buf = std::make_unique<GzipInputBuf>( f, sb.st_size );
     }
     else
     {
-        std::ifstream is( input );
-        if( !is.is_open() )
-        {
-            fprintf( stderr, "Cannot open input file!\n" );
-            exit( 1 );
-        }
-        is >> j;
-        is.close();
+        buf = std::make_unique<InputBuf>( f, sb.st_size );
     }
 
-    printf( "\33[2KParsing...\r" );
-    fflush( stdout );
-
     // encode a pair of "real pid, real tid" from a trace into a
     // pseudo thread ID living in the single namespace of Tracy threads.
     struct PidTidEncoder
@@ -147,9 +280,31 @@ int main( int argc, char** argv )
         uint64_t pseudo_tid; // fake thread id, unique within Tracy
     };
 
+    // Parsed events are kept in this compact form until they are sorted and passed to
+    // the worker. Strings are referenced through the string pool.
+    struct TimelineEvent
+    {
+        uint64_t tid;
+        uint64_t timestamp;
+        uint32_t name;
+        uint32_t text;
+        uint32_t locFile;
+        uint32_t locLine : 31;
+        uint32_t isEnd : 1;
+    };
+    static_assert( sizeof( TimelineEvent ) == 32 );
+
+    struct MessageEvent
+    {
+        uint64_t tid;
+        uint64_t timestamp;
+        uint32_t message;
+    };
+
+    StringPool strings;
     std::vector<PidTidEncoder> tid_encoders;
-    std::vector<tracy::Worker::ImportEventTimeline> timeline;
-    std::vector<tracy::Worker::ImportEventMessages> messages;
+    std::vector<TimelineEvent> timeline;
+    std::vector<MessageEvent> messages;
     std::vector<tracy::Worker::ImportEventPlots> plots;
     std::unordered_map<uint64_t, std::string> threadNames;
 
@@ -180,19 +335,7 @@ int main( int argc, char** argv )
         }
     };
 
-    if( j.is_object() && j.contains( "traceEvents" ) )
-    {
-        j = j["traceEvents"];
-    }
-
-    if( !j.is_array() )
-    {
-        fprintf( stderr, "Input must be either an array of events or an object containing an array of events under \"traceEvents\" key.\n" );
-        exit( 1 );
-    }
-
-    for( auto& v : j )
-    {
+    const auto processEvent = [&](json& v) {
         const auto type = v["ph"].get<std::string>();
 
         std::string zoneText = "";
@@ -225,23 +368,25 @@ int main( int argc, char** argv )
 
         if( type == "b" || type == "B" )
         {
-            timeline.emplace_back( tracy::Worker::ImportEventTimeline {
+            timeline.emplace_back( TimelineEvent {
                 getPseudoTid(v),
                 uint64_t( v["ts"].get<double>() * 1000. ),
-                v["name"].get<std::string>(),
-                std::move(zoneText),
-                false,
-                std::move(locFile),
-                locLine
+                strings.Intern( v["name"].get<std::string>() ),
+                strings.Intern( std::move(zoneText) ),
+                strings.Intern( std::move(locFile) ),
+                locLine,
+                false
             } );
         }
         else if( type == "e" || type == "E" )
         {
-            timeline.emplace_back( tracy::Worker::ImportEventTimeline {
+            timeline.emplace_back( TimelineEvent {
                 getPseudoTid(v),
                 uint64_t( v["ts"].get<double>() * 1000. ),
-                "",
-                std::move(zoneText),
+                0,
+                0,
+                0,
+                0,
                 true
             } );
         }
@@ -250,16 +395,16 @@ int main( int argc, char** argv )
             const auto tid = getPseudoTid(v);
             const auto ts0 = uint64_t( v["ts"].get<double>() * 1000. );
             const auto ts1 = ts0 + uint64_t( v["dur"].get<double>() * 1000. );
-            const auto name = v["name"].get<std::string>();
-            timeline.emplace_back( tracy::Worker::ImportEventTimeline { tid, ts0, name, std::move(zoneText), false, std::move(locFile), locLine } );
-            timeline.emplace_back( tracy::Worker::ImportEventTimeline { tid, ts1, "", "", true } );
+            const auto name = strings.Intern( v["name"].get<std::string>() );
+            timeline.emplace_back( TimelineEvent { tid, ts0, name, strings.Intern( std::move(zoneText) ), strings.Intern( std::move(locFile) ), locLine, false } );
+            timeline.emplace_back( TimelineEvent { tid, ts1, 0, 0, 0, 0, true } );
         }
         else if( type == "i" || type == "I" )
         {
-            messages.emplace_back( tracy::Worker::ImportEventMessages {
+            messages.emplace_back( MessageEvent {
                 getPseudoTid(v),
                 uint64_t( v["ts"].get<double>() * 1000. ),
-                v["name"].get<std::string>()
+                strings.Intern( v["name"].get<std::string>() )
             } );
         }
         else if( type == "C" )
@@ -293,7 +438,7 @@ int main( int argc, char** argv )
                     }
 
                     plots.emplace_back( tracy::Worker::ImportEventPlots {
-                        std::move( metricName ),
+                        metricName,
                         formatting,
                         { dataPoint }
                     } );
@@ -308,8 +453,64 @@ int main( int argc, char** argv )
                 threadNames[tid] = v["args"]["name"].get<std::string>();
             }
         }
+    };
+
+    // The input is parsed in a single streaming pass. Each event is materialized on its own,
+    // handed to processEvent() and then discarded by the parser, so memory use does not depend
+    // on the size of the input document. Top-level keys other than "traceEvents" are dropped.
+    bool topObject = false;
+    const auto callback = [&]( int depth, json::parse_event_t event, json& parsed ) -> bool {
+        switch( event )
+        {
+        case json::parse_event_t::object_start:
+            if( depth == 0 ) topObject = true;
+            break;
+        case json::parse_event_t::key:
+            if( depth == 1 && topObject ) return parsed == "traceEvents";
+            break;
+        case json::parse_event_t::object_end:
+            if( depth == ( topObject ? 2 : 1 ) )
+            {
+                processEvent( parsed );
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    };
+
+    json j;
+    {
+        std::istream is( buf.get() );
+        try
+        {
+            j = json::parse( is, callback );
+        }
+        catch( const json::exception& e )
+        {
+            fprintf( stderr, "\nCannot parse input file: %s\n", e.what() );
+            exit( 1 );
+        }
+    }
+    buf.reset();
+
+    // All events were already consumed, only the empty event list container remains
+    if( j.is_object() && j.contains( "traceEvents" ) )
+    {
+        j = j["traceEvents"];
     }
 
+    if( !j.is_array() )
+    {
+        fprintf( stderr, "\nInput must be either an array of events or an object containing an array of events under \"traceEvents\" key.\n" );
+        exit( 1 );
+    }
+
+    printf( "\33[2KSorting...\r" );
+    fflush( stdout );
+
     std::stable_sort( timeline.begin(), timeline.end(), [] ( const auto& l, const auto& r ) { return l.timestamp < r.timestamp; } );
     std::stable_sort( messages.begin(), messages.end(), [] ( const auto& l, const auto& r ) { return l.timestamp < r.timestamp; } );
     for( auto& v : plots ) std::stable_sort( v.data.begin(), v.data.end(), [] ( const auto& l, const auto& r ) { return l.first < r.first; } );
@@ -327,8 +528,6 @@ int main( int argc, char** argv )
     {
         if( mts > plot.data[0].first ) mts = plot.data[0].first;
     }
-    for( auto& v : timeline ) v.timestamp -= mts;
-    for( auto& v : messages ) v.timestamp -= mts;
     for( auto& plot : plots )
     {
         for( auto& v : plot.data ) v.first -= mts;
@@ -345,7 +544,42 @@ int main( int argc, char** argv )
         return out;
     };
 
-    tracy::Worker worker( getFilename(output), getFilename(input), timeline, messages, plots, threadNames );
+    // Events are expanded back to their full form in batches, as the worker consumes them
+    enum { BatchSize = 64*1024 };
+
+    tracy::Worker worker( getFilename(output), getFilename(input) );
+    {
+        std::vector<tracy::Worker::ImportEventTimeline> batch;
+        batch.reserve( std::min<size_t>( timeline.size(), BatchSize ) );
+        for( size_t i=0; i<timeline.size(); i+=BatchSize )
+        {
+            const auto end = std::min<size_t>( i + BatchSize, timeline.size() );
+            for( size_t j=i; j<end; j++ )
+            {
+                auto& v = timeline[j];
+                batch.emplace_back( tracy::Worker::ImportEventTimeline { v.tid, v.timestamp - mts, strings[v.name], strings[v.text], v.isEnd != 0, strings[v.locFile], v.locLine } );
+            }
+            worker.ImportTimeline( batch.data(), batch.size() );
+            batch.clear();
+        }
+    }
+    {
+        std::vector<tracy::Worker::ImportEventMessages> batch;
+        batch.reserve( std::min<size_t>( messages.size(), BatchSize ) );
+        for( size_t i=0; i<messages.size(); i+=BatchSize )
+        {
+            const auto end = std::min<size_t>( i + BatchSize, messages.size() );
+            for( size_t j=i; j<end; j++ )
+            {
+                auto& v = messages[j];
+                batch.emplace_back( tracy::Worker::ImportEventMessages { v.tid, v.timestamp - mts, strings[v.message] } );
+            }
+            worker.ImportMessages( batch.data(), batch.size() );
+            batch.clear();
+        }
+    }
+    for( auto& v : plots ) worker.ImportPlot( v );
+    worker.FinishImport( threadNames );
 
     auto w = std::unique_ptr<tracy::FileWrite>( tracy::FileWrite::Open( output, clev ) );
     if( !w )
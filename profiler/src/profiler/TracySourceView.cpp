@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <ctype.h>
 #include <inttypes.h>
 #include <nlohmann/json.hpp>
 #include <sstream>
 #include <stdio.h>
+#include <thread>
 
 #include <capstone.h>
 
@@ -21,12 +23,18 @@
 #include "TracyWorker.hpp"
 #include "tracy_pdqsort.h"
 #include "../Fonts.hpp"
+#include "../server/TracyTaskDispatch.hpp"
 
 #include "IconsFontAwesome6.h"
 
 namespace tracy
 {
 
+extern double s_time;
+
+constexpr size_t DisasmCacheSize = 64;
+constexpr size_t DisasmPrefetchSize = 32;
+
 struct MicroArchUx
 {
     const char* uArch;
@@ -578,6 +586,11 @@ static constexpr CpuIdMap s_cpuIdMap[] = {
     { 0, 0 }
 };
 
+SourceView::~SourceView()
+{
+    m_disasmTasks.reset();
+}
+
 void SourceView::SetCpuId( uint32_t cpuId )
 {
     auto ptr = s_cpuIdMap;
@@ -602,8 +615,8 @@ void SourceView::OpenSource( const char* fileName, int line, const View& view, c
     m_targetAddr = 0;
     m_baseAddr = 0;
     m_symAddr = 0;
-    m_sourceFiles.clear();
-    m_asm.clear();
+    CancelPendingDisassembly();
+    StoreDisassembly();
 
     ParseSource( fileName, worker, view );
     assert( !m_source.empty() );
@@ -615,17 +628,21 @@ void SourceView::OpenSymbol( const char* fileName, int line, uint64_t baseAddr,
     m_targetAddr = symAddr;
     m_baseAddr = baseAddr;
     m_symAddr = symAddr;
-    m_sourceFiles.clear();
+    CancelPendingDisassembly();
+    StoreDisassembly();
     m_selectedAddresses.clear();
     m_selectedAddresses.emplace( symAddr );
 
     ParseSource( fileName, worker, view );
     Disassemble( baseAddr, worker );
-    SelectLine( line, &worker, true, symAddr );
-
-    SelectViewMode();
-
-    if( !worker.GetInlineSymbolList( baseAddr, m_codeLen ) ) m_calcInlineStats = false;
+    if( m_disasmPending.symAddr != 0 )
+    {
+        m_disasmPending.line = line;
+    }
+    else
+    {
+        FinishOpenSymbol( line, worker );
+    }
 
     if( updateHistory )
     {
@@ -641,6 +658,15 @@ void SourceView::OpenSymbol( const char* fileName, int line, uint64_t baseAddr,
     }
 }
 
+void SourceView::FinishOpenSymbol( int line, Worker& worker )
+{
+    SelectLine( line, &worker, true, m_symAddr );
+
+    SelectViewMode();
+
+    if( !worker.GetInlineSymbolList( m_baseAddr, m_codeLen ) ) m_calcInlineStats = false;
+}
+
 void SourceView::SelectViewMode()
 {
     if( !m_source.empty() )
@@ -683,25 +709,47 @@ static bool IsJumpConditionalX86( const char* op )
 
 bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
 {
-    m_asm.clear();
-    m_locMap.clear();
-    m_jumpTable.clear();
-    m_jumpOut.clear();
+    StoreDisassembly();
     m_locationAddress.clear();
-    m_maxJumpLevel = 0;
     m_asmSelected = -1;
     m_asmCountBase = -1;
     m_asmWidth = 0;
     if( symAddr == 0 ) return false;
     m_cpuArch = worker.GetCpuArch();
     if( m_cpuArch == CpuArchUnknown ) return false;
+    auto disasm = FetchDisassembly( symAddr, worker );
+    if( !disasm ) return false;
+    return SetDisassembly( symAddr, std::move( disasm ) );
+}
+
+bool SourceView::SetDisassembly( uint64_t symAddr, std::unique_ptr<Disassembly>&& disasm )
+{
+    m_disasmAddr = symAddr;
+    m_codeLen = disasm->codeLen;
+    m_disasmFail = disasm->disasmFail;
+    m_asm = std::move( disasm->lines );
+    m_locMap = std::move( disasm->locMap );
+    m_jumpTable = std::move( disasm->jumpTable );
+    m_jumpOut = std::move( disasm->jumpOut );
+    m_sourceFiles = std::move( disasm->sourceFiles );
+    m_maxJumpLevel = disasm->maxJumpLevel;
+    m_maxLine = disasm->maxLine;
+    m_maxMnemonicLen = disasm->maxMnemonicLen;
+    m_maxOperandLen = disasm->maxOperandLen;
+    m_maxAsmBytes = disasm->maxAsmBytes;
+    ResetAsm();
+    return true;
+}
+
+std::unique_ptr<SourceView::Disassembly> SourceView::DisassembleSymbol( uint64_t symAddr, const Worker& worker )
+{
+    const auto cpuArch = worker.GetCpuArch();
     uint32_t len;
     auto code = worker.GetSymbolCode( symAddr, len );
-    if( !code ) return false;
-    m_disasmFail = -1;
+    if( !code ) return nullptr;
     csh handle;
     cs_err rval = CS_ERR_ARCH;
-    switch( m_cpuArch )
+    switch( cpuArch )
     {
     case CpuArchX86:
         rval = cs_open( CS_ARCH_X86, CS_MODE_32, &handle );
@@ -719,18 +767,28 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
         assert( false );
         break;
     }
-    if( rval != CS_ERR_OK ) return false;
+    if( rval != CS_ERR_OK ) return nullptr;
+    auto disasm = std::make_unique<Disassembly>();
+    disasm->cpuArch = cpuArch;
+    disasm->codeLen = len;
+    disasm->disasmFail = -1;
+    disasm->maxJumpLevel = 0;
+    disasm->maxLine = 0;
+    disasm->maxMnemonicLen = 0;
+    disasm->maxOperandLen = 0;
+    disasm->maxAsmBytes = 0;
+    Tokenizer tokenizer;
     cs_option( handle, CS_OPT_DETAIL, CS_OPT_ON );
     cs_option( handle, CS_OPT_SYNTAX, CS_OPT_SYNTAX_INTEL );
     cs_insn* insn;
     size_t cnt = cs_disasm( handle, (const uint8_t*)code, len, symAddr, 0, &insn );
     if( cnt > 0 )
     {
-        if( insn[cnt-1].address - symAddr + insn[cnt-1].size < len ) m_disasmFail = insn[cnt-1].address - symAddr;
+        if( insn[cnt-1].address - symAddr + insn[cnt-1].size < len ) disasm->disasmFail = insn[cnt-1].address - symAddr;
         int bytesMax = 0;
         int mLenMax = 0;
         int oLenMax = 0;
-        m_asm.reserve( cnt );
+        disasm->lines.reserve( cnt );
         for( size_t i=0; i<cnt; i++ )
         {
             const auto& op = insn[i];
@@ -761,7 +819,7 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
             uint64_t jumpAddr = 0;
             if( hasJump )
             {
-                switch( m_cpuArch )
+                switch( cpuArch )
                 {
                 case CpuArchX86:
                 case CpuArchX64:
@@ -794,10 +852,10 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
                     {
                         const auto min = std::min( jumpAddr, op.address );
                         const auto max = std::max( jumpAddr, op.address );
-                        auto it = m_jumpTable.find( jumpAddr );
-                        if( it == m_jumpTable.end() )
+                        auto it = disasm->jumpTable.find( jumpAddr );
+                        if( it == disasm->jumpTable.end() )
                         {
-                            m_jumpTable.emplace( jumpAddr, JumpData { min, max, 0, { op.address } } );
+                            disasm->jumpTable.emplace( jumpAddr, JumpData { min, max, 0, { op.address } } );
                         }
                         else
                         {
@@ -813,11 +871,11 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
                 }
                 else
                 {
-                    m_jumpOut.emplace( op.address );
+                    disasm->jumpOut.emplace( op.address );
                 }
             }
             std::vector<AsmOpParams> params;
-            switch( m_cpuArch )
+            switch( cpuArch )
             {
             case CpuArchX86:
             case CpuArchX64:
@@ -891,7 +949,7 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
                 break;
             }
             LeaData leaData = LeaData::none;
-            if( ( m_cpuArch == CpuArchX64 || m_cpuArch == CpuArchX86 ) && op.id == X86_INS_LEA )
+            if( ( cpuArch == CpuArchX64 || cpuArch == CpuArchX86 ) && op.id == X86_INS_LEA )
             {
                 assert( op.detail->x86.op_count == 2 );
                 assert( op.detail->x86.operands[1].type == X86_OP_MEM );
@@ -923,17 +981,17 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
                     }
                 }
             }
-            m_asm.emplace_back( AsmLine { op.address, jumpAddr, op.mnemonic, op.op_str, (uint8_t)op.size, leaData, opType, jumpConditional, std::move( params ) } );
-            const auto& operands = m_asm.back().operands;
-            m_asm.back().opTokens = m_tokenizer.TokenizeAsm( operands.c_str(), operands.c_str() + operands.size() );
+            disasm->lines.emplace_back( AsmLine { op.address, jumpAddr, op.mnemonic, op.op_str, (uint8_t)op.size, leaData, opType, jumpConditional, std::move( params ) } );
+            const auto& operands = disasm->lines.back().operands;
+            disasm->lines.back().opTokens = tokenizer.TokenizeAsm( operands.c_str(), operands.c_str() + operands.size() );
 
 #if CS_API_MAJOR >= 4
-            auto& entry = m_asm.back();
+            auto& entry = disasm->lines.back();
             cs_regs read, write;
             uint8_t rcnt, wcnt;
             cs_regs_access( handle, &op, read, &rcnt, write, &wcnt );
             int idx;
-            switch( m_cpuArch )
+            switch( cpuArch )
             {
             case CpuArchX86:
             case CpuArchX64:
@@ -970,18 +1028,18 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
             {
                 if( srcline > mLineMax ) mLineMax = srcline;
                 const auto idx = srcidx.Idx();
-                auto sit = m_sourceFiles.find( idx );
-                if( sit == m_sourceFiles.end() ) m_sourceFiles.emplace( idx, srcline );
+                auto sit = disasm->sourceFiles.find( idx );
+                if( sit == disasm->sourceFiles.end() ) disasm->sourceFiles.emplace( idx, srcline );
             }
             char tmp[16];
             sprintf( tmp, "%" PRIu32, mLineMax );
-            m_maxLine = strlen( tmp ) + 1;
+            disasm->maxLine = strlen( tmp ) + 1;
         }
         cs_free( insn, cnt );
-        m_maxMnemonicLen = mLenMax + 1;
-        m_maxOperandLen = oLenMax + 1;
-        m_maxAsmBytes = bytesMax;
-        if( !m_jumpTable.empty() )
+        disasm->maxMnemonicLen = mLenMax + 1;
+        disasm->maxOperandLen = oLenMax + 1;
+        disasm->maxAsmBytes = bytesMax;
+        if( !disasm->jumpTable.empty() )
         {
             struct JumpRange
             {
@@ -989,8 +1047,8 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
                 uint64_t len;
             };
             std::vector<JumpRange> jumpRange;
-            jumpRange.reserve( m_jumpTable.size() );
-            for( auto& v : m_jumpTable )
+            jumpRange.reserve( disasm->jumpTable.size() );
+            for( auto& v : disasm->jumpTable )
             {
                 pdqsort_branchless( v.second.source.begin(), v.second.source.end() );
                 jumpRange.emplace_back( JumpRange { v.first, v.second.max - v.second.min } );
@@ -999,8 +1057,8 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
             std::vector<std::vector<std::pair<uint64_t, uint64_t>>> levelRanges;
             for( auto& v : jumpRange )
             {
-                auto it = m_jumpTable.find( v.target );
-                assert( it != m_jumpTable.end() );
+                auto it = disasm->jumpTable.find( v.target );
+                assert( it != disasm->jumpTable.end() );
                 size_t level = 0;
                 for(;;)
                 {
@@ -1033,23 +1091,162 @@ bool SourceView::Disassemble( uint64_t symAddr, const Worker& worker )
                         level++;
                     }
                 }
-                if( level > m_maxJumpLevel ) m_maxJumpLevel = level;
+                if( level > disasm->maxJumpLevel ) disasm->maxJumpLevel = level;
             }
 
             uint32_t locNum = 0;
-            for( auto& v : m_asm )
+            for( auto& v : disasm->lines )
             {
-                if( m_jumpTable.find( v.addr ) != m_jumpTable.end() )
+                if( disasm->jumpTable.find( v.addr ) != disasm->jumpTable.end() )
                 {
-                    m_locMap.emplace( v.addr, locNum++ );
+                    disasm->locMap.emplace( v.addr, locNum++ );
                 }
             }
         }
     }
     cs_close( &handle );
-    m_codeLen = len;
-    ResetAsm();
-    return true;
+    return disasm;
+}
+
+
+// Instruction operand tokens point into the line strings, so the decoded lines are only ever
+// moved between the cache and the view, never copied. A symbol of a loaded trace that is not
+// cached is disassembled by a task, and nullptr is returned with m_disasmPending set.
+std::unique_ptr<SourceView::Disassembly> SourceView::FetchDisassembly( uint64_t symAddr, const Worker& worker )
+{
+    // Symbol data of a live capture may still change, and may only be read under the data lock
+    // held by the UI thread.
+    if( worker.IsConnected() ) return DisassembleSymbol( symAddr, worker );
+    {
+        std::lock_guard<std::mutex> lock( m_disasmLock );
+        for( auto it = m_disasmCache.begin(); it != m_disasmCache.end(); ++it )
+        {
+            if( it->first == symAddr )
+            {
+                auto disasm = std::move( it->second );
+                m_disasmCache.erase( it );
+                return disasm;
+            }
+        }
+        assert( m_disasmPending.symAddr == 0 );
+        m_disasmPending.symAddr = symAddr;
+        m_disasmPending.done = false;
+    }
+    // Queued tasks are taken from the back, so this one runs before the prefetched symbols.
+    GetDisasmTasks().Queue( [this, symAddr, &worker] {
+        auto disasm = DisassembleSymbol( symAddr, worker );
+        {
+            std::lock_guard<std::mutex> lock( m_disasmLock );
+            if( m_disasmPending.symAddr == symAddr && !m_disasmPending.done )
+            {
+                m_disasmPending.disasm = std::move( disasm );
+                m_disasmPending.done = true;
+                return;
+            }
+        }
+        if( disasm ) CacheDisassembly( symAddr, std::move( disasm ) );
+    } );
+    return nullptr;
+}
+
+// A finished disassembly that is no longer wanted is kept in the cache.
+void SourceView::CancelPendingDisassembly()
+{
+    if( m_disasmPending.symAddr == 0 ) return;
+    std::unique_ptr<Disassembly> disasm;
+    uint64_t symAddr;
+    {
+        std::lock_guard<std::mutex> lock( m_disasmLock );
+        symAddr = m_disasmPending.symAddr;
+        disasm = std::move( m_disasmPending.disasm );
+        m_disasmPending.symAddr = 0;
+        m_disasmPending.done = false;
+    }
+    if( disasm ) CacheDisassembly( symAddr, std::move( disasm ) );
+}
+
+TaskDispatch& SourceView::GetDisasmTasks()
+{
+    if( !m_disasmTasks ) m_disasmTasks = std::make_unique<TaskDispatch>( std::clamp( std::thread::hardware_concurrency() / 2, 1u, 4u ), "Disasm" );
+    return *m_disasmTasks;
+}
+
+void SourceView::StoreDisassembly()
+{
+    if( m_disasmAddr != 0 )
+    {
+        auto disasm = std::make_unique<Disassembly>();
+        disasm->cpuArch = m_cpuArch;
+        disasm->codeLen = m_codeLen;
+        disasm->disasmFail = m_disasmFail;
+        disasm->lines = std::move( m_asm );
+        disasm->locMap = std::move( m_locMap );
+        disasm->jumpTable = std::move( m_jumpTable );
+        disasm->jumpOut = std::move( m_jumpOut );
+        disasm->sourceFiles = std::move( m_sourceFiles );
+        disasm->maxJumpLevel = m_maxJumpLevel;
+        disasm->maxLine = m_maxLine;
+        disasm->maxMnemonicLen = m_maxMnemonicLen;
+        disasm->maxOperandLen = m_maxOperandLen;
+        disasm->maxAsmBytes = m_maxAsmBytes;
+        CacheDisassembly( m_disasmAddr, std::move( disasm ) );
+        m_disasmAddr = 0;
+    }
+    m_asm.clear();
+    m_locMap.clear();
+    m_jumpTable.clear();
+    m_jumpOut.clear();
+    m_sourceFiles.clear();
+    m_maxJumpLevel = 0;
+    m_addrStatValid = false;
+}
+
+void SourceView::CacheDisassembly( uint64_t symAddr, std::unique_ptr<Disassembly>&& disasm )
+{
+    std::lock_guard<std::mutex> lock( m_disasmLock );
+    for( auto it = m_disasmCache.begin(); it != m_disasmCache.end(); ++it )
+    {
+        if( it->first == symAddr )
+        {
+            m_disasmCache.erase( it );
+            break;
+        }
+    }
+    m_disasmCache.emplace_front( symAddr, std::move( disasm ) );
+    if( m_disasmCache.size() > DisasmCacheSize ) m_disasmCache.pop_back();
+}
+
+void SourceView::Prefetch( const Worker& worker )
+{
+#ifndef TRACY_NO_STATISTICS
+    if( worker.GetCpuArch() == CpuArchUnknown ) return;
+
+    std::vector<std::pair<uint64_t, uint32_t>> symbols;
+    for( auto& v : worker.GetSymbolStats() )
+    {
+        if( v.second.excl == 0 ) continue;
+        uint32_t len;
+        if( worker.GetSymbolCode( v.first, len ) ) symbols.emplace_back( v.first, v.second.excl );
+    }
+    if( symbols.empty() ) return;
+    const auto num = std::min<size_t>( symbols.size(), DisasmPrefetchSize );
+    std::partial_sort( symbols.begin(), symbols.begin() + num, symbols.end(), [] ( const auto& l, const auto& r ) { return l.second > r.second; } );
+
+    auto& tasks = GetDisasmTasks();
+    // Queued tasks are taken from the back.
+    for( size_t i=num; i>0; i-- )
+    {
+        const auto symAddr = symbols[i-1].first;
+        tasks.Queue( [this, symAddr, &worker] {
+            {
+                std::lock_guard<std::mutex> lock( m_disasmLock );
+                for( auto& v : m_disasmCache ) if( v.first == symAddr ) return;
+            }
+            auto disasm = DisassembleSymbol( symAddr, worker );
+            if( disasm ) CacheDisassembly( symAddr, std::move( disasm ) );
+        } );
+    }
+#endif
 }
 
 void SourceView::Render( Worker& worker, View& view )
@@ -1058,6 +1255,35 @@ void SourceView::Render( Worker& worker, View& view )
     m_hoveredLine.Decay( 0 );
     m_hoveredSource.Decay( 0 );
 
+    if( m_disasmPending.symAddr != 0 )
+    {
+        const auto symAddr = m_disasmPending.symAddr;
+        std::unique_ptr<Disassembly> disasm;
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock( m_disasmLock );
+            done = m_disasmPending.done;
+            if( done )
+            {
+                disasm = std::move( m_disasmPending.disasm );
+                m_disasmPending.symAddr = 0;
+                m_disasmPending.done = false;
+            }
+        }
+        if( !done )
+        {
+            ImGui::PushFont( g_fonts.normal, FontBig );
+            ImGui::Dummy( ImVec2( 0, ( ImGui::GetContentRegionAvail().y - ImGui::GetTextLineHeight() * 2 ) * 0.5f ) );
+            TextCentered( ICON_FA_HOURGLASS );
+            TextCentered( "Disassembling..." );
+            DrawWaitingDots( s_time );
+            ImGui::PopFont();
+            return;
+        }
+        if( disasm ) SetDisassembly( symAddr, std::move( disasm ) );
+        FinishOpenSymbol( m_disasmPending.line, worker );
+    }
+
     if( m_symAddr == 0 )
     {
         ImGui::PushFont( g_fonts.normal, FontBig );
@@ -1445,42 +1671,66 @@ void SourceView::RenderSymbolView( Worker& worker, View& view )
         ImGui::RadioButton( "Assembly", &m_displayMode, DisplayAsm );
     }
 
-    AddrStatData as;
-    if( m_cost == CostType::SampleCount )
+    // Sample attribution of a loaded trace only depends on the view settings.
+    AddrStatKey key;
+    key.fileName = m_source.filename();
+    key.symAddr = m_symAddr;
+    key.baseAddr = m_baseAddr;
+    key.limitView = limitView;
+    if( limitView )
     {
-        if( m_calcInlineStats )
-        {
-            GatherIpStats( m_symAddr, as, worker, limitView, view );
-            GatherAdditionalIpStats( m_symAddr, as, worker, limitView, view );
-        }
-        else
+        key.rangeMin = view.m_statRange.min;
+        key.rangeMax = view.m_statRange.max;
+    }
+    key.samples = worker.GetCallstackSampleCount();
+    key.cost = m_cost;
+    key.calcInlineStats = m_calcInlineStats;
+    key.propagateInlines = m_propagateInlines;
+    key.hwSamplesRelative = m_hwSamplesRelative;
+    key.samplesReady = worker.AreSymbolSamplesReady();
+    if( !m_addrStatValid || worker.IsConnected() || key != m_addrStatKey )
+    {
+        m_addrStat = AddrStatData {};
+        m_addrStatKey = key;
+        m_addrStatValid = true;
+        auto& as = m_addrStat;
+        if( m_cost == CostType::SampleCount )
         {
-            GatherIpStats( m_baseAddr, as, worker, limitView, view );
-            auto iptr = worker.GetInlineSymbolList( m_baseAddr, m_codeLen );
-            if( iptr )
+            if( m_calcInlineStats )
+            {
+                GatherIpStats( m_symAddr, as, worker, limitView, view );
+                GatherAdditionalIpStats( m_symAddr, as, worker, limitView, view );
+            }
+            else
             {
-                const auto symEnd = m_baseAddr + m_codeLen;
-                while( *iptr < symEnd )
+                GatherIpStats( m_baseAddr, as, worker, limitView, view );
+                auto iptr = worker.GetInlineSymbolList( m_baseAddr, m_codeLen );
+                if( iptr )
                 {
-                    GatherIpStats( *iptr, as, worker, limitView, view );
-                    iptr++;
+                    const auto symEnd = m_baseAddr + m_codeLen;
+                    while( *iptr < symEnd )
+                    {
+                        GatherIpStats( *iptr, as, worker, limitView, view );
+                        iptr++;
+                    }
                 }
+                GatherAdditionalIpStats( m_baseAddr, as, worker, limitView, view );
             }
-            GatherAdditionalIpStats( m_baseAddr, as, worker, limitView, view );
+        }
+        else
+        {
+            GatherIpHwStats( as, worker, view, m_cost );
+        }
+        if( !m_calcInlineStats )
+        {
+            as.ipTotalSrc = as.ipTotalAsm;
+        }
+        if( m_hwSamplesRelative )
+        {
+            CountHwStats( as, worker, view );
         }
     }
-    else
-    {
-        GatherIpHwStats( as, worker, view, m_cost );
-    }
-    if( !m_calcInlineStats )
-    {
-        as.ipTotalSrc = as.ipTotalAsm;
-    }
-    if( m_hwSamplesRelative )
-    {
-        CountHwStats( as, worker, view );
-    }
+    const auto& as = m_addrStat;
     const auto samplesReady = worker.AreSymbolSamplesReady();
     if( ( as.ipTotalAsm.local + as.ipTotalAsm.ext ) > 0 || ( view.m_statRange.active && worker.GetSamplesForSymbol( m_baseAddr ) ) )
     {
@@ -2,6 +2,9 @@
 #define __TRACYSOURCEVIEW_HPP__
 
 #include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -20,6 +23,7 @@ struct ImVec2;
 namespace tracy
 {
 
+class TaskDispatch;
 class View;
 class Worker;
 struct CallstackFrameData;
@@ -122,6 +126,24 @@ private:
         std::vector<uint64_t> source;
     };
 
+    // Decoded instruction stream of a symbol, along with everything derived from it.
+    struct Disassembly
+    {
+        CpuArchitecture cpuArch;
+        uint32_t codeLen;
+        int32_t disasmFail;
+        std::vector<AsmLine> lines;
+        unordered_flat_map<uint64_t, uint32_t> locMap;
+        unordered_flat_map<uint64_t, JumpData> jumpTable;
+        unordered_flat_set<uint64_t> jumpOut;
+        unordered_flat_map<uint32_t, uint32_t> sourceFiles;
+        size_t maxJumpLevel;
+        uint32_t maxLine;
+        int maxMnemonicLen;
+        int maxOperandLen;
+        uint8_t maxAsmBytes;
+    };
+
     enum
     {
         DisplaySource,
@@ -154,6 +176,24 @@ private:
         unordered_flat_map<uint64_t, AddrStat> hwCountSrc, hwCountAsm;
     };
 
+    struct AddrStatKey
+    {
+        const char* fileName = nullptr;
+        uint64_t symAddr = 0;
+        uint64_t baseAddr = 0;
+        int64_t rangeMin = 0;
+        int64_t rangeMax = 0;
+        uint64_t samples = 0;
+        CostType cost = CostType::SampleCount;
+        bool limitView = false;
+        bool calcInlineStats = false;
+        bool propagateInlines = false;
+        bool hwSamplesRelative = false;
+        bool samplesReady = false;
+
+        bool operator==( const AddrStatKey& ) const = default;
+    };
+
     struct History
     {
         const char* fileName;
@@ -164,6 +204,7 @@ private:
 
 public:
     SourceView();
+    ~SourceView();
 
     void SetCpuId( uint32_t cpuid );
 
@@ -172,11 +213,20 @@ public:
     void Render( Worker& worker, View& view );
 
     void CalcInlineStats( bool val ) { m_calcInlineStats = val; }
+    void Prefetch( const Worker& worker );
     bool IsSymbolView() const { return !m_asm.empty(); }
 
 private:
     void ParseSource( const char* fileName, const Worker& worker, const View& view );
+    void FinishOpenSymbol( int line, Worker& worker );
     bool Disassemble( uint64_t symAddr, const Worker& worker );
+    bool SetDisassembly( uint64_t symAddr, std::unique_ptr<Disassembly>&& disasm );
+    static std::unique_ptr<Disassembly> DisassembleSymbol( uint64_t symAddr, const Worker& worker );
+    std::unique_ptr<Disassembly> FetchDisassembly( uint64_t symAddr, const Worker& worker );
+    void StoreDisassembly();
+    void CacheDisassembly( uint64_t symAddr, std::unique_ptr<Disassembly>&& disasm );
+    void CancelPendingDisassembly();
+    TaskDispatch& GetDisasmTasks();
 
     void SelectViewMode();
 
@@ -296,6 +346,26 @@ private:
 
     std::vector<History> m_history;
     size_t m_historyCursor = 0;
+
+    // Most recently used first. The symbol currently displayed is not in the cache.
+    std::list<std::pair<uint64_t, std::unique_ptr<Disassembly>>> m_disasmCache;
+    std::mutex m_disasmLock;
+    std::unique_ptr<TaskDispatch> m_disasmTasks;
+    uint64_t m_disasmAddr = 0;
+
+    // Symbol opened while its disassembly is prepared by a disassembly task. symAddr is only
+    // changed by the UI thread, done and disasm are set by the task, all under m_disasmLock.
+    struct
+    {
+        uint64_t symAddr = 0;
+        int line = 0;
+        bool done = false;
+        std::unique_ptr<Disassembly> disasm;
+    } m_disasmPending;
+
+    AddrStatData m_addrStat;
+    AddrStatKey m_addrStatKey;
+    bool m_addrStatValid = false;
 };
 
 }
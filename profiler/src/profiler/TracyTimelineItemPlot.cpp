@@ -5,7 +5,6 @@
 #include "TracyUtility.hpp"
 #include "TracyView.hpp"
 #include "TracyWorker.hpp"
-#include "tracy_pdqsort.h"
 
 namespace tracy
 {
@@ -137,7 +136,7 @@ void TimelineItemPlot::Preprocess( const TimelineContext& ctx, TaskDispatch& td,
         const auto MinVisNs = int64_t( round( MinVisSize * nspx ) );
 
         auto& vec = m_plot->data;
-        vec.ensure_sorted();
+        m_worker.UpdatePlotLod( *m_plot );
         if( vec.front().time.Val() > vEnd )
         {
             m_plot->rMin = 0;
@@ -165,23 +164,10 @@ void TimelineItemPlot::Preprocess( const TimelineContext& ctx, TaskDispatch& td,
         if( end != vec.end() ) end++;
         if( it != vec.begin() ) it--;
 
-        double min = it->val;
-        double max = it->val;
         const auto num = end - it;
-        if( num > 1000000 )
-        {
-            min = m_plot->min;
-            max = m_plot->max;
-        }
-        else
-        {
-            auto tmp = it;
-            while( ++tmp < end )
-            {
-                if( tmp->val < min ) min = tmp->val;
-                else if( tmp->val > max ) max = tmp->val;
-            }
-        }
+        const auto range = m_worker.GetPlotMinMax( *m_plot, it - vec.begin(), end - vec.begin() );
+        double min = vec[range.first].val;
+        double max = vec[range.second].val;
         if( min == max )
         {
             min--;
@@ -212,38 +198,14 @@ void TimelineItemPlot::Preprocess( const TimelineContext& ctx, TaskDispatch& td,
             }
             else
             {
-                // Sync with View::DrawPlot()!
-                constexpr int NumSamples = 256;
-                uint32_t samples[NumSamples];
-                uint32_t cnt = 0;
-                uint32_t offset = it - vec.begin();
-                if( rsz < NumSamples )
-                {
-                    for( cnt=0; cnt<rsz; cnt++ )
-                    {
-                        samples[cnt] = offset + cnt;
-                    }
-                }
-                else
-                {
-                    const auto skip = ( rsz + NumSamples - 1 ) / NumSamples;
-                    const auto limit = rsz / skip;
-                    for( cnt=0; cnt<limit; cnt++ )
-                    {
-                        samples[cnt] = offset + cnt * skip;
-                    }
-                    if( cnt == limit ) cnt--;
-                    samples[cnt++] = offset + rsz - 1;
-                }
+                const uint32_t offset = it - vec.begin();
+                const auto range = m_worker.GetPlotMinMax( *m_plot, offset, offset + rsz );
                 it = next;
 
-                pdqsort_branchless( samples, samples+cnt, [&vec] ( const auto& l, const auto& r ) { return vec[l].val < vec[r].val; } );
-
-                assert( rsz > 0 );
                 m_draw.emplace_back( rsz );
                 m_draw.emplace_back( offset );
-                m_draw.emplace_back( samples[0] );
-                m_draw.emplace_back( samples[cnt-1] );
+                m_draw.emplace_back( range.first );
+                m_draw.emplace_back( range.second );
             }
         }
     } );
@@ -17,6 +17,9 @@ namespace tracy
 constexpr float MinVisSize = 3;
 constexpr float MinCtxSize = 4;
 
+constexpr uint32_t ZoneLodMinSize = 16 * 1024;
+constexpr int64_t ZoneLodBase = 10 * 1000;
+
 
 TimelineItemThread::TimelineItemThread( View& view, Worker& worker, const ThreadData* thread )
     : TimelineItem( view, worker, thread, true )
@@ -316,7 +319,7 @@ void TimelineItemThread::Preprocess( const TimelineContext& ctx, TaskDispatch& t
         else
 #endif
         {
-            m_depth = PreprocessZoneLevel( ctx, m_thread->timeline, 0, visible, 0 );
+            m_depth = PreprocessZoneLevel( ctx, m_thread->timeline, -1, 0, visible, 0 );
         }
     } );
 
@@ -415,20 +418,78 @@ int TimelineItemThread::PreprocessGhostLevel( const TimelineContext& ctx, const
 }
 #endif
 
-int TimelineItemThread::PreprocessZoneLevel( const TimelineContext& ctx, const Vector<short_ptr<ZoneEvent>>& vec, int depth, bool visible, const uint32_t inheritedColor )
+int TimelineItemThread::PreprocessZoneLevel( const TimelineContext& ctx, const Vector<short_ptr<ZoneEvent>>& vec, int32_t child, int depth, bool visible, const uint32_t inheritedColor )
 {
     if( vec.is_magic() )
     {
-        return PreprocessZoneLevel<VectorAdapterDirect<ZoneEvent>>( ctx, *(Vector<ZoneEvent>*)( &vec ), depth, visible, inheritedColor );
+        return PreprocessZoneLevel<VectorAdapterDirect<ZoneEvent>>( ctx, *(Vector<ZoneEvent>*)( &vec ), child, depth, visible, inheritedColor );
     }
     else
     {
-        return PreprocessZoneLevel<VectorAdapterPointer<ZoneEvent>>( ctx, vec, depth, visible, inheritedColor );
+        return PreprocessZoneLevel<VectorAdapterPointer<ZoneEvent>>( ctx, vec, child, depth, visible, inheritedColor );
+    }
+}
+
+template<typename Adapter, typename V>
+const TimelineItemThread::ZoneLod& TimelineItemThread::GetZoneLod( const V& vec, int32_t child )
+{
+    Adapter a;
+    auto size = uint32_t( vec.size() );
+    while( size > 0 && !a(vec[size-1]).IsEndValid() ) size--;
+
+    auto it = m_zoneLod.find( child );
+    if( it != m_zoneLod.end() )
+    {
+        // Live captures keep appending zones, rebuild only after significant growth.
+        if( uint64_t( size ) * 4 < uint64_t( it->second.size ) * 5 ) return it->second;
+    }
+    else
+    {
+        it = m_zoneLod.emplace( child, ZoneLod {} ).first;
+    }
+
+    auto& lod = it->second;
+    lod.size = size;
+    lod.levels.clear();
+
+    // Each level is built from the previous one, but only levels that considerably reduce the
+    // amount of items to process are kept.
+    int64_t threshold = ZoneLodBase;
+    std::vector<ZoneLod::Span> prev;
+    prev.reserve( size );
+    for( uint32_t i=0; i<size; i++ )
+    {
+        auto& ev = a(vec[i]);
+        prev.emplace_back( ZoneLod::Span { ev.Start(), ev.End(), i, 1 } );
     }
+    while( prev.size() > 1 )
+    {
+        std::vector<ZoneLod::Span> spans;
+        for( auto& v : prev )
+        {
+            const bool small = v.count > 1 || v.end - v.start < threshold;
+            if( small && !spans.empty() )
+            {
+                auto& last = spans.back();
+                const bool lastSmall = last.count > 1 || last.end - last.start < threshold;
+                if( lastSmall && v.start - last.end < threshold )
+                {
+                    last.end = v.end;
+                    last.count += v.count;
+                    continue;
+                }
+            }
+            spans.emplace_back( v );
+        }
+        if( spans.size() * 4 <= size ) lod.levels.emplace_back( ZoneLod::Level { threshold, spans } );
+        prev = std::move( spans );
+        threshold *= 4;
+    }
+    return lod;
 }
 
 template<typename Adapter, typename V>
-int TimelineItemThread::PreprocessZoneLevel( const TimelineContext& ctx, const V& vec, int depth, bool visible, const uint32_t inheritedColor )
+int TimelineItemThread::PreprocessZoneLevel( const TimelineContext& ctx, const V& vec, int32_t child, int depth, bool visible, const uint32_t inheritedColor )
 {
     const auto vStart = ctx.vStart;
     const auto vEnd = ctx.vEnd;
@@ -447,6 +508,75 @@ int TimelineItemThread::PreprocessZoneLevel( const TimelineContext& ctx, const V
 
     int maxdepth = depth + 1;
 
+    auto ProcessZone = [&] ( const ZoneEvent& ev ) {
+        const auto hasChildren = ev.HasChildren();
+        auto currentInherited = inheritedColor;
+        auto childrenInherited = inheritedColor;
+        if( m_view.GetViewData().inheritParentColors )
+        {
+            uint32_t color = 0;
+            if( m_worker.HasZoneExtra( ev ) )
+            {
+                const auto& extra = m_worker.GetZoneExtra( ev );
+                color = extra.color.Val();
+            }
+            if( color == 0 )
+            {
+                auto& srcloc = m_worker.GetSourceLocation( ev.SrcLoc() );
+                color = srcloc.color;
+            }
+            if( color != 0 )
+            {
+                currentInherited = color | 0xFF000000;
+                if( hasChildren ) childrenInherited = DarkenColorSlightly( color );
+            }
+        }
+        if( hasChildren )
+        {
+            const auto d = PreprocessZoneLevel( ctx, m_worker.GetZoneChildren( ev.Child() ), ev.Child(), depth + 1, visible, childrenInherited );
+            if( d > maxdepth ) maxdepth = d;
+        }
+        if( visible ) m_draw.emplace_back( TimelineDraw { TimelineDrawType::Zone, uint16_t( depth ), (void**)&ev, 0, 0, currentInherited } );
+    };
+
+    if( size_t( zitend - it ) >= ZoneLodMinSize && MinVisNs >= ZoneLodBase )
+    {
+        const auto& lod = GetZoneLod<Adapter>( vec, child );
+        auto lit = std::upper_bound( lod.levels.begin(), lod.levels.end(), MinVisNs, [] ( const auto& l, const auto& r ) { return l < r.threshold; } );
+        if( lit != lod.levels.begin() && uint32_t( it - vec.begin() ) < lod.size )
+        {
+            // Merges done at a level with threshold below the minimum visible size are also valid
+            // at the current zoom, so the spans only need to be folded further.
+            const auto& spans = (lit-1)->spans;
+            auto sit = std::lower_bound( spans.begin(), spans.end(), vStart, [] ( const auto& l, const auto& r ) { return l.end < r; } );
+            const auto send = std::lower_bound( sit, spans.end(), vEnd, [] ( const auto& l, const auto& r ) { return l.start < r; } );
+            while( sit < send )
+            {
+                if( sit->count == 1 && sit->end - sit->start >= MinVisNs )
+                {
+                    ProcessZone( a(vec[sit->first]) );
+                    ++sit;
+                }
+                else
+                {
+                    auto& ev = a(vec[sit->first]);
+                    auto rend = sit->end;
+                    uint32_t num = sit->count;
+                    while( ++sit < send && ( sit->count > 1 || sit->end - sit->start < MinVisNs ) && sit->start - rend < MinVisNs )
+                    {
+                        rend = sit->end;
+                        num += sit->count;
+                    }
+                    if( visible ) m_draw.emplace_back( TimelineDraw { TimelineDrawType::Folded, uint16_t( depth ), (void**)&ev, rend, num, inheritedColor } );
+                }
+            }
+            if( send != spans.end() ) return maxdepth;
+            // Zones not yet covered by the summary are processed individually.
+            it = std::max( it, vec.begin() + lod.size );
+            if( it >= zitend ) return maxdepth;
+        }
+    }
+
     while( it < zitend )
     {
         auto& ev = a(*it);
@@ -471,34 +601,7 @@ int TimelineItemThread::PreprocessZoneLevel( const TimelineContext& ctx, const V
         }
         else
         {
-            const auto hasChildren = ev.HasChildren();
-            auto currentInherited = inheritedColor;
-            auto childrenInherited = inheritedColor;
-            if( m_view.GetViewData().inheritParentColors )
-            {
-                uint32_t color = 0;
-                if( m_worker.HasZoneExtra( ev ) )
-                {
-                    const auto& extra = m_worker.GetZoneExtra( ev );
-                    color = extra.color.Val();
-                }
-                if( color == 0 )
-                {
-                    auto& srcloc = m_worker.GetSourceLocation( ev.SrcLoc() );
-                    color = srcloc.color;
-                }
-                if( color != 0 )
-                {
-                    currentInherited = color | 0xFF000000;
-                    if( hasChildren ) childrenInherited = DarkenColorSlightly( color );
-                }
-            }
-            if( hasChildren )
-            {
-                const auto d = PreprocessZoneLevel( ctx, m_worker.GetZoneChildren( ev.Child() ), depth + 1, visible, childrenInherited );
-                if( d > maxdepth ) maxdepth = d;
-            }
-            if( visible ) m_draw.emplace_back( TimelineDraw { TimelineDrawType::Zone, uint16_t( depth ), (void**)&ev, 0, 0, currentInherited } );
+            ProcessZone( ev );
             ++it;
         }
     }
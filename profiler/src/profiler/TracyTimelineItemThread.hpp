@@ -35,13 +35,38 @@ protected:
     void Preprocess( const TimelineContext& ctx, TaskDispatch& td, bool visible, int yPos ) override;
 
 private:
+    // Zoomed-out summary of a zone vector. Each level collapses runs of zones shorter than the
+    // level threshold, separated by gaps shorter than the threshold, into a single span.
+    struct ZoneLod
+    {
+        struct Span
+        {
+            int64_t start;
+            int64_t end;
+            uint32_t first;
+            uint32_t count;
+        };
+
+        struct Level
+        {
+            int64_t threshold;
+            std::vector<Span> spans;
+        };
+
+        std::vector<Level> levels;
+        uint32_t size;
+    };
+
 #ifndef TRACY_NO_STATISTICS
     int PreprocessGhostLevel( const TimelineContext& ctx, const Vector<GhostZone>& vec, int depth, bool visible );
 #endif
-    int PreprocessZoneLevel( const TimelineContext& ctx, const Vector<short_ptr<ZoneEvent>>& vec, int depth, bool visible, const uint32_t inheritedColor );
+    int PreprocessZoneLevel( const TimelineContext& ctx, const Vector<short_ptr<ZoneEvent>>& vec, int32_t child, int depth, bool visible, const uint32_t inheritedColor );
+
+    template<typename Adapter, typename V>
+    int PreprocessZoneLevel( const TimelineContext& ctx, const V& vec, int32_t child, int depth, bool visible, const uint32_t inheritedColor );
 
     template<typename Adapter, typename V>
-    int PreprocessZoneLevel( const TimelineContext& ctx, const V& vec, int depth, bool visible, const uint32_t inheritedColor );
+    const ZoneLod& GetZoneLod( const V& vec, int32_t child );
 
     void PreprocessContextSwitches( const TimelineContext& ctx, const ContextSwitch& ctxSwitch, bool visible );
     void PreprocessSamples( const TimelineContext& ctx, const Vector<SampleData>& vec, bool visible, int yPos );
@@ -56,6 +81,7 @@ private:
     std::vector<TimelineDraw> m_draw;
     std::vector<MessagesDraw> m_msgDraw;
     std::vector<std::unique_ptr<LockDraw>> m_lockDraw;
+    unordered_flat_map<int32_t, ZoneLod> m_zoneLod;
     int m_depth;
     bool m_hasCtxSwitch;
     bool m_hasSamples;
@@ -120,6 +120,10 @@ View::~View()
     m_userData.SaveAnnotations( m_annotations );
     m_userData.SaveSourceSubstitutions( m_sourceSubstitutions );
 
+    m_compare.ResetEngine();
+    m_scheduler.ResetEngine();
+    m_lockContention.ResetEngine();
+    m_criticalPath.ResetEngine();
     if( m_compare.loadThread.joinable() ) m_compare.loadThread.join();
     if( m_saveThread.joinable() ) m_saveThread.join();
 
@@ -712,6 +716,13 @@ bool View::DrawImpl()
         m_uarchSet = true;
         m_sourceView->SetCpuId( m_worker.GetCpuId() );
     }
+#ifndef TRACY_NO_STATISTICS
+    if( !m_disasmPrefetch && m_staticView && m_worker.AreCallstackSamplesReady() )
+    {
+        m_disasmPrefetch = true;
+        m_sourceView->Prefetch( m_worker );
+    }
+#endif
     if( !m_userData.Valid() ) m_userData.Init( m_worker.GetCaptureProgram().c_str(), m_worker.GetCaptureTime() );
     if( m_saveThreadState.load( std::memory_order_acquire ) == SaveThreadState::NeedsJoin )
     {
@@ -933,6 +944,18 @@ bool View::DrawImpl()
         {
             m_showWaitStacks = true;
         }
+        if( ButtonDisablable( ICON_FA_TRAFFIC_LIGHT " Scheduler", !m_worker.HasContextSwitches() ) )
+        {
+            m_scheduler.show = true;
+        }
+        if( ButtonDisablable( ICON_FA_LOCK " Lock contention", m_worker.GetLockMap().empty() ) )
+        {
+            m_lockContention.show = true;
+        }
+        if( ButtonDisablable( ICON_FA_ROUTE " Critical path", m_worker.GetZoneCount() == 0 ) )
+        {
+            m_criticalPath.show = true;
+        }
         ImGui::EndPopup();
     }
     if( m_sscb )
@@ -1158,6 +1181,9 @@ bool View::DrawImpl()
     if( m_sampleParents.symAddr != 0 ) DrawSampleParents();
     if( m_showRanges ) DrawRanges();
     if( m_showWaitStacks ) DrawWaitStacks();
+    if( m_scheduler.show ) DrawScheduler();
+    if( m_lockContention.show ) DrawLockContention();
+    if( m_criticalPath.show ) DrawCriticalPath();
 #ifndef __EMSCRIPTEN__
     if( m_llm.m_show ) m_llm.Draw();
 #endif
@@ -1427,6 +1453,16 @@ void View::DrawSourceTooltip( const char* filename, uint32_t srcline, int before
     ImGui::PopStyleVar();
 }
 
+bool View::DrawAnalysisProgress( const AnalysisEngine& engine )
+{
+    if( engine.IsDone() ) return true;
+    ImGui::TextUnformatted( "Please wait, computing data..." );
+    DrawWaitingDots( s_time );
+    const auto total = engine.GetTotal();
+    if( total != 0 ) ImGui::ProgressBar( float( engine.GetProgress() ) / total, ImVec2( 200 * GetScale(), 0 ) );
+    return false;
+}
+
 bool View::Save( const char* fn, FileCompression comp, int zlevel, bool buildDict, int streams )
 {
     std::unique_ptr<FileWrite> f( FileWrite::Open( fn, comp, zlevel, streams ) );
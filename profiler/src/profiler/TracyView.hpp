@@ -23,7 +23,11 @@
 #include "TracyUserData.hpp"
 #include "TracyUtility.hpp"
 #include "TracyViewData.hpp"
+#include "../server/TracyCompare.hpp"
+#include "../server/TracyCriticalPath.hpp"
 #include "../server/TracyFileWrite.hpp"
+#include "../server/TracyLockAnalysis.hpp"
+#include "../server/TracySchedulerAnalysis.hpp"
 #include "../server/TracyTaskDispatch.hpp"
 #include "../server/TracyShortPtr.hpp"
 #include "../server/TracyWorker.hpp"
@@ -272,6 +276,7 @@ private:
     void DrawMemory();
     void DrawAllocList();
     void DrawCompare();
+    void DrawCompareRegressions();
     void DrawCallstackWindow();
     void DrawCallstackTable( uint32_t callstack, bool globalEntriesButton );
     void DrawMemoryAllocWindow();
@@ -287,6 +292,10 @@ private:
     void DrawRangeEntry( Range& range, const char* label, uint32_t color, const char* popupLabel, int id );
     void DrawSourceTooltip( const char* filename, uint32_t line, int before = 3, int after = 3, bool separateTooltip = true );
     void DrawWaitStacks();
+    bool DrawAnalysisProgress( const AnalysisEngine& engine );
+    void DrawScheduler();
+    void DrawLockContention();
+    void DrawCriticalPath();
     void DrawFlameGraph();
     void DrawFlameGraphHeader( uint64_t timespan );
     void DrawFlameGraphLevel( const std::vector<FlameGraphItem>& data, FlameGraphContext& ctx, int depth, bool samples );
@@ -294,6 +303,7 @@ private:
     void BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& data, const Vector<short_ptr<ZoneEvent>>& zones );
     void BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& data, const Vector<short_ptr<ZoneEvent>>& zones, const ContextSwitch* ctx );
     void BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& data, const Vector<SampleData>& samples );
+    void BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& data, const std::vector<std::pair<uint32_t, int64_t>>& stacks );
 
     void ListMemData( std::vector<const MemEvent*>& vec, const std::function<void(const MemEvent*)>& DrawAddress, int64_t startTime = -1, uint64_t pool = 0 );
 
@@ -370,9 +380,10 @@ private:
 #ifndef TRACY_NO_STATISTICS
     void FindZones();
     void FindZonesCompare();
+    void FindZoneText();
 #endif
 
-    std::vector<MemoryPage> GetMemoryPages() const;
+    std::vector<MemoryPage> GetMemoryPages();
 
     void SmallCallstackButton( const char* name, uint32_t callstack, int& idx, bool tooltip = true );
     void DrawCallstackCalls( uint32_t callstack, uint16_t limit ) const;
@@ -508,6 +519,9 @@ private:
     ImGuiTextFilter m_statisticsFilter;
     ImGuiTextFilter m_statisticsImageFilter;
     ImGuiTextFilter m_userTextFilter;
+    ImGuiTextFilter m_zoneTextFilter;
+    Vector<short_ptr<ZoneEvent>> m_zoneTextList;
+    bool m_zoneTextValid = false;
     unordered_flat_set<Worker::ZoneThreadData*> m_filteredZones;
 
     Region m_highlight;
@@ -578,6 +592,7 @@ private:
     std::unique_ptr<SourceView> m_sourceView;
     const char* m_sourceViewFile;
     bool m_uarchSet = false;
+    bool m_disasmPrefetch = false;
 
     float m_rootWidth, m_rootHeight;
     SetTitleCallback m_stcb;
@@ -636,6 +651,8 @@ private:
 
     unordered_flat_map<int16_t, StatisticsCache> m_statCache;
     unordered_flat_map<int16_t, StatisticsCache> m_gpuStatCache;
+    unordered_flat_map<uint64_t, SymbolCount> m_statSymbolCounts;
+    RangeSlim m_statSymbolCountsRange;
 
     unordered_flat_map<const void*, bool> m_visMap;
 
@@ -785,8 +802,46 @@ private:
         double v1;
     };
 
-    struct {
+    // Window showing the results of an analysis engine, which runs on its own thread. The
+    // engine may wait for the data lock, which is held while drawing, so the thread is only
+    // joined once the engine is done, or when the view is destroyed.
+    template<typename T>
+    struct AnalysisWindow
+    {
         bool show = false;
+        std::unique_ptr<T> engine;
+        std::thread engineThread;
+
+        void StartEngine( std::unique_ptr<T>&& analysis, const char* name )
+        {
+            engine = std::move( analysis );
+            engineThread = std::thread( [ptr = engine.get(), name] {
+#ifdef __EMSCRIPTEN__
+                TaskDispatch td( 1, name );
+#else
+                TaskDispatch td( std::thread::hardware_concurrency(), name );
+#endif
+                ptr->Process( td );
+            } );
+        }
+
+        // Returns true when the results have just become available.
+        bool JoinEngine()
+        {
+            if( !engineThread.joinable() ) return false;
+            engineThread.join();
+            return true;
+        }
+
+        void ResetEngine()
+        {
+            if( engine ) engine->Abort();
+            if( engineThread.joinable() ) engineThread.join();
+            engine.reset();
+        }
+    };
+
+    struct : public AnalysisWindow<TraceCompare> {
         bool ignoreCase = false;
         bool link = true;
         std::unique_ptr<Worker> second;
@@ -814,6 +869,7 @@ private:
         std::vector<const char*> thisUnique;
         std::vector<const char*> secondUnique;
         std::vector<std::pair<const char*, std::string>> diffs;
+        bool significantOnly = true;
 
         void ResetSelection()
         {
@@ -842,6 +898,27 @@ private:
         }
     } m_compare;
 
+    struct : public AnalysisWindow<SchedulerAnalysis> {
+        int mode = 0;
+    } m_scheduler;
+
+    struct : public AnalysisWindow<LockAnalysis> {
+        int mode = 0;
+    } m_lockContention;
+
+    struct : public AnalysisWindow<CriticalPath> {
+        int mode = 0;
+        int source = 0;
+        bool highlight = true;
+        unordered_flat_set<const ZoneEvent*> zones;
+
+        void ResetEngine()
+        {
+            AnalysisWindow<CriticalPath>::ResetEngine();
+            zones.clear();
+        }
+    } m_criticalPath;
+
     struct {
         bool show = false;
         char pattern[1024] = {};
@@ -850,6 +927,21 @@ private:
         bool showAllocList = false;
         std::vector<size_t> allocList;
         Range range;
+        bool atTime = false;
+        bool inRange = false;
+        int64_t time = 0;
+
+        struct {
+            uint64_t pool = 0;
+            uint64_t low = 0;
+            bool range = false;
+            int64_t min = 0;
+            int64_t max = 0;
+            uint32_t next = 0;
+            bool sorted = true;
+            unordered_flat_map<uint64_t, std::unique_ptr<uint32_t[]>> owners;
+            std::vector<uint64_t> pages;
+        } pageMap;
     } m_memInfo;
 
     struct {
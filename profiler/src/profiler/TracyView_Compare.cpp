@@ -304,8 +304,10 @@ void View::DrawCompare()
         ImGui::TextDisabled( "(%s)", m_compare.second->GetCaptureName().c_str() );
     }
 
-    if( ImGui::Button( ICON_FA_TRASH_CAN " Unload" ) )
+    // The regression engine may be waiting for the data lock held here, so it can't be joined now.
+    if( ButtonDisablable( ICON_FA_TRASH_CAN " Unload", m_compare.engine && !m_compare.engine->IsDone() ) )
     {
+        m_compare.ResetEngine();
         m_compare.Reset();
         m_compare.second.reset();
         m_compare.userData.reset();
@@ -323,12 +325,20 @@ void View::DrawCompare()
     ImGui::RadioButton( "Frames", &m_compare.compareMode, 1 );
     ImGui::SameLine();
     ImGui::RadioButton( "Source diff", &m_compare.compareMode, 2 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Regressions", &m_compare.compareMode, 3 );
     if( oldMode != m_compare.compareMode )
     {
         m_compare.Reset();
     }
 
-    if( m_compare.compareMode == 2 )
+    if( m_compare.compareMode == 3 )
+    {
+        ImGui::Separator();
+        ImGui::BeginChild( "##compare" );
+        DrawCompareRegressions();
+    }
+    else if( m_compare.compareMode == 2 )
     {
         ImGui::Separator();
         ImGui::BeginChild( "##compare" );
@@ -1303,4 +1313,168 @@ void View::DrawCompare()
     ImGui::End();
 }
 
+void View::DrawCompareRegressions()
+{
+#ifndef TRACY_NO_STATISTICS
+    if( !m_compare.engine ) m_compare.StartEngine( std::make_unique<TraceCompare>( m_worker, *m_compare.second ), "Compare" );
+    auto& engine = *m_compare.engine;
+    if( !DrawAnalysisProgress( engine ) ) return;
+    m_compare.JoinEngine();
+
+    SmallCheckbox( "Significant only", &m_compare.significantOnly );
+    ImGui::SameLine();
+    DrawHelpMarker( "Differences are tested with Mann-Whitney U test, significance level is p < 0.01.\nEffect size is Cliff's delta. Positive values mean this trace is slower than the external one." );
+
+    const auto& results = engine.GetResults();
+    std::vector<const TraceCompare::Result*> list;
+    list.reserve( results.size() );
+    for( auto& v : results )
+    {
+        if( !m_compare.significantOnly || v.pValue < 0.01 ) list.emplace_back( &v );
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled( "(%s matched zones)", RealToString( list.size() ) );
+
+    if( ImGui::BeginTable( "##regressions", 7, ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY ) )
+    {
+        ImGui::TableSetupScrollFreeze( 0, 1 );
+        ImGui::TableSetupColumn( "Name", ImGuiTableColumnFlags_NoHide );
+        ImGui::TableSetupColumn( "Location", ImGuiTableColumnFlags_DefaultHide );
+        ImGui::TableSetupColumn( "Total time delta", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+        ImGui::TableSetupColumn( "Mean delta", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+        ImGui::TableSetupColumn( "Median", ImGuiTableColumnFlags_WidthFixed );
+        ImGui::TableSetupColumn( "Effect", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+        ImGui::TableSetupColumn( "Counts", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+        ImGui::TableHeadersRow();
+
+        const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+        std::function<double(const TraceCompare::Result&)> key;
+        switch( sortspec.ColumnIndex )
+        {
+        case 0:
+        case 1:
+            key = nullptr;
+            break;
+        case 2:
+            key = []( const auto& v ) { return double( v.total[0] - v.total[1] ); };
+            break;
+        case 3:
+            key = []( const auto& v ) { return ( v.mean[0] - v.mean[1] ) / v.mean[1]; };
+            break;
+        case 4:
+            key = []( const auto& v ) { return double( v.median[0] - v.median[1] ); };
+            break;
+        case 5:
+            key = []( const auto& v ) { return v.effect; };
+            break;
+        case 6:
+            key = []( const auto& v ) { return double( v.count[0] + v.count[1] ); };
+            break;
+        default:
+            assert( false );
+            break;
+        }
+        const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+        if( key )
+        {
+            pdqsort_branchless( list.begin(), list.end(), [&key, asc]( const auto& lhs, const auto& rhs ) { return asc ? key( *lhs ) < key( *rhs ) : key( *lhs ) > key( *rhs ); } );
+        }
+        else if( sortspec.ColumnIndex == 0 )
+        {
+            pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                const auto cmp = strcmp( m_worker.GetZoneName( m_worker.GetSourceLocation( lhs->srcloc[0] ) ), m_worker.GetZoneName( m_worker.GetSourceLocation( rhs->srcloc[0] ) ) );
+                return asc ? cmp < 0 : cmp > 0;
+            } );
+        }
+        else
+        {
+            pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                const auto& sll = m_worker.GetSourceLocation( lhs->srcloc[0] );
+                const auto& slr = m_worker.GetSourceLocation( rhs->srcloc[0] );
+                auto cmp = strcmp( m_worker.GetString( sll.file ), m_worker.GetString( slr.file ) );
+                if( cmp == 0 ) cmp = int( sll.line ) - int( slr.line );
+                return asc ? cmp < 0 : cmp > 0;
+            } );
+        }
+
+        const auto slower = ImVec4( 0.8f, 0.1f, 0.1f, 1.0f );
+        const auto faster = ImVec4( 0.1f, 0.6f, 0.1f, 1.0f );
+
+        ImGuiListClipper clipper;
+        clipper.Begin( (int)list.size() );
+        while( clipper.Step() )
+        {
+            for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+            {
+                auto& v = *list[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID( i );
+                auto& srcloc = m_worker.GetSourceLocation( v.srcloc[0] );
+                const auto name = m_worker.GetZoneName( srcloc );
+                SmallColorBox( GetSrcLocColor( srcloc, 0 ) );
+                ImGui::SameLine();
+                if( ImGui::Selectable( name, false, ImGuiSelectableFlags_SpanAllColumns ) )
+                {
+                    m_compare.compareMode = 0;
+                    m_compare.Reset();
+                    const auto len = std::min<size_t>( strlen( name ), sizeof( m_compare.pattern ) - 1 );
+                    memcpy( m_compare.pattern, name, len );
+                    m_compare.pattern[len] = '\0';
+                    FindZonesCompare();
+                    for( int j=0; j<2; j++ )
+                    {
+                        auto it = std::find( m_compare.match[j].begin(), m_compare.match[j].end(), v.srcloc[j] );
+                        if( it != m_compare.match[j].end() ) m_compare.selMatch[j] = int( it - m_compare.match[j].begin() );
+                    }
+                }
+                if( v.match != TraceCompare::MatchExact && ImGui::IsItemHovered() )
+                {
+                    ImGui::BeginTooltip();
+                    ImGui::TextUnformatted( v.match == TraceCompare::MatchFile ? "Matched by name and source file" : "Matched by name only" );
+                    ImGui::EndTooltip();
+                }
+                ImGui::TableNextColumn();
+                TextDisabledUnformatted( LocationToString( m_worker.GetString( srcloc.file ), srcloc.line ) );
+                ImGui::TableNextColumn();
+                const auto dt = v.total[0] - v.total[1];
+                TextColoredUnformatted( dt > 0 ? slower : faster, TimeToString( dt ) );
+                ImGui::TableNextColumn();
+                ImGui::TextColored( v.mean[0] > v.mean[1] ? slower : faster, "%+.2f%%", 100. * ( v.mean[0] - v.mean[1] ) / v.mean[1] );
+                ImGui::TableNextColumn();
+                ImGui::Text( "%s / %s", TimeToString( v.median[0] ), TimeToString( v.median[1] ) );
+                if( ImGui::IsItemHovered() )
+                {
+                    ImGui::BeginTooltip();
+                    TextDisabledUnformatted( "P90:" );
+                    ImGui::SameLine();
+                    ImGui::Text( "%s / %s", TimeToString( v.p90[0] ), TimeToString( v.p90[1] ) );
+                    TextDisabledUnformatted( "P99:" );
+                    ImGui::SameLine();
+                    ImGui::Text( "%s / %s", TimeToString( v.p99[0] ), TimeToString( v.p99[1] ) );
+                    ImGui::EndTooltip();
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text( "%+.3f", v.effect );
+                if( ImGui::IsItemHovered() )
+                {
+                    ImGui::BeginTooltip();
+                    TextDisabledUnformatted( "p-value:" );
+                    ImGui::SameLine();
+                    ImGui::Text( "%g", v.pValue );
+                    TextDisabledUnformatted( "KS statistic:" );
+                    ImGui::SameLine();
+                    ImGui::Text( "%.3f", v.ks );
+                    ImGui::EndTooltip();
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text( "%s / %s", RealToString( v.count[0] ), RealToString( v.count[1] ) );
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndTable();
+    }
+#endif
+}
+
 }
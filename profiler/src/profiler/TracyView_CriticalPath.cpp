@@ -0,0 +1,340 @@
+#include <functional>
+#include <inttypes.h>
+#include <limits>
+
+#include "TracyImGui.hpp"
+#include "TracyMouse.hpp"
+#include "TracyPrint.hpp"
+#include "TracyView.hpp"
+#include "tracy_pdqsort.h"
+
+namespace tracy
+{
+
+void View::DrawCriticalPath()
+{
+    const auto scale = GetScale();
+    ImGui::SetNextWindowSize( ImVec2( 1000 * scale, 600 * scale ), ImGuiCond_FirstUseEver );
+    ImGui::Begin( "Critical path", &m_criticalPath.show, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse );
+    if( ImGui::GetCurrentWindowRead()->SkipItems ) { ImGui::End(); return; }
+
+    if( !m_criticalPath.engine )
+    {
+        if( m_criticalPath.source == 0 )
+        {
+            m_criticalPath.StartEngine( std::make_unique<CriticalPath>( m_worker, m_frames, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() ), "Critical path" );
+        }
+        else
+        {
+            m_criticalPath.StartEngine( std::make_unique<CriticalPath>( m_worker, nullptr, m_vd.zvStart, m_vd.zvEnd ), "Critical path" );
+        }
+    }
+
+    auto& engine = *m_criticalPath.engine;
+    if( !DrawAnalysisProgress( engine ) )
+    {
+        ImGui::End();
+        return;
+    }
+    if( m_criticalPath.JoinEngine() )
+    {
+        for( auto& v : engine.GetPath() )
+        {
+            if( v.zone ) m_criticalPath.zones.emplace( v.zone );
+        }
+    }
+
+    bool recompute = false;
+    TextDisabledUnformatted( "Source:" );
+    ImGui::SameLine();
+    recompute |= ImGui::RadioButton( "Frames", &m_criticalPath.source, 0 );
+    ImGui::SameLine();
+    recompute |= ImGui::RadioButton( "Visible range", &m_criticalPath.source, 1 );
+    ImGui::SameLine();
+    if( ImGui::Button( ICON_FA_ARROWS_ROTATE " Recompute" ) ) recompute = true;
+    ImGui::SameLine();
+    DrawHelpMarker( "The critical path is walked backwards from the thread which finished last. When a thread was waiting for a lock, the path continues in the thread which released the lock. When a thread was woken up by another thread, the path continues in the waking thread. In the frames mode, the path is computed for every frame of the active frame set, and the longest frame is shown in the path view." );
+    ImGui::RadioButton( "Path", &m_criticalPath.mode, 0 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Source locations", &m_criticalPath.mode, 1 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Threads", &m_criticalPath.mode, 2 );
+    ImGui::SameLine();
+    ImGui::Checkbox( "Highlight on timeline", &m_criticalPath.highlight );
+    if( recompute )
+    {
+        m_criticalPath.ResetEngine();
+        ImGui::End();
+        return;
+    }
+
+    char buf[64];
+    const auto totalTime = engine.GetTotalTime();
+    if( engine.GetFrames() )
+    {
+        TextFocused( "Frame set:", GetFrameSetName( *engine.GetFrames() ) );
+        ImGui::SameLine();
+        TextFocused( "Frames:", RealToString( engine.GetFrameCount() ) );
+        ImGui::SameLine();
+    }
+    TextFocused( "Total time:", TimeToString( totalTime ) );
+    ImGui::SameLine();
+    TextFocused( "Outside zones:", TimeToString( engine.GetUntrackedTime() ) );
+    if( totalTime != 0 )
+    {
+        ImGui::SameLine();
+        PrintStringPercent( buf, 100. * engine.GetUntrackedTime() / totalTime );
+        TextDisabledUnformatted( buf );
+    }
+    ImGui::Separator();
+
+    const auto flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY;
+    switch( m_criticalPath.mode )
+    {
+    case 0:
+    {
+        const auto& path = engine.GetPath();
+        const auto& segments = engine.GetSegments();
+        if( path.empty() )
+        {
+            ImGui::TextUnformatted( "No thread activity was found." );
+            break;
+        }
+        const auto pathTime = engine.GetPathEnd() - engine.GetPathStart();
+        if( engine.GetFrames() )
+        {
+            TextFocused( "Longest frame:", GetFrameText( *engine.GetFrames(), (int)engine.GetPathFrame(), pathTime ) );
+        }
+        else
+        {
+            TextFocused( "Range:", TimeToString( pathTime ) );
+        }
+        ImGui::SameLine();
+        if( ImGui::SmallButton( ICON_FA_MAGNIFYING_GLASS " Zoom" ) ) ZoomToRange( engine.GetPathStart(), engine.GetPathEnd() );
+
+        if( ImGui::BeginTable( "##criticalpath", 5, flags & ~ImGuiTableFlags_Sortable ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Zone", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Thread" );
+            ImGui::TableSetupColumn( "Via" );
+            ImGui::TableSetupColumn( "Start", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Time", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin( (int)path.size() );
+            while( clipper.Step() )
+            {
+                auto seg = std::lower_bound( segments.begin(), segments.end(), path[clipper.DisplayStart].start, []( const auto& l, int64_t r ) { return l.end <= r; } );
+                for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+                {
+                    auto& v = path[i];
+                    while( seg != segments.end() && seg->end <= v.start ) ++seg;
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID( i );
+                    if( v.zone )
+                    {
+                        SmallColorBox( GetSrcLocColor( m_worker.GetSourceLocation( v.zone->SrcLoc() ), 0 ) );
+                        ImGui::SameLine();
+                        if( ImGui::Selectable( m_worker.GetZoneName( *v.zone ), m_zoneInfoWindow == v.zone, ImGuiSelectableFlags_SpanAllColumns ) )
+                        {
+                            ShowZoneInfo( *v.zone );
+                        }
+                        if( ImGui::IsItemHovered() ) m_zoneHover = v.zone;
+                    }
+                    else
+                    {
+                        ImGui::PushStyleColor( ImGuiCol_Text, ImGui::GetStyle().Colors[ImGuiCol_TextDisabled] );
+                        ImGui::Selectable( "(outside zones)", false, ImGuiSelectableFlags_SpanAllColumns );
+                        ImGui::PopStyleColor();
+                    }
+                    if( ImGui::IsItemHovered() && IsMouseClicked( 2 ) ) ZoomToRange( v.start, v.end );
+                    ImGui::TableNextColumn();
+                    SmallColorBox( GetThreadColor( v.thread, 0 ) );
+                    ImGui::SameLine();
+                    ImGui::TextUnformatted( m_worker.GetThreadName( v.thread ) );
+                    ImGui::TableNextColumn();
+                    if( seg != segments.end() && seg->start == v.start && seg != segments.begin() )
+                    {
+                        switch( seg->edge )
+                        {
+                        case CriticalPath::Edge::Lock:
+                            ImGui::TextUnformatted( ICON_FA_LOCK );
+                            ImGui::SameLine();
+                            ImGui::Text( "Lock #%" PRIu32, seg->lock );
+                            break;
+                        case CriticalPath::Edge::Wakeup:
+                            ImGui::TextUnformatted( ICON_FA_BELL " Wakeup" );
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToStringExact( v.start ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.end - v.start ) );
+                    ImGui::SameLine();
+                    PrintStringPercent( buf, 100. * ( v.end - v.start ) / pathTime );
+                    TextDisabledUnformatted( buf );
+                    ImGui::PopID();
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 1:
+    {
+        const auto& srclocs = engine.GetSourceLocations();
+        std::vector<const CriticalPath::SrcLocResult*> list;
+        list.reserve( srclocs.size() );
+        for( auto& v : srclocs ) list.emplace_back( &v );
+
+        if( ImGui::BeginTable( "##criticalpathsrcloc", 5, flags ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Name", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Location", ImGuiTableColumnFlags_DefaultHide );
+            ImGui::TableSetupColumn( "Critical time", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Max per frame", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Frames", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+            std::function<int64_t(const CriticalPath::SrcLocResult&)> key;
+            switch( sortspec.ColumnIndex )
+            {
+            case 0:
+            case 1: key = nullptr; break;
+            case 2: key = []( const auto& v ) { return v.time; }; break;
+            case 3: key = []( const auto& v ) { return v.maxTime; }; break;
+            case 4: key = []( const auto& v ) { return int64_t( v.frames ); }; break;
+            default: assert( false ); break;
+            }
+            const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+            if( key )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [&key, asc]( const auto& lhs, const auto& rhs ) { return asc ? key( *lhs ) < key( *rhs ) : key( *lhs ) > key( *rhs ); } );
+            }
+            else if( sortspec.ColumnIndex == 0 )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto cmp = strcmp( m_worker.GetZoneName( m_worker.GetSourceLocation( lhs->srcloc ) ), m_worker.GetZoneName( m_worker.GetSourceLocation( rhs->srcloc ) ) );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+            else
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto& sll = m_worker.GetSourceLocation( lhs->srcloc );
+                    const auto& slr = m_worker.GetSourceLocation( rhs->srcloc );
+                    auto cmp = strcmp( m_worker.GetString( sll.file ), m_worker.GetString( slr.file ) );
+                    if( cmp == 0 ) cmp = int( sll.line ) - int( slr.line );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+
+            ImGuiListClipper clipper;
+            clipper.Begin( (int)list.size() );
+            while( clipper.Step() )
+            {
+                for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+                {
+                    auto& v = *list[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID( i );
+                    auto& srcloc = m_worker.GetSourceLocation( v.srcloc );
+                    const auto name = m_worker.GetZoneName( srcloc );
+                    SmallColorBox( GetSrcLocColor( srcloc, 0 ) );
+                    ImGui::SameLine();
+                    if( ImGui::Selectable( name, m_findZone.show && !m_findZone.match.empty() && m_findZone.match[m_findZone.selMatch] == v.srcloc, ImGuiSelectableFlags_SpanAllColumns ) )
+                    {
+                        m_findZone.ShowZone( v.srcloc, name );
+                    }
+                    if( ImGui::IsItemHovered() ) m_zoneSrcLocHighlight = v.srcloc;
+                    ImGui::TableNextColumn();
+                    TextDisabledUnformatted( LocationToString( m_worker.GetString( srcloc.file ), srcloc.line ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.time ) );
+                    if( totalTime != 0 )
+                    {
+                        ImGui::SameLine();
+                        PrintStringPercent( buf, 100. * v.time / totalTime );
+                        TextDisabledUnformatted( buf );
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.maxTime ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.frames ) );
+                    ImGui::PopID();
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 2:
+    {
+        const auto& threads = engine.GetThreads();
+        std::vector<const CriticalPath::ThreadResult*> list;
+        list.reserve( threads.size() );
+        for( auto& v : threads ) list.emplace_back( &v );
+
+        if( ImGui::BeginTable( "##criticalpaththreads", 2, flags ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Thread", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Critical time", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+            const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+            if( sortspec.ColumnIndex == 1 )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [asc]( const auto& lhs, const auto& rhs ) { return asc ? lhs->time < rhs->time : lhs->time > rhs->time; } );
+            }
+            else
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto cmp = strcmp( m_worker.GetThreadName( lhs->thread ), m_worker.GetThreadName( rhs->thread ) );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+
+            for( auto& ptr : list )
+            {
+                auto& v = *ptr;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                SmallColorBox( GetThreadColor( v.thread, 0 ) );
+                ImGui::SameLine();
+                ImGui::TextUnformatted( m_worker.GetThreadName( v.thread ) );
+                ImGui::SameLine();
+                ImGui::TextDisabled( "(%s)", RealToString( v.thread ) );
+                if( ImGui::IsItemHovered() ) m_drawThreadHighlight = v.thread;
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( v.time ) );
+                if( totalTime != 0 )
+                {
+                    ImGui::SameLine();
+                    PrintStringPercent( buf, 100. * v.time / totalTime );
+                    TextDisabledUnformatted( buf );
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    default:
+        assert( false );
+        break;
+    }
+
+    ImGui::End();
+}
+
+}
@@ -37,6 +37,30 @@ void View::FindZones()
         }
     }
 }
+
+void View::FindZoneText()
+{
+    m_zoneTextList.clear();
+    m_zoneTextValid = false;
+    if( m_zoneTextFilter.CountGrep == 0 ) return;
+
+    std::vector<const ZoneEvent*> candidates, zones;
+    for( auto& f : m_zoneTextFilter.Filters )
+    {
+        if( f.empty() || f.b[0] == '-' ) continue;
+        if( !m_worker.GetZoneTextCandidates( f.b, f.e - f.b, candidates ) ) return;
+        zones.insert( zones.end(), candidates.begin(), candidates.end() );
+    }
+    m_zoneTextValid = true;
+
+    std::sort( zones.begin(), zones.end() );
+    zones.erase( std::unique( zones.begin(), zones.end() ), zones.end() );
+    for( auto& zone : zones )
+    {
+        if( m_zoneTextFilter.PassFilter( m_worker.GetString( m_worker.GetZoneExtra( *zone ).text ) ) ) m_zoneTextList.push_back( zone );
+    }
+    pdqsort_branchless( m_zoneTextList.begin(), m_zoneTextList.end(), [] ( const auto& l, const auto& r ) { return l->Start() < r->Start(); } );
+}
 #endif
 
 uint64_t View::GetSelectionTarget( const Worker::ZoneThreadData& ev, FindZone::GroupBy groupBy ) const
@@ -344,6 +368,41 @@ void View::DrawFindZone()
         FindZones();
     }
 
+    if( ImGui::TreeNode( ICON_FA_FONT " Search zone text" ) )
+    {
+        bool textChanged = m_zoneTextFilter.Draw( ICON_FA_FILTER "###zoneText", 200 );
+        ImGui::SameLine();
+        if( ImGui::Button( ICON_FA_DELETE_LEFT " Clear###zoneTextClear" ) )
+        {
+            m_zoneTextFilter.Clear();
+            textChanged = true;
+        }
+        if( textChanged || ( !m_zoneTextValid && m_worker.IsTextIndexReady() ) ) FindZoneText();
+
+        if( !m_worker.IsTextIndexReady() )
+        {
+            ImGui::TextDisabled( "Building text index..." );
+            ImGui::TreePop();
+        }
+        else if( !m_zoneTextValid )
+        {
+            ImGui::TextDisabled( "Enter a search term at least 3 characters long." );
+            ImGui::TreePop();
+        }
+        else
+        {
+            TextFocused( "Matching zones:", RealToString( m_zoneTextList.size() ) );
+            if( m_zoneTextList.empty() )
+            {
+                ImGui::TreePop();
+            }
+            else
+            {
+                DrawZoneList( -1, m_zoneTextList );
+            }
+        }
+    }
+
     ImGui::Separator();
     ImGui::BeginChild( "##findzone" );
 
@@ -247,15 +247,10 @@ void View::BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& d
 
 void View::BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& data, const Vector<SampleData>& samples )
 {
-    struct FrameCache
-    {
-        uint64_t symaddr;
-        StringIdx name;
-        bool external;
-    };
-
-    std::vector<FrameCache> cache;
-
+    // Samples sharing a call stack are merged first, so that each unique stack is walked only once.
+    // Stacks are kept in the order of first appearance, which is the order of unsorted items.
+    unordered_flat_map<uint32_t, uint32_t> stackIdx;
+    std::vector<std::pair<uint32_t, int64_t>> counts;
     for( auto& v : samples )
     {
         if ( m_flameGraphInvariant.range.active )
@@ -267,9 +262,39 @@ void View::BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& d
             }
         }
 
+        const auto cs = v.callstack.Val();
+        auto it = stackIdx.find( cs );
+        if( it == stackIdx.end() )
+        {
+            stackIdx.emplace( cs, counts.size() );
+            counts.emplace_back( cs, 1 );
+        }
+        else
+        {
+            counts[it->second].second++;
+        }
+    }
+
+    BuildFlameGraph( worker, data, counts );
+}
+
+void View::BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& data, const std::vector<std::pair<uint32_t, int64_t>>& stacks )
+{
+    struct FrameCache
+    {
+        uint64_t symaddr;
+        StringIdx name;
+        bool external;
+    };
+
+    std::vector<FrameCache> cache;
+
+    for( auto& v : stacks )
+    {
         cache.clear();
 
-        const auto cs = v.callstack.Val();
+        const auto cs = v.first;
+        const auto count = v.second;
         const auto& callstack = worker.GetCallstack( cs );
         const auto csz = callstack.size();
         if( m_flameExternal )
@@ -357,12 +382,12 @@ void View::BuildFlameGraph( const Worker& worker, std::vector<FlameGraphItem>& d
             auto it = std::find_if( vec->begin(), vec->end(), [symaddr = v.symaddr]( const auto& v ) { return v.srcloc == symaddr; } );
             if( it == vec->end() )
             {
-                vec->emplace_back( FlameGraphItem { (int64_t)v.symaddr, 1, v.name } );
+                vec->emplace_back( FlameGraphItem { (int64_t)v.symaddr, count, v.name } );
                 vec = &vec->back().children;
             }
             else
             {
-                it->time++;
+                it->time += count;
                 vec = &it->children;
             }
         }
@@ -590,8 +615,9 @@ void View::DrawFlameGraphItem( const FlameGraphItem& item, FlameGraphContext& ct
                 }
                 TextFocused( "Image:", m_worker.GetString( sym->imageName ) );
                 ImGui::Separator();
-                const auto period = m_worker.GetSamplingPeriod();
-                TextFocused( "Execution time:", TimeToString( item.time * period ) );
+                // Off-CPU call stacks are weighted by time, not by sample count.
+                const auto period = m_flameMode == 3 ? 1 : m_worker.GetSamplingPeriod();
+                TextFocused( m_flameMode == 3 ? "Off-CPU time:" : "Execution time:", TimeToString( item.time * period ) );
                 if( !item.children.empty() )
                 {
                     TextFocused( "Self time:", TimeToString( self * period ) );
@@ -631,7 +657,7 @@ void View::DrawFlameGraphItem( const FlameGraphItem& item, FlameGraphContext& ct
             }
             ImGui::EndTooltip();
 
-            if( IsMouseClicked( 0 ) )
+            if( IsMouseClicked( 0 ) && m_flameMode == 0 )
             {
                 m_findZone.ShowZone( item.srcloc, slName );
             }
@@ -744,6 +770,19 @@ void View::DrawFlameGraph()
         if( ImGui::RadioButton( ICON_FA_EYE_DROPPER " Sampling", &m_flameMode, 1 ) ) m_flameGraphInvariant.Reset();
     }
 
+#ifndef TRACY_NO_STATISTICS
+    if( m_worker.GetGpuZoneCount() > 0 )
+    {
+        ImGui::SameLine();
+        if( ImGui::RadioButton( ICON_FA_EYE " GPU", &m_flameMode, 2 ) ) m_flameGraphInvariant.Reset();
+    }
+    if( m_worker.AreCallstackSamplesReady() && m_worker.GetContextSwitchSampleCount() > 0 )
+    {
+        ImGui::SameLine();
+        if( ImGui::RadioButton( ICON_FA_BED " Off-CPU", &m_flameMode, 3 ) ) m_flameGraphInvariant.Reset();
+    }
+#endif
+
     ImGui::SameLine();
     ImGui::SeparatorEx( ImGuiSeparatorFlags_Vertical );
     ImGui::SameLine();
@@ -762,7 +801,7 @@ void View::DrawFlameGraph()
             assert( !m_flameRunningTime );
         }
     }
-    else
+    else if( m_flameMode == 1 || m_flameMode == 3 )
     {
         ImGui::SameLine();
         ImGui::SeparatorEx( ImGuiSeparatorFlags_Vertical );
@@ -780,6 +819,11 @@ void View::DrawFlameGraph()
     ImGui::SeparatorEx( ImGuiSeparatorFlags_Vertical );
     ImGui::SameLine();
 
+    // GPU flame graphs and off-CPU call stacks are accumulated by the worker over the whole trace,
+    // for each GPU context and each thread, respectively.
+    const bool gpuMode = m_flameMode == 2;
+    const bool wholeTrace = gpuMode || m_flameMode == 3;
+    if( wholeTrace ) ImGui::BeginDisabled();
     if( ImGui::Checkbox( "Limit range", &m_flameRange.active ) )
     {
         if( m_flameRange.active && m_flameRange.min == 0 && m_flameRange.max == 0 )
@@ -797,7 +841,9 @@ void View::DrawFlameGraph()
         ImGui::SameLine();
         ToggleButton( ICON_FA_RULER " Limits", m_showRanges );
     }
+    if( wholeTrace ) ImGui::EndDisabled();
 
+    if( gpuMode ) ImGui::BeginDisabled();
     auto& td = m_worker.GetThreadData();
     auto expand = ImGui::TreeNode( ICON_FA_SHUFFLE " Visible threads:" );
     ImGui::SameLine();
@@ -854,12 +900,15 @@ void View::DrawFlameGraph()
         }
         ImGui::TreePop();
     }
+    if( gpuMode ) ImGui::EndDisabled();
 
     ImGui::Separator();
     ImGui::PopStyleVar();
 
     if( m_flameMode == 0 && ( m_flameGraphInvariant.count != m_worker.GetZoneCount() || m_flameGraphInvariant.lastTime != m_worker.GetLastTime() ) ||
         m_flameMode == 1 && ( m_flameGraphInvariant.count != m_worker.GetCallstackSampleCount() ) ||
+        m_flameMode == 2 && ( m_flameGraphInvariant.count != m_worker.GetGpuZoneCount() || m_flameGraphInvariant.lastTime != m_worker.GetLastTime() ) ||
+        m_flameMode == 3 && ( m_flameGraphInvariant.count != m_worker.GetContextSwitchSampleCount() || m_flameGraphInvariant.lastTime != m_worker.GetLastTime() ) ||
         m_flameGraphInvariant.range != m_flameRange )
     {
         m_flameGraphInvariant.range = m_flameRange;
@@ -900,6 +949,42 @@ void View::DrawFlameGraph()
             m_flameGraphInvariant.count = m_worker.GetZoneCount();
             m_flameGraphInvariant.lastTime = m_worker.GetLastTime();
         }
+#ifndef TRACY_NO_STATISTICS
+        else if( m_flameMode == 2 )
+        {
+            threadData.clear();
+            if( m_worker.AreGpuSourceLocationZonesReady() )
+            {
+                for( auto& ctx : m_worker.GetGpuData() )
+                {
+                    if( !ctx->flameGraph.empty() ) threadData.emplace_back( ctx->flameGraph );
+                }
+                m_flameGraphInvariant.count = m_worker.GetGpuZoneCount();
+                m_flameGraphInvariant.lastTime = m_worker.GetLastTime();
+            }
+        }
+        else if( m_flameMode == 3 )
+        {
+            for( auto& thread : td )
+            {
+                if( FlameGraphThread( thread->id ) )
+                {
+                    m_td.Queue( [this, idx, thread, &threadData] {
+                        // Call stack indices are assigned in the order of first appearance.
+                        std::vector<std::pair<uint32_t, int64_t>> stacks;
+                        stacks.reserve( thread->offCpuStacks.size() );
+                        for( auto& v : thread->offCpuStacks ) stacks.emplace_back( v.first, v.second );
+                        pdqsort_branchless( stacks.begin(), stacks.end(), []( const auto& lhs, const auto& rhs ) { return lhs.first < rhs.first; } );
+                        BuildFlameGraph( m_worker, threadData[idx], stacks );
+                    } );
+                    idx++;
+                }
+            }
+
+            m_flameGraphInvariant.count = m_worker.GetContextSwitchSampleCount();
+            m_flameGraphInvariant.lastTime = m_worker.GetLastTime();
+        }
+#endif
         else
         {
             for( auto& thread : td )
@@ -947,7 +1032,7 @@ void View::DrawFlameGraph()
     }
     else
     {
-        DrawFlameGraphHeader( m_flameMode == 0 ? zsz : zsz * m_worker.GetSamplingPeriod() );
+        DrawFlameGraphHeader( m_flameMode != 1 ? zsz : zsz * m_worker.GetSamplingPeriod() );
 
         FlameGraphContext ctx;
         ctx.draw = ImGui::GetWindowDrawList();
@@ -961,7 +1046,7 @@ void View::DrawFlameGraph()
         ctx.vEnd = zsz;
 
         ImGui::ItemSize( region );
-        DrawFlameGraphLevel( m_flameGraphData, ctx, 0, m_flameMode == 1 );
+        DrawFlameGraphLevel( m_flameGraphData, ctx, 0, m_flameMode == 1 || m_flameMode == 3 );
     }
 
     ImGui::EndChild();
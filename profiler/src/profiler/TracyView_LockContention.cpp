@@ -0,0 +1,393 @@
+#include <functional>
+#include <inttypes.h>
+
+#include "TracyFilesystem.hpp"
+#include "TracyImGui.hpp"
+#include "TracyMouse.hpp"
+#include "TracyPrint.hpp"
+#include "TracyView.hpp"
+#include "tracy_pdqsort.h"
+
+namespace tracy
+{
+
+static void SetupStatsColumns()
+{
+    ImGui::TableSetupColumn( "Wait time", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Median wait", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Hold time", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Median hold", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Blocking", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Contended", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+    ImGui::TableSetupColumn( "Acquisitions", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+}
+
+static std::function<int64_t(const LockAnalysis::Stats&)> GetStatsKey( int column )
+{
+    switch( column )
+    {
+    case 0: return []( const auto& v ) { return v.wait; };
+    case 1: return []( const auto& v ) { return v.waitDist.Quantile( 0.5 ); };
+    case 2: return []( const auto& v ) { return v.hold; };
+    case 3: return []( const auto& v ) { return v.holdDist.Quantile( 0.5 ); };
+    case 4: return []( const auto& v ) { return v.blocking; };
+    case 5: return []( const auto& v ) { return int64_t( v.contended * 10000 / std::max<uint64_t>( 1, v.acquisitions ) ); };
+    case 6: return []( const auto& v ) { return int64_t( v.acquisitions ); };
+    default: assert( false ); return nullptr;
+    }
+}
+
+static void DrawDistributionTooltip( const LogSketch& dist, int64_t max )
+{
+    if( !ImGui::IsItemHovered() || dist.Count() == 0 ) return;
+    ImGui::BeginTooltip();
+    TextFocused( "Median:", TimeToString( dist.Quantile( 0.5 ) ) );
+    TextFocused( "P90:", TimeToString( dist.Quantile( 0.9 ) ) );
+    TextFocused( "P99:", TimeToString( dist.Quantile( 0.99 ) ) );
+    TextFocused( "Max:", TimeToString( max ) );
+    ImGui::EndTooltip();
+}
+
+static void DrawStatsColumns( const LockAnalysis::Stats& v )
+{
+    char buf[64];
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( TimeToString( v.wait ) );
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( TimeToString( v.waitDist.Quantile( 0.5 ) ) );
+    DrawDistributionTooltip( v.waitDist, v.waitMax );
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( TimeToString( v.hold ) );
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( TimeToString( v.holdDist.Quantile( 0.5 ) ) );
+    DrawDistributionTooltip( v.holdDist, v.holdMax );
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( TimeToString( v.blocking ) );
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( RealToString( v.contended ) );
+    if( v.acquisitions != 0 )
+    {
+        ImGui::SameLine();
+        PrintStringPercent( buf, 100. * v.contended / v.acquisitions );
+        TextDisabledUnformatted( buf );
+    }
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted( RealToString( v.acquisitions ) );
+}
+
+void View::DrawLockContention()
+{
+    const auto scale = GetScale();
+    ImGui::SetNextWindowSize( ImVec2( 1000 * scale, 600 * scale ), ImGuiCond_FirstUseEver );
+    ImGui::Begin( "Lock contention", &m_lockContention.show, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse );
+    if( ImGui::GetCurrentWindowRead()->SkipItems ) { ImGui::End(); return; }
+
+    if( !m_lockContention.engine ) m_lockContention.StartEngine( std::make_unique<LockAnalysis>( m_worker ), "Lock contention" );
+    auto& engine = *m_lockContention.engine;
+    if( !DrawAnalysisProgress( engine ) )
+    {
+        ImGui::End();
+        return;
+    }
+    m_lockContention.JoinEngine();
+
+    ImGui::RadioButton( "Locks", &m_lockContention.mode, 0 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Source locations", &m_lockContention.mode, 1 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Longest waits", &m_lockContention.mode, 2 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Convoys", &m_lockContention.mode, 3 );
+    ImGui::SameLine();
+    if( ImGui::Button( ICON_FA_ARROWS_ROTATE " Recompute" ) ) m_lockContention.ResetEngine();
+    ImGui::SameLine();
+    DrawHelpMarker( "Wait time is measured from the lock wait to the lock obtain. An acquisition is contended if another thread was holding the lock when the wait started. Blocking time is the time other threads spent waiting while the lock was held, summed over all waiting threads. A convoy is a period during which the lock always had waiting threads, with at least two handoffs between them." );
+    ImGui::Separator();
+    if( !m_lockContention.engine )
+    {
+        ImGui::End();
+        return;
+    }
+
+    auto LockName = [this] ( char* buf, uint32_t id, const LockMap& lockmap ) {
+        if( lockmap.customName.Active() )
+        {
+            sprintf( buf, "Lock #%" PRIu32 ": %s", id, m_worker.GetString( lockmap.customName ) );
+        }
+        else
+        {
+            sprintf( buf, "Lock #%" PRIu32 ": %s", id, m_worker.GetString( m_worker.GetSourceLocation( lockmap.srcloc ).function ) );
+        }
+    };
+    auto LockSelectable = [&, this] ( uint32_t id ) {
+        auto it = m_worker.GetLockMap().find( id );
+        if( it == m_worker.GetLockMap().end() ) return false;
+        char buf[1024];
+        LockName( buf, id, *it->second );
+        const auto clicked = ImGui::Selectable( buf, m_lockInfoWindow == id, ImGuiSelectableFlags_SpanAllColumns );
+        if( ImGui::IsItemHovered() ) m_lockHoverHighlight = id;
+        return clicked;
+    };
+    auto SiteName = [this] ( int16_t srcloc ) {
+        const auto& sl = m_worker.GetSourceLocation( srcloc );
+        return LocationToString( m_worker.GetString( sl.file ), sl.line );
+    };
+
+    const auto flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY;
+    switch( m_lockContention.mode )
+    {
+    case 0:
+    {
+        const auto& locks = engine.GetLocks();
+        std::vector<const LockAnalysis::LockResult*> list;
+        list.reserve( locks.size() );
+        for( auto& v : locks ) list.emplace_back( &v );
+
+        if( ImGui::BeginTable( "##lockcontention", 11, flags ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Lock", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Location", ImGuiTableColumnFlags_DefaultHide );
+            SetupStatsColumns();
+            ImGui::TableSetupColumn( "Max waiters", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Events", ImGuiTableColumnFlags_DefaultHide | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+            std::function<int64_t(const LockAnalysis::LockResult&)> key;
+            switch( sortspec.ColumnIndex )
+            {
+            case 0: key = []( const auto& v ) { return int64_t( v.id ); }; break;
+            case 1: key = nullptr; break;
+            case 9: key = []( const auto& v ) { return int64_t( v.maxWaiters ); }; break;
+            case 10: key = []( const auto& v ) { return int64_t( v.events ); }; break;
+            default:
+            {
+                auto statsKey = GetStatsKey( sortspec.ColumnIndex - 2 );
+                key = [statsKey]( const auto& v ) { return statsKey( v.stats ); };
+                break;
+            }
+            }
+            const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+            if( key )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [&key, asc]( const auto& lhs, const auto& rhs ) { return asc ? key( *lhs ) < key( *rhs ) : key( *lhs ) > key( *rhs ); } );
+            }
+            else
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto& sll = m_worker.GetSourceLocation( lhs->lock->srcloc );
+                    const auto& slr = m_worker.GetSourceLocation( rhs->lock->srcloc );
+                    auto cmp = strcmp( m_worker.GetString( sll.file ), m_worker.GetString( slr.file ) );
+                    if( cmp == 0 ) cmp = int( sll.line ) - int( slr.line );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+
+            ImGuiListClipper clipper;
+            clipper.Begin( (int)list.size() );
+            while( clipper.Step() )
+            {
+                for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+                {
+                    auto& v = *list[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID( i );
+                    if( LockSelectable( v.id ) ) m_lockInfoWindow = v.id;
+                    ImGui::TableNextColumn();
+                    TextDisabledUnformatted( SiteName( v.lock->srcloc ) );
+                    DrawStatsColumns( v.stats );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.maxWaiters ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.events ) );
+                    ImGui::PopID();
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 1:
+    {
+        const auto& srclocs = engine.GetSourceLocations();
+        std::vector<const LockAnalysis::SrcLocResult*> list;
+        list.reserve( srclocs.size() );
+        for( auto& v : srclocs ) list.emplace_back( &v );
+
+        if( ImGui::BeginTable( "##lockcontentionsrcloc", 9, flags ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Function", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Location" );
+            SetupStatsColumns();
+            ImGui::TableHeadersRow();
+
+            const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+            std::function<int64_t(const LockAnalysis::SrcLocResult&)> key;
+            if( sortspec.ColumnIndex >= 2 )
+            {
+                auto statsKey = GetStatsKey( sortspec.ColumnIndex - 2 );
+                key = [statsKey]( const auto& v ) { return statsKey( v.stats ); };
+            }
+            const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+            if( key )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [&key, asc]( const auto& lhs, const auto& rhs ) { return asc ? key( *lhs ) < key( *rhs ) : key( *lhs ) > key( *rhs ); } );
+            }
+            else if( sortspec.ColumnIndex == 0 )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto cmp = strcmp( m_worker.GetString( m_worker.GetSourceLocation( lhs->srcloc ).function ), m_worker.GetString( m_worker.GetSourceLocation( rhs->srcloc ).function ) );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+            else
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto& sll = m_worker.GetSourceLocation( lhs->srcloc );
+                    const auto& slr = m_worker.GetSourceLocation( rhs->srcloc );
+                    auto cmp = strcmp( m_worker.GetString( sll.file ), m_worker.GetString( slr.file ) );
+                    if( cmp == 0 ) cmp = int( sll.line ) - int( slr.line );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+
+            ImGuiListClipper clipper;
+            clipper.Begin( (int)list.size() );
+            while( clipper.Step() )
+            {
+                for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+                {
+                    auto& v = *list[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID( i );
+                    const auto& srcloc = m_worker.GetSourceLocation( v.srcloc );
+                    const auto fileName = m_worker.GetString( srcloc.file );
+                    if( ImGui::Selectable( m_worker.GetString( srcloc.function ), false, ImGuiSelectableFlags_SpanAllColumns ) )
+                    {
+                        if( SourceFileValid( fileName, m_worker.GetCaptureTime(), *this, m_worker ) ) ViewSource( fileName, srcloc.line );
+                    }
+                    if( ImGui::IsItemHovered() ) DrawSourceTooltip( fileName, srcloc.line );
+                    ImGui::TableNextColumn();
+                    TextDisabledUnformatted( LocationToString( fileName, srcloc.line ) );
+                    DrawStatsColumns( v.stats );
+                    ImGui::PopID();
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 2:
+    {
+        const auto& waits = engine.GetLongestWaits();
+        if( waits.empty() )
+        {
+            ImGui::TextUnformatted( "No lock was waited for." );
+            break;
+        }
+        if( ImGui::BeginTable( "##lockcontentionwaits", 8, flags & ~ImGuiTableFlags_Sortable ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Lock", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Thread" );
+            ImGui::TableSetupColumn( "Location" );
+            ImGui::TableSetupColumn( "Start", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Wait", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Holder" );
+            ImGui::TableSetupColumn( "Holder location" );
+            ImGui::TableSetupColumn( "Held", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            for( size_t i=0; i<waits.size(); i++ )
+            {
+                auto& v = waits[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID( i );
+                if( LockSelectable( v.lock ) ) ZoomToRange( v.start, v.end );
+                if( ImGui::IsItemHovered() && IsMouseClicked( 1 ) ) m_lockInfoWindow = v.lock;
+                ImGui::TableNextColumn();
+                SmallColorBox( GetThreadColor( v.thread, 0 ) );
+                ImGui::SameLine();
+                ImGui::TextUnformatted( m_worker.GetThreadName( v.thread ) );
+                ImGui::TableNextColumn();
+                TextDisabledUnformatted( SiteName( v.srcloc ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToStringExact( v.start ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( v.end - v.start ) );
+                ImGui::TableNextColumn();
+                if( v.holder == 0 )
+                {
+                    TextDisabledUnformatted( "shared" );
+                    ImGui::TableNextColumn();
+                }
+                else
+                {
+                    SmallColorBox( GetThreadColor( v.holder, 0 ) );
+                    ImGui::SameLine();
+                    ImGui::TextUnformatted( m_worker.GetThreadName( v.holder ) );
+                    ImGui::TableNextColumn();
+                    TextDisabledUnformatted( SiteName( v.holderSrcLoc ) );
+                }
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( v.holderTime ) );
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 3:
+    {
+        const auto& convoys = engine.GetLongestConvoys();
+        if( convoys.empty() )
+        {
+            ImGui::TextUnformatted( "No lock convoys were found." );
+            break;
+        }
+        if( ImGui::BeginTable( "##lockcontentionconvoys", 5, flags & ~ImGuiTableFlags_Sortable ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Lock", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Start", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Duration", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Handoffs", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Max waiters", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            for( size_t i=0; i<convoys.size(); i++ )
+            {
+                auto& v = convoys[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID( i );
+                if( LockSelectable( v.lock ) ) ZoomToRange( v.start, v.end );
+                if( ImGui::IsItemHovered() && IsMouseClicked( 1 ) ) m_lockInfoWindow = v.lock;
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToStringExact( v.start ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( v.end - v.start ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( RealToString( v.handoffs ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( RealToString( v.maxWaiters ) );
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    default:
+        assert( false );
+        break;
+    }
+
+    ImGui::End();
+}
+
+}
@@ -57,17 +57,21 @@ struct MemoryPage
     int8_t data[PageSize];
 };
 
-static tracy_force_inline MemoryPage& GetPage( unordered_flat_map<uint64_t, MemoryPage>& memmap, uint64_t page )
+template<class PageMap>
+static tracy_force_inline uint32_t* GetPage( PageMap& pm, uint64_t page )
 {
-    auto it = memmap.find( page );
-    if( it == memmap.end() )
+    auto it = pm.owners.find( page );
+    if( it == pm.owners.end() )
     {
-        it = memmap.emplace( page, MemoryPage { page, {} } ).first;
+        it = pm.owners.emplace( page, std::make_unique<uint32_t[]>( PageSize ) ).first;
+        pm.pages.emplace_back( page );
+        pm.sorted = false;
     }
-    return it->second;
+    return it->second.get();
 }
 
-static tracy_force_inline void FillPages( unordered_flat_map<uint64_t, MemoryPage>& memmap, uint64_t c0, uint64_t c1, int8_t val )
+template<class PageMap>
+static tracy_force_inline void FillPages( PageMap& pm, uint64_t c0, uint64_t c1, uint32_t owner )
 {
     auto p0 = c0 >> PageBits;
     const auto p1 = c1 >> PageBits;
@@ -77,96 +81,109 @@ static tracy_force_inline void FillPages( unordered_flat_map<uint64_t, MemoryPag
         const auto a0 = c0 & ( PageSize - 1 );
         const auto a1 = c1 & ( PageSize - 1 );
 
-        auto& page = GetPage( memmap, p0 );
-        if( a0 == a1 )
-        {
-            page.data[a0] = val;
-        }
-        else
-        {
-            memset( page.data + a0, val, a1 - a0 + 1 );
-        }
+        auto page = GetPage( pm, p0 );
+        std::fill( page + a0, page + a1 + 1, owner );
     }
     else
     {
         {
             const auto a0 = c0 & ( PageSize - 1 );
-            auto& page = GetPage( memmap, p0 );
-            memset( page.data + a0, val, PageSize - a0 );
+            auto page = GetPage( pm, p0 );
+            std::fill( page + a0, page + PageSize, owner );
         }
         while( ++p0 < p1 )
         {
-            auto& page = GetPage( memmap, p0 );
-            memset( page.data, val, PageSize );
+            auto page = GetPage( pm, p0 );
+            std::fill( page, page + PageSize, owner );
         }
         {
             const auto a1 = c1 & ( PageSize - 1 );
-            auto& page = GetPage( memmap, p1 );
-            memset( page.data, val, a1 + 1 );
+            auto page = GetPage( pm, p1 );
+            std::fill( page, page + a1 + 1, owner );
         }
     }
 }
 
-std::vector<MemoryPage> View::GetMemoryPages() const
+static tracy_force_inline int8_t GetMemDecay( const MemEvent& ev, int64_t time )
 {
-    std::vector<MemoryPage> ret;
-
-    static unordered_flat_map<uint64_t, MemoryPage> memmap;
+    const auto tf = ev.TimeFree();
+    if( tf < 0 || tf > time )
+    {
+        return int8_t( std::max( int64_t( 1 ), 127 - ( ( time - std::min( time, ev.TimeAlloc() ) ) >> 24 ) ) );
+    }
+    else
+    {
+        return int8_t( -std::max( int64_t( 1 ), 127 - ( ( time - tf ) >> 24 ) ) );
+    }
+}
 
+std::vector<MemoryPage> View::GetMemoryPages()
+{
+    // Each chunk remembers the last allocation that covered it. Allocations are only appended,
+    // so the map is brought up to date by replaying the allocations made since the previous call.
+    // Decay values depend on the reference time and are derived from the owners on every call.
     const auto& mem = m_worker.GetMemoryNamed( m_memInfo.pool );
     const auto memlow = mem.low;
+    const auto& range = m_memInfo.range;
+    auto& pm = m_memInfo.pageMap;
 
-    if( m_memInfo.range.active )
+    if( pm.pool != m_memInfo.pool || pm.low != memlow || pm.range != range.active || ( range.active && ( pm.min != range.min || pm.max != range.max ) ) )
     {
-        auto it = std::lower_bound( mem.data.begin(), mem.data.end(), m_memInfo.range.min, []( const auto& lhs, const auto& rhs ) { return lhs.TimeAlloc() < rhs; } );
-        if( it != mem.data.end() )
-        {
-            auto end = std::lower_bound( mem.data.begin(), mem.data.end(), m_memInfo.range.max, []( const auto& lhs, const auto& rhs ) { return lhs.TimeAlloc() < rhs; } );
-            while( it != end )
-            {
-                auto& alloc = *it++;
-
-                const auto a0 = alloc.Ptr() - memlow;
-                const auto a1 = a0 + alloc.Size();
-                int8_t val = alloc.TimeFree() < 0 ?
-                    int8_t( std::max( int64_t( 1 ), 127 - ( ( m_memInfo.range.max - alloc.TimeAlloc() ) >> 24 ) ) ) :
-                    ( alloc.TimeFree() > m_memInfo.range.max ?
-                        int8_t( std::max( int64_t( 1 ), 127 - ( ( m_memInfo.range.max - alloc.TimeAlloc() ) >> 24 ) ) ) :
-                        int8_t( -std::max( int64_t( 1 ), 127 - ( ( m_memInfo.range.max - alloc.TimeFree() ) >> 24 ) ) ) );
-
-                const auto c0 = a0 >> ChunkBits;
-                const auto c1 = a1 >> ChunkBits;
+        pm.pool = m_memInfo.pool;
+        pm.low = memlow;
+        pm.range = range.active;
+        pm.min = range.min;
+        pm.max = range.max;
+        pm.next = 0;
+        pm.sorted = true;
+        pm.owners.clear();
+        pm.pages.clear();
+    }
 
-                FillPages( memmap, c0, c1, val );
-            }
-        }
+    auto begin = mem.data.begin();
+    auto end = mem.data.end();
+    int64_t time = m_worker.GetLastTime();
+    if( range.active )
+    {
+        begin = std::lower_bound( mem.data.begin(), mem.data.end(), range.min, []( const auto& lhs, const auto& rhs ) { return lhs.TimeAlloc() < rhs; } );
+        end = std::lower_bound( begin, mem.data.end(), range.max, []( const auto& lhs, const auto& rhs ) { return lhs.TimeAlloc() < rhs; } );
+        time = range.max;
     }
-    else
+
+    for( auto it = std::max( begin, mem.data.begin() + pm.next ); it < end; ++it )
     {
-        const auto lastTime = m_worker.GetLastTime();
-        for( auto& alloc : mem.data )
-        {
-            const auto a0 = alloc.Ptr() - memlow;
-            const auto a1 = a0 + alloc.Size();
-            const int8_t val = alloc.TimeFree() < 0 ?
-                int8_t( std::max( int64_t( 1 ), 127 - ( ( lastTime - std::min( lastTime, alloc.TimeAlloc() ) ) >> 24 ) ) ) :
-                int8_t( -std::max( int64_t( 1 ), 127 - ( ( lastTime - std::min( lastTime, alloc.TimeFree() ) ) >> 24 ) ) );
+        const auto a0 = it->Ptr() - memlow;
+        const auto a1 = a0 + it->Size();
+        FillPages( pm, a0 >> ChunkBits, a1 >> ChunkBits, uint32_t( it - mem.data.begin() ) + 1 );
+    }
+    pm.next = std::max<uint32_t>( pm.next, end - mem.data.begin() );
 
-            const auto c0 = a0 >> ChunkBits;
-            const auto c1 = a1 >> ChunkBits;
+    if( !pm.sorted )
+    {
+        pdqsort_branchless( pm.pages.begin(), pm.pages.end() );
+        pm.sorted = true;
+    }
 
-            FillPages( memmap, c0, c1, val );
+    std::vector<MemoryPage> ret( pm.pages.size() );
+    for( size_t i=0; i<pm.pages.size(); i++ )
+    {
+        auto& page = ret[i];
+        page.page = pm.pages[i];
+        auto owners = pm.owners.find( page.page )->second.get();
+        size_t idx = 0;
+        while( idx < PageSize )
+        {
+            const auto owner = owners[idx];
+            const int8_t val = owner == 0 ? 0 : GetMemDecay( mem.data[owner-1], time );
+            const auto i0 = idx;
+            do
+            {
+                idx++;
+            }
+            while( idx < PageSize && owners[idx] == owner );
+            memset( page.data + i0, val, idx - i0 );
         }
     }
-
-    std::vector<unordered_flat_map<uint64_t, MemoryPage>::const_iterator> itmap;
-    itmap.reserve( memmap.size() );
-    ret.reserve( memmap.size() );
-    for( auto it = memmap.begin(); it != memmap.end(); ++it ) itmap.emplace_back( it );
-    pdqsort_branchless( itmap.begin(), itmap.end(), []( const auto& lhs, const auto& rhs ) { return lhs->second.page < rhs->second.page; } );
-    for( auto& v : itmap ) ret.emplace_back( v->second );
-
-    memmap.clear();
     return ret;
 }
 
@@ -329,10 +346,54 @@ void View::DrawMemory()
     ImGui::Separator();
     if( ImGui::TreeNode( ICON_FA_HEART_PULSE " Active allocations" ) )
     {
+        ImGui::SameLine();
+        if( SmallCheckbox( "At time", &m_memInfo.atTime ) && m_memInfo.time == 0 )
+        {
+            m_memInfo.time = ( m_vd.zvStart + m_vd.zvEnd ) / 2;
+        }
+        if( m_memInfo.atTime )
+        {
+            const int64_t tmin = m_memInfo.range.active ? m_memInfo.range.min : 0;
+            const int64_t tmax = m_memInfo.range.active ? m_memInfo.range.max : m_worker.GetLastTime();
+            m_memInfo.time = std::clamp( m_memInfo.time, tmin, tmax );
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth( 300 * scale );
+            ImGui::PushStyleVar( ImGuiStyleVar_FramePadding, ImVec2( 2, 0 ) );
+            ImGui::SliderScalar( "##memTime", ImGuiDataType_S64, &m_memInfo.time, &tmin, &tmax, TimeToStringExact( m_memInfo.time ), ImGuiSliderFlags_AlwaysClamp );
+            ImGui::PopStyleVar();
+            ImGui::SameLine();
+            DrawHelpMarker( "Allocations live at the selected time. Limited to the memory range, if one is set." );
+        }
+        else if( m_memInfo.range.active )
+        {
+            ImGui::SameLine();
+            SmallCheckbox( "Alive in range", &m_memInfo.inRange );
+            ImGui::SameLine();
+            DrawHelpMarker( "Allocations live at any moment of the memory range, including the ones made before it or freed within it. Otherwise only the allocations made in the range and still live at its end are listed." );
+        }
+
         uint64_t total = 0;
         std::vector<const MemEvent*> items;
         items.reserve( mem.active.size() );
-        if( m_memInfo.range.active )
+        if( m_memInfo.atTime || ( m_memInfo.range.active && m_memInfo.inRange ) )
+        {
+            std::vector<uint32_t> live;
+            if( m_memInfo.atTime )
+            {
+                m_worker.GetMemoryLive( mem, m_memInfo.time, live );
+            }
+            else
+            {
+                m_worker.GetMemoryLive( mem, m_memInfo.range.min, m_memInfo.range.max, live );
+            }
+            items.reserve( live.size() );
+            for( auto& v : live )
+            {
+                items.emplace_back( &mem.data[v] );
+                total += mem.data[v].Size();
+            }
+        }
+        else if( m_memInfo.range.active )
         {
             auto it = std::lower_bound( mem.data.begin(), mem.data.end(), m_memInfo.range.min, [] ( const auto& lhs, const auto& rhs ) { return lhs.TimeAlloc() < rhs; } );
             if( it != mem.data.end() )
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "TracyImGui.hpp"
 #include "TracyPrint.hpp"
 #include "TracyTexture.hpp"
@@ -7,6 +9,30 @@
 namespace tracy
 {
 
+// Indices of messages that may pass the filter, retrieved from the text index. Returns false
+// if the index cannot be used and all messages have to be checked.
+static bool GetMessageFilterCandidates( const Worker& worker, const ImGuiTextFilter& filter, std::vector<uint32_t>& out )
+{
+    if( filter.CountGrep == 0 ) return false;
+    const auto& msgs = worker.GetMessages();
+    std::vector<const MessageData*> candidates;
+    out.clear();
+    for( auto& f : filter.Filters )
+    {
+        if( f.empty() || f.b[0] == '-' ) continue;
+        if( !worker.GetMessageCandidates( f.b, f.e - f.b, candidates ) ) return false;
+        for( auto& msg : candidates )
+        {
+            auto it = std::lower_bound( msgs.begin(), msgs.end(), msg->time, [] ( const auto& l, const auto& r ) { return l->time < r; } );
+            while( it != msgs.end() && *it != msg ) ++it;
+            if( it != msgs.end() ) out.emplace_back( uint32_t( it - msgs.begin() ) );
+        }
+    }
+    std::sort( out.begin(), out.end() );
+    out.erase( std::unique( out.begin(), out.end() ), out.end() );
+    return true;
+}
+
 void View::DrawMessages()
 {
     const auto& msgs = m_worker.GetMessages();
@@ -128,7 +154,25 @@ void View::DrawMessages()
         bool showCallstack = false;
         m_msgList.reserve( msgs.size() );
         m_msgList.clear();
-        if( m_messageFilter.IsActive() )
+        std::vector<uint32_t> candidates;
+        if( m_messageFilter.IsActive() && GetMessageFilterCandidates( m_worker, m_messageFilter, candidates ) )
+        {
+            for( auto i : candidates )
+            {
+                const auto& v = msgs[i];
+                const auto tid = m_worker.DecompressThread( v->thread );
+                if( VisibleMsgThread( tid ) )
+                {
+                    const auto text = m_worker.GetString( msgs[i]->ref );
+                    if( m_messageFilter.PassFilter( text ) )
+                    {
+                        if( !showCallstack && msgs[i]->callstack.Val() != 0 ) showCallstack = true;
+                        m_msgList.push_back_no_space_check( i );
+                    }
+                }
+            }
+        }
+        else if( m_messageFilter.IsActive() )
         {
             for( size_t i=0; i<msgs.size(); i++ )
             {
@@ -239,6 +239,20 @@ void View::DrawNotificationArea()
         {
             ImGui::BeginTooltip();
             ImGui::TextUnformatted( "Processing background tasks" );
+#ifndef TRACY_NO_STATISTICS
+            if( !m_worker.AreSourceLocationZonesReady() )
+            {
+                auto& progress = Worker::GetLoadProgress();
+                const auto statTotal = progress.statTotal.load( std::memory_order_relaxed );
+                if( statTotal != 0 )
+                {
+                    const auto statProgress = progress.statProgress.load( std::memory_order_relaxed );
+                    TextDisabledUnformatted( "Zone statistics:" );
+                    ImGui::SameLine();
+                    ImGui::Text( "%.1f%%", 100.f * statProgress / statTotal );
+                }
+            }
+#endif
             ImGui::EndTooltip();
         }
     }
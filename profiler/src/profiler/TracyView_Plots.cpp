@@ -152,17 +152,9 @@ bool View::DrawPlot( const TimelineContext& ctx, PlotData& plot, const std::vect
 
                     if( hover && ImGui::IsMouseHoveringRect( wpos + ImVec2( x - 2, offset ), wpos + ImVec2( x + 2, offset + PlotHeight ) ) )
                     {
-                        constexpr int NumSamples = 256;
                         ImGui::BeginTooltip();
                         TextFocused( "Number of values:", RealToString( cnt ) );
-                        if( cnt < NumSamples )
-                        {
-                            TextDisabledUnformatted( "Range:" );
-                        }
-                        else
-                        {
-                            TextDisabledUnformatted( "Estimated range:" );
-                        }
+                        TextDisabledUnformatted( "Range:" );
                         ImGui::SameLine();
                         ImGui::Text( "%s - %s", FormatPlotValue( vmin, plot.format ), FormatPlotValue( vmax, plot.format ) );
                         ImGui::SameLine();
@@ -0,0 +1,322 @@
+#include <functional>
+
+#include "TracyImGui.hpp"
+#include "TracyMouse.hpp"
+#include "TracyPrint.hpp"
+#include "TracyView.hpp"
+#include "tracy_pdqsort.h"
+
+namespace tracy
+{
+
+void View::DrawScheduler()
+{
+    const auto scale = GetScale();
+    ImGui::SetNextWindowSize( ImVec2( 1000 * scale, 600 * scale ), ImGuiCond_FirstUseEver );
+    ImGui::Begin( "Scheduler", &m_scheduler.show, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse );
+    if( ImGui::GetCurrentWindowRead()->SkipItems ) { ImGui::End(); return; }
+
+    if( !m_scheduler.engine ) m_scheduler.StartEngine( std::make_unique<SchedulerAnalysis>( m_worker ), "Scheduler" );
+    auto& engine = *m_scheduler.engine;
+    if( !DrawAnalysisProgress( engine ) )
+    {
+        ImGui::End();
+        return;
+    }
+    m_scheduler.JoinEngine();
+
+    ImGui::RadioButton( "Threads", &m_scheduler.mode, 0 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Source locations", &m_scheduler.mode, 1 );
+    ImGui::SameLine();
+    ImGui::RadioButton( "Preempted zones", &m_scheduler.mode, 2 );
+    ImGui::SameLine();
+    if( ImGui::Button( ICON_FA_ARROWS_ROTATE " Recompute" ) ) m_scheduler.ResetEngine();
+    ImGui::SameLine();
+    DrawHelpMarker( "Off-CPU time is split at the thread wakeup. Blocked time is spent waiting for an event, run queue time is spent waiting for a free CPU after the thread became runnable. Preempted threads were switched out while still runnable, so all their off-CPU time is run queue time." );
+    ImGui::Separator();
+    if( !m_scheduler.engine )
+    {
+        ImGui::End();
+        return;
+    }
+
+    const auto flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY;
+    switch( m_scheduler.mode )
+    {
+    case 0:
+    {
+        const auto& threads = engine.GetThreads();
+        std::vector<const SchedulerAnalysis::ThreadResult*> list;
+        list.reserve( threads.size() );
+        for( auto& v : threads ) list.emplace_back( &v );
+
+        if( ImGui::BeginTable( "##schedthreads", 9, flags ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Thread", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Running time", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Blocked", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Run queue", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Wakeup latency", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Max run queue", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Switches", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Preemptions", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Core jumps", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+            std::function<int64_t(const SchedulerAnalysis::ThreadResult&)> key;
+            switch( sortspec.ColumnIndex )
+            {
+            case 0: key = nullptr; break;
+            case 1: key = []( const auto& v ) { return v.running; }; break;
+            case 2: key = []( const auto& v ) { return v.stats.blocked; }; break;
+            case 3: key = []( const auto& v ) { return v.stats.runQueue; }; break;
+            case 4: key = []( const auto& v ) { return v.wakeupLatency.Quantile( 0.5 ); }; break;
+            case 5: key = []( const auto& v ) { return v.stats.maxRunQueue; }; break;
+            case 6: key = []( const auto& v ) { return int64_t( v.stats.periods ); }; break;
+            case 7: key = []( const auto& v ) { return int64_t( v.stats.preemptions ); }; break;
+            case 8: key = []( const auto& v ) { return int64_t( v.stats.migrations ); }; break;
+            default: assert( false ); break;
+            }
+            const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+            if( key )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [&key, asc]( const auto& lhs, const auto& rhs ) { return asc ? key( *lhs ) < key( *rhs ) : key( *lhs ) > key( *rhs ); } );
+            }
+            else
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto cmp = strcmp( m_worker.GetThreadName( lhs->thread ), m_worker.GetThreadName( rhs->thread ) );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+
+            ImGuiListClipper clipper;
+            clipper.Begin( (int)list.size() );
+            while( clipper.Step() )
+            {
+                for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+                {
+                    auto& v = *list[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    SmallColorBox( GetThreadColor( v.thread, 0 ) );
+                    ImGui::SameLine();
+                    ImGui::TextUnformatted( m_worker.GetThreadName( v.thread ) );
+                    ImGui::SameLine();
+                    ImGui::TextDisabled( "(%s)", RealToString( v.thread ) );
+                    if( ImGui::IsItemHovered() ) m_drawThreadHighlight = v.thread;
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.running ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.blocked ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.runQueue ) );
+                    if( ImGui::IsItemHovered() && v.runQueue.Count() != 0 )
+                    {
+                        ImGui::BeginTooltip();
+                        TextFocused( "Median:", TimeToString( v.runQueue.Quantile( 0.5 ) ) );
+                        TextFocused( "P90:", TimeToString( v.runQueue.Quantile( 0.9 ) ) );
+                        TextFocused( "P99:", TimeToString( v.runQueue.Quantile( 0.99 ) ) );
+                        TextFocused( "Preempted:", TimeToString( v.stats.preempted ) );
+                        ImGui::EndTooltip();
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.wakeupLatency.Quantile( 0.5 ) ) );
+                    if( ImGui::IsItemHovered() && v.wakeupLatency.Count() != 0 )
+                    {
+                        ImGui::BeginTooltip();
+                        TextFocused( "Median:", TimeToString( v.wakeupLatency.Quantile( 0.5 ) ) );
+                        TextFocused( "P90:", TimeToString( v.wakeupLatency.Quantile( 0.9 ) ) );
+                        TextFocused( "P99:", TimeToString( v.wakeupLatency.Quantile( 0.99 ) ) );
+                        ImGui::EndTooltip();
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.maxRunQueue ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.stats.periods ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.stats.preemptions ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.stats.migrations ) );
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 1:
+    {
+        const auto& srclocs = engine.GetSourceLocations();
+        std::vector<const SchedulerAnalysis::SrcLocResult*> list;
+        list.reserve( srclocs.size() );
+        for( auto& v : srclocs )
+        {
+            if( v.stats.offCpu != 0 ) list.emplace_back( &v );
+        }
+
+        if( ImGui::BeginTable( "##schedsrcloc", 8, flags ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Name", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Location", ImGuiTableColumnFlags_DefaultHide );
+            ImGui::TableSetupColumn( "Total time", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Off-CPU", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Blocked", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Run queue", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Preempted", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Zones", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            const auto& sortspec = *ImGui::TableGetSortSpecs()->Specs;
+            std::function<int64_t(const SchedulerAnalysis::SrcLocResult&)> key;
+            switch( sortspec.ColumnIndex )
+            {
+            case 0:
+            case 1: key = nullptr; break;
+            case 2: key = []( const auto& v ) { return v.time; }; break;
+            case 3: key = []( const auto& v ) { return v.stats.offCpu; }; break;
+            case 4: key = []( const auto& v ) { return v.stats.blocked; }; break;
+            case 5: key = []( const auto& v ) { return v.stats.runQueue; }; break;
+            case 6: key = []( const auto& v ) { return v.stats.preempted; }; break;
+            case 7: key = []( const auto& v ) { return int64_t( v.zones ); }; break;
+            default: assert( false ); break;
+            }
+            const auto asc = sortspec.SortDirection == ImGuiSortDirection_Ascending;
+            if( key )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [&key, asc]( const auto& lhs, const auto& rhs ) { return asc ? key( *lhs ) < key( *rhs ) : key( *lhs ) > key( *rhs ); } );
+            }
+            else if( sortspec.ColumnIndex == 0 )
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto cmp = strcmp( m_worker.GetZoneName( m_worker.GetSourceLocation( lhs->srcloc ) ), m_worker.GetZoneName( m_worker.GetSourceLocation( rhs->srcloc ) ) );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+            else
+            {
+                pdqsort_branchless( list.begin(), list.end(), [this, asc]( const auto& lhs, const auto& rhs ) {
+                    const auto& sll = m_worker.GetSourceLocation( lhs->srcloc );
+                    const auto& slr = m_worker.GetSourceLocation( rhs->srcloc );
+                    auto cmp = strcmp( m_worker.GetString( sll.file ), m_worker.GetString( slr.file ) );
+                    if( cmp == 0 ) cmp = int( sll.line ) - int( slr.line );
+                    return asc ? cmp < 0 : cmp > 0;
+                } );
+            }
+
+            char buf[64];
+            ImGuiListClipper clipper;
+            clipper.Begin( (int)list.size() );
+            while( clipper.Step() )
+            {
+                for( auto i=clipper.DisplayStart; i<clipper.DisplayEnd; i++ )
+                {
+                    auto& v = *list[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID( i );
+                    auto& srcloc = m_worker.GetSourceLocation( v.srcloc );
+                    const auto name = m_worker.GetZoneName( srcloc );
+                    SmallColorBox( GetSrcLocColor( srcloc, 0 ) );
+                    ImGui::SameLine();
+                    if( ImGui::Selectable( name, m_findZone.show && !m_findZone.match.empty() && m_findZone.match[m_findZone.selMatch] == v.srcloc, ImGuiSelectableFlags_SpanAllColumns ) )
+                    {
+                        m_findZone.ShowZone( v.srcloc, name );
+                    }
+                    ImGui::TableNextColumn();
+                    TextDisabledUnformatted( LocationToString( m_worker.GetString( srcloc.file ), srcloc.line ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.time ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.offCpu ) );
+                    ImGui::SameLine();
+                    PrintStringPercent( buf, 100. * v.stats.offCpu / v.time );
+                    TextDisabledUnformatted( buf );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.blocked ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.runQueue ) );
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( TimeToString( v.stats.preempted ) );
+                    if( v.stats.preemptions != 0 )
+                    {
+                        ImGui::SameLine();
+                        ImGui::TextDisabled( "(%s)", RealToString( v.stats.preemptions ) );
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( RealToString( v.zones ) );
+                    ImGui::PopID();
+                }
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    case 2:
+    {
+        const auto& zones = engine.GetTopPreemptedZones();
+        if( zones.empty() )
+        {
+            ImGui::TextUnformatted( "No zone was preempted." );
+            break;
+        }
+        if( ImGui::BeginTable( "##schedzones", 5, flags & ~ImGuiTableFlags_Sortable ) )
+        {
+            ImGui::TableSetupScrollFreeze( 0, 1 );
+            ImGui::TableSetupColumn( "Zone", ImGuiTableColumnFlags_NoHide );
+            ImGui::TableSetupColumn( "Thread" );
+            ImGui::TableSetupColumn( "Time", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Preempted", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableSetupColumn( "Off-CPU", ImGuiTableColumnFlags_WidthFixed );
+            ImGui::TableHeadersRow();
+
+            char buf[64];
+            for( size_t i=0; i<zones.size(); i++ )
+            {
+                auto& v = zones[i];
+                auto& zone = *v.zone;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID( i );
+                SmallColorBox( GetSrcLocColor( m_worker.GetSourceLocation( zone.SrcLoc() ), 0 ) );
+                ImGui::SameLine();
+                if( ImGui::Selectable( m_worker.GetZoneName( zone ), m_zoneInfoWindow == &zone, ImGuiSelectableFlags_SpanAllColumns ) )
+                {
+                    ShowZoneInfo( zone );
+                }
+                if( ImGui::IsItemHovered() )
+                {
+                    m_zoneHover = &zone;
+                    if( IsMouseClicked( 2 ) ) ZoomToZone( zone );
+                }
+                ImGui::TableNextColumn();
+                SmallColorBox( GetThreadColor( v.thread, 0 ) );
+                ImGui::SameLine();
+                ImGui::TextUnformatted( m_worker.GetThreadName( v.thread ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( zone.End() - zone.Start() ) );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( v.preempted ) );
+                ImGui::SameLine();
+                PrintStringPercent( buf, 100. * v.preempted / ( zone.End() - zone.Start() ) );
+                TextDisabledUnformatted( buf );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( TimeToString( v.offCpu ) );
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+        break;
+    }
+    default:
+        assert( false );
+        break;
+    }
+
+    ImGui::End();
+}
+
+}
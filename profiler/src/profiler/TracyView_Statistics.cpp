@@ -20,13 +20,61 @@ struct SrcLocZonesSlim
     int64_t total;
 };
 
+static void TextTimeStats( const char* label, int64_t min, int64_t total, int64_t max, double sumSq, size_t count )
+{
+    TextDisabledUnformatted( label );
+    ImGui::SameLine();
+    ImGui::Text( "%s / %s / %s", TimeToString( min ), TimeToString( total / int64_t( count ) ), TimeToString( max ) );
+    if( count > 1 && sumSq >= 0 )
+    {
+        const auto avg = double( total ) / count;
+        const auto ss = sumSq - 2. * total * avg + avg * avg * count;
+        ImGui::SameLine();
+        ImGui::Spacing();
+        ImGui::SameLine();
+        TextFocused( "\xcf\x83:", TimeToString( int64_t( sqrt( std::max( 0., ss ) / ( count - 1 ) ) ) ) );
+    }
+}
+
+// Whole trace statistics of a GPU source location, as collected by the worker.
+static void GpuZoneStatisticsTooltip( const Worker& worker, int16_t srcloc )
+{
+    auto& slz = worker.GetGpuSourceLocationZones();
+    auto it = slz.find( srcloc );
+    if( it == slz.end() || it->second.zones.empty() ) return;
+    const auto& zd = it->second;
+    const auto count = zd.zones.size();
+
+    ImGui::BeginTooltip();
+    TextDisabledUnformatted( "Whole trace, min / mean / max" );
+    TextTimeStats( "Zone time:", zd.min, zd.total, zd.max, zd.sumSq, count );
+    TextTimeStats( "Self time:", zd.selfMin, zd.selfTotal, zd.selfMax, -1, count );
+    TextTimeStats( "Latency:", zd.latencyMin, zd.latencyTotal, zd.latencyMax, zd.latencySumSq, count );
+    TooltipIfHovered( "Time from the CPU submitting the zone to the GPU starting it" );
+
+    // Bucket i > 0 holds latencies in [2^(i-1), 2^i) ns, bucket 0 those which are not positive.
+    int first = 0;
+    int last = Worker::GpuLatencyBuckets - 1;
+    while( first < last && zd.latency[first] == 0 ) first++;
+    while( last > first && zd.latency[last] == 0 ) last--;
+    float hist[Worker::GpuLatencyBuckets];
+    for( int i=first; i<=last; i++ ) hist[i-first] = float( zd.latency[i] );
+    ImGui::PlotHistogram( "##latency", hist, last - first + 1, 0, nullptr, 0, FLT_MAX, ImVec2( 300 * GetScale(), 60 * GetScale() ) );
+    const auto lo = first == 0 ? int64_t( 0 ) : int64_t( 1 ) << ( first - 1 );
+    const auto hi = int64_t( 1 ) << last;
+    TextDisabledUnformatted( "Latency distribution, log scale:" );
+    ImGui::SameLine();
+    ImGui::Text( "%s - %s", TimeToString( lo ), TimeToString( hi ) );
+    ImGui::EndTooltip();
+}
+
 void View::AccumulationModeComboBox()
 {
     ImGui::TextUnformatted( "Timing" );
     ImGui::SameLine();
-    const char* accumulationModeTable = m_statMode == 1 ? "Self only\0With children\0" : "Self only\0With children\0Non-reentrant\0";
+    const char* accumulationModeTable = m_statMode != 0 ? "Self only\0With children\0" : "Self only\0With children\0Non-reentrant\0";
     ImGui::SetNextItemWidth( ImGui::CalcTextSize( "Non-reentrant" ).x + ImGui::GetTextLineHeight() * 2 );
-    if( m_statMode == 1 && m_statAccumulationMode == AccumulationMode::NonReentrantChildren )
+    if( m_statMode != 0 && m_statAccumulationMode == AccumulationMode::NonReentrantChildren )
     {
         m_statAccumulationMode = AccumulationMode::SelfOnly;
     }
@@ -369,7 +417,7 @@ void View::DrawStatistics()
                                 if( start >= min && end <= max )
                                 {
                                     const auto zt = end - start;
-                                    total += zt;
+                                    total += m_statAccumulationMode == AccumulationMode::SelfOnly ? zt - GetZoneChildTime( z ) : zt;
                                     cnt++;
                                 }
                             }
@@ -408,7 +456,7 @@ void View::DrawStatistics()
                                     if( start >= min && end <= max )
                                     {
                                         const auto zt = end - start;
-                                        total += zt;
+                                        total += m_statAccumulationMode == AccumulationMode::SelfOnly ? zt - GetZoneChildTime( z ) : zt;
                                         cnt++;
                                     }
                                 }
@@ -431,7 +479,7 @@ void View::DrawStatistics()
                 {
                     slzcnt++;
                     size_t count = it->second.zones.size();
-                    int64_t total = it->second.total;
+                    int64_t total = m_statAccumulationMode == AccumulationMode::SelfOnly ? it->second.selfTotal : it->second.total;
                     if( !filterActive )
                     {
                         srcloc.push_back_no_space_check( SrcLocZonesSlim { it->first, 0, count, total } );
@@ -456,6 +504,10 @@ void View::DrawStatistics()
         TextFocused( "Visible zones:", RealToString( srcloc.size() ) );
         ImGui::SameLine();
         copySrclocsToClipboard = ClipboardButton();
+        ImGui::SameLine();
+        ImGui::Spacing();
+        ImGui::SameLine();
+        AccumulationModeComboBox();
     }
 
     ImGui::Separator();
@@ -724,6 +776,7 @@ void View::DrawStatistics()
                     else
                     {
                         ImGui::TextUnformatted( name );
+                        if( ImGui::IsItemHovered() ) GpuZoneStatisticsTooltip( m_worker, v.srcloc );
                     }
                     ImGui::TableNextColumn();
                     float indentVal = 0.f;
@@ -795,6 +848,35 @@ void View::DrawStatistics()
         const auto& symMap = m_worker.GetSymbolMap();
         const auto& symStat = m_worker.GetSymbolStats();
 
+        const unordered_flat_map<uint64_t, SymbolCount>* rangeCounts = nullptr;
+        if( m_statRange.active && m_worker.AreSampleBlocksReady() )
+        {
+            if( m_statSymbolCountsRange != m_statRange )
+            {
+                m_worker.GetSymbolCountsForRange( m_statRange.min, m_statRange.max, m_statSymbolCounts, m_td );
+                m_statSymbolCountsRange = m_statRange;
+            }
+            rangeCounts = &m_statSymbolCounts;
+        }
+
+        // Without the per-block tables (live capture), only self counts are available, from the symbol sample lists.
+        auto GetRangeCount = [this, rangeCounts] ( uint64_t symAddr, SymList& out ) {
+            if( rangeCounts )
+            {
+                auto it = rangeCounts->find( symAddr );
+                if( it == rangeCounts->end() ) return false;
+                out = SymList { symAddr, it->second.incl, it->second.excl };
+                return true;
+            }
+            auto samples = m_worker.GetSamplesForSymbol( symAddr );
+            if( !samples ) return false;
+            auto it = std::lower_bound( samples->begin(), samples->end(), m_statRange.min, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
+            if( it == samples->end() ) return false;
+            auto end = std::lower_bound( it, samples->end(), m_statRange.max, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
+            out = SymList { symAddr, 0, uint32_t( end - it ) };
+            return true;
+        };
+
         Vector<SymList> data;
         if( m_showAllSymbols )
         {
@@ -830,25 +912,9 @@ void View::DrawStatistics()
                         {
                             if( m_statRange.active )
                             {
-                                auto samples = m_worker.GetSamplesForSymbol( v.first );
-                                if( samples )
-                                {
-                                    auto it = std::lower_bound( samples->begin(), samples->end(), m_statRange.min, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                    if( it != samples->end() )
-                                    {
-                                        auto end = std::lower_bound( it, samples->end(), m_statRange.max, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                        const auto count = uint32_t( end - it );
-                                        data.push_back_no_space_check( SymList { v.first, 0, count } );
-                                    }
-                                    else
-                                    {
-                                        data.push_back_no_space_check( SymList { v.first, 0, 0 } );
-                                    }
-                                }
-                                else
-                                {
-                                    data.push_back_no_space_check( SymList { v.first, 0, 0 } );
-                                }
+                                SymList sl;
+                                if( !GetRangeCount( v.first, sl ) ) sl = SymList { v.first, 0, 0 };
+                                data.push_back_no_space_check( sl );
                             }
                             else
                             {
@@ -871,25 +937,9 @@ void View::DrawStatistics()
                     {
                         if( m_statRange.active )
                         {
-                            auto samples = m_worker.GetSamplesForSymbol( v.first );
-                            if( samples )
-                            {
-                                auto it = std::lower_bound( samples->begin(), samples->end(), m_statRange.min, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                if( it != samples->end() )
-                                {
-                                    auto end = std::lower_bound( it, samples->end(), m_statRange.max, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                    const auto count = uint32_t( end - it );
-                                    data.push_back_no_space_check( SymList { v.first, 0, count } );
-                                }
-                                else
-                                {
-                                    data.push_back_no_space_check( SymList { v.first, 0, 0 } );
-                                }
-                            }
-                            else
-                            {
-                                data.push_back_no_space_check( SymList { v.first, 0, 0 } );
-                            }
+                            SymList sl;
+                            if( !GetRangeCount( v.first, sl ) ) sl = SymList { v.first, 0, 0 };
+                            data.push_back_no_space_check( sl );
                         }
                         else
                         {
@@ -929,17 +979,8 @@ void View::DrawStatistics()
                         {
                             if( m_statRange.active )
                             {
-                                auto samples = m_worker.GetSamplesForSymbol( v.first );
-                                if( samples )
-                                {
-                                    auto it = std::lower_bound( samples->begin(), samples->end(), m_statRange.min, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                    if( it != samples->end() )
-                                    {
-                                        auto end = std::lower_bound( it, samples->end(), m_statRange.max, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                        const auto count = uint32_t( end - it );
-                                        data.push_back_no_space_check( SymList { v.first, 0, count } );
-                                    }
-                                }
+                                SymList sl;
+                                if( GetRangeCount( v.first, sl ) ) data.push_back_no_space_check( sl );
                             }
                             else
                             {
@@ -955,17 +996,8 @@ void View::DrawStatistics()
                 {
                     for( auto& v : symStat )
                     {
-                        auto samples = m_worker.GetSamplesForSymbol( v.first );
-                        if( samples )
-                        {
-                            auto it = std::lower_bound( samples->begin(), samples->end(), m_statRange.min, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                            if( it != samples->end() )
-                            {
-                                auto end = std::lower_bound( it, samples->end(), m_statRange.max, [] ( const auto& lhs, const auto& rhs ) { return lhs.time.Val() < rhs; } );
-                                const auto count = uint32_t( end - it );
-                                data.push_back_no_space_check( SymList { v.first, 0, count } );
-                            }
-                        }
+                        SymList sl;
+                        if( GetRangeCount( v.first, sl ) ) data.push_back_no_space_check( sl );
                     }
                 }
                 else
@@ -102,6 +102,13 @@ View::ZoneColorData View::GetZoneColorData( const ZoneEvent& ev, uint64_t thread
         ret.thickness = 3.f;
         ret.highlight = true;
     }
+    else if( m_criticalPath.show && m_criticalPath.highlight && m_criticalPath.zones.find( &ev ) != m_criticalPath.zones.end() )
+    {
+        ret.color = inheritedColor ? inheritedColor : GetZoneColor( ev, thread, depth );
+        ret.accentColor = 0xFF22AAFF;
+        ret.thickness = 3.f;
+        ret.highlight = true;
+    }
     else if( m_zoneSrcLocHighlight == srcloc )
     {
         ret.color = inheritedColor ? inheritedColor : GetZoneColor( ev, thread, depth );
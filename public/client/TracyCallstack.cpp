@@ -29,7 +29,9 @@
 #  endif
 #elif TRACY_HAS_CALLSTACK == 2 || TRACY_HAS_CALLSTACK == 3 || TRACY_HAS_CALLSTACK == 4 || TRACY_HAS_CALLSTACK == 6
 #  include "../libbacktrace/backtrace.hpp"
+#  include "../common/TracyMutex.hpp"
 #  include <algorithm>
+#  include <mutex>
 #  include <dlfcn.h>
 #  include <cxxabi.h>
 #  include <stdlib.h>
@@ -487,6 +489,11 @@ void EndCallstack()
 {
 }
 
+uint32_t GetSymbolWorkerCount()
+{
+    return 1;
+}
+
 const char* DecodeCallstackPtrFast( uint64_t ptr )
 {
     if( s_shouldResolveSymbolsOffline ) return "[unresolved]";
@@ -761,14 +768,20 @@ CallstackEntryData DecodeCallstackPtr( uint64_t ptr )
 #elif TRACY_HAS_CALLSTACK == 2 || TRACY_HAS_CALLSTACK == 3 || TRACY_HAS_CALLSTACK == 4 || TRACY_HAS_CALLSTACK == 6
 
 enum { MaxCbTrace = 64 };
+enum { MaxSymbolWorkers = 16 };
+enum { MaxIndexThreads = 64 };
 
 struct backtrace_state* cb_bts = nullptr;
 
-int cb_num;
-CallstackEntry cb_data[MaxCbTrace];
-int cb_fixup;
+// Symbol workers may decode call stack frames concurrently, each into its own buffer.
+thread_local int cb_num;
+thread_local CallstackEntry cb_data[MaxCbTrace];
+
+static uint32_t s_symbolWorkers = 1;
+static TracyMutex s_demangleLock;
 #ifdef TRACY_USE_IMAGE_CACHE
 static ImageCache* s_imageCache = nullptr;
+static TracyMutex s_imageCacheLock;
 #endif //#ifdef TRACY_USE_IMAGE_CACHE
 
 #ifdef TRACY_DEBUGINFOD
@@ -979,7 +992,24 @@ void InitCallstack()
     }
     else
     {
-        cb_bts = backtrace_create_state( nullptr, 0, nullptr, nullptr );
+        const char* symbolWorkers = GetEnvVar( "TRACY_SYMBOL_THREADS" );
+        if( symbolWorkers )
+        {
+            const auto num = atoi( symbolWorkers );
+            s_symbolWorkers = (uint32_t)std::min( std::max( num, 1 ), (int)MaxSymbolWorkers );
+        }
+        int indexThreads = 0;
+        const char* indexThreadsEnv = GetEnvVar( "TRACY_SYMBOL_INDEX_THREADS" );
+        if( indexThreadsEnv ) indexThreads = std::min( std::max( atoi( indexThreadsEnv ), 0 ), (int)MaxIndexThreads );
+
+        cb_bts = backtrace_create_state( nullptr, s_symbolWorkers > 1, nullptr, nullptr );
+        if( indexThreads > 0 ) backtrace_set_index_threads( cb_bts, indexThreads );
+        if( s_symbolWorkers > 1 || indexThreads > 0 )
+        {
+            // Load the debug information of all images now, so that the workers don't race to do it,
+            // and the indexing cost is paid here rather than on the first resolved call stack.
+            backtrace_pcinfo( cb_bts, (uintptr_t)&InitCallstack, []( void*, uintptr_t, uintptr_t, const char*, int, const char* ) { return 1; }, []( void*, const char*, int ) {}, nullptr );
+        }
     }
 
 #ifndef TRACY_DEMANGLE
@@ -1080,6 +1110,11 @@ void EndCallstack()
 #endif
 }
 
+uint32_t GetSymbolWorkerCount()
+{
+    return s_symbolWorkers;
+}
+
 const char* DecodeCallstackPtrFast( uint64_t ptr )
 {
     static char ret[1024];
@@ -1155,6 +1190,8 @@ static int CallstackDataCb( void* /*data*/, uintptr_t pc, uintptr_t lowaddr, con
         auto vptr = (void*)pc;
         ptrdiff_t symoff = 0;
 
+        // The demangler returns a shared buffer, which is in use until the name is copied.
+        std::lock_guard<TracyMutex> lock( s_demangleLock );
         Dl_info dlinfo;
         if( dladdr( vptr, &dlinfo ) )
         {
@@ -1189,18 +1226,21 @@ static int CallstackDataCb( void* /*data*/, uintptr_t pc, uintptr_t lowaddr, con
     else
     {
         if( !fn ) fn = "[unknown]";
-        if( !function )
         {
-            function = "[unknown]";
-        }
-        else
-        {
-            const char* demangled = ___tracy_demangle( function );
-            if( demangled ) function = demangled;
-        }
+            std::lock_guard<TracyMutex> lock( s_demangleLock );
+            if( !function )
+            {
+                function = "[unknown]";
+            }
+            else
+            {
+                const char* demangled = ___tracy_demangle( function );
+                if( demangled ) function = demangled;
+            }
 
-        const auto len = std::min<size_t>( strlen( function ), std::numeric_limits<uint16_t>::max() );
-        cb_data[cb_num].name = CopyStringFast( function, len );
+            const auto len = std::min<size_t>( strlen( function ), std::numeric_limits<uint16_t>::max() );
+            cb_data[cb_num].name = CopyStringFast( function, len );
+        }
         cb_data[cb_num].file = NormalizePath( fn );
         if( !cb_data[cb_num].file ) cb_data[cb_num].file = CopyStringFast( fn );
         cb_data[cb_num].line = lineno;
@@ -1263,11 +1303,14 @@ CallstackEntryData DecodeCallstackPtr( uint64_t ptr )
         uint64_t imageBaseAddress = 0x0;
 
 #ifdef TRACY_USE_IMAGE_CACHE
-        const auto* image = s_imageCache->GetImageForAddress((void*)ptr);
-        if( image )
         {
-            imageName = image->m_name;
-            imageBaseAddress = uint64_t(image->m_startAddress);
+            std::lock_guard<TracyMutex> lock( s_imageCacheLock );
+            const auto* image = s_imageCache->GetImageForAddress((void*)ptr);
+            if( image )
+            {
+                imageName = image->m_name;
+                imageBaseAddress = uint64_t(image->m_startAddress);
+            }
         }
 #else
         Dl_info dlinfo;
@@ -1334,6 +1377,11 @@ void EndCallstack()
     ___tracy_free_demangle_buffer();
 }
 
+uint32_t GetSymbolWorkerCount()
+{
+    return 1;
+}
+
 const char* DecodeCallstackPtrFast( uint64_t ptr )
 {
     static char ret[1024];
@@ -73,6 +73,17 @@ public:
         m_write++;
     }
 
+    T* prepare_next( size_t count )
+    {
+        while( size_t( m_end - m_write ) < count ) AllocMore();
+        return m_write;
+    }
+
+    void commit_next( size_t count )
+    {
+        m_write += count;
+    }
+
     void clear()
     {
         m_write = m_ptr;
@@ -924,9 +924,12 @@ static Thread* s_thread;
 #ifndef TRACY_NO_FRAME_IMAGE
 static Thread* s_compressThread;
 #endif
+enum { MaxSymbolHelpers = 16 };
 #ifdef TRACY_HAS_CALLSTACK
 static Thread* s_symbolThread;
 std::atomic<bool> s_symbolThreadGone { false };
+static Thread* s_symbolHelperThread[MaxSymbolHelpers];
+static std::atomic<bool> s_symbolHelperGone[MaxSymbolHelpers];
 #endif
 #ifdef TRACY_HAS_SYSTEM_TRACING
 static Thread* s_sysTraceThread = nullptr;
@@ -939,6 +942,7 @@ static Thread* s_sysTraceThread = nullptr;
 
 static long s_profilerTid = 0;
 static long s_symbolTid = 0;
+static long s_symbolHelperTid[MaxSymbolHelpers] = {};
 static char s_crashText[1024];
 static std::atomic<bool> s_alreadyCrashed( false );
 
@@ -1143,15 +1147,26 @@ static void CrashHandler( int signal, siginfo_t* info, void* /*ucontext*/ )
     {
         if( ep->d_name[0] == '.' ) continue;
         int tid = atoi( ep->d_name );
-        if( tid != selfTid && tid != s_profilerTid && tid != s_symbolTid )
+        if( tid == selfTid || tid == s_profilerTid || tid == s_symbolTid ) continue;
+        bool isHelper = false;
+        for( auto helperTid : s_symbolHelperTid )
         {
-            syscall( SYS_tkill, tid, TRACY_CRASH_SIGNAL );
+            if( tid == helperTid )
+            {
+                isHelper = true;
+                break;
+            }
         }
+        if( !isHelper ) syscall( SYS_tkill, tid, TRACY_CRASH_SIGNAL );
     }
     closedir( dp );
 
 #ifdef TRACY_HAS_CALLSTACK
     if( selfTid == s_symbolTid ) s_symbolThreadGone.store( true, std::memory_order_release );
+    for( int i=0; i<MaxSymbolHelpers; i++ )
+    {
+        if( selfTid == s_symbolHelperTid[i] ) s_symbolHelperGone[i].store( true, std::memory_order_release );
+    }
 #endif
 
     TracyLfqPrepare( QueueType::Crash );
@@ -1463,6 +1478,9 @@ Profiler::Profiler()
     , m_fiDequeue( 16 )
 #endif
     , m_symbolQueue( 8*1024 )
+    , m_symbolHelpers( nullptr )
+    , m_symbolHelperCount( 0 )
+    , m_symbolHelpersExit( false )
     , m_frameCount( 0 )
     , m_isConnected( false )
 #ifdef TRACY_ON_DEMAND
@@ -1638,6 +1656,13 @@ Profiler::~Profiler()
 #ifdef TRACY_HAS_CALLSTACK
     s_symbolThread->~Thread();
     tracy_free( s_symbolThread );
+    for( uint32_t i=0; i<m_symbolHelperCount; i++ )
+    {
+        s_symbolHelperThread[i]->~Thread();
+        tracy_free( s_symbolHelperThread[i] );
+        m_symbolHelpers[i].~SymbolHelperData();
+    }
+    if( m_symbolHelpers ) tracy_free( m_symbolHelpers );
 #endif
 
 #ifndef TRACY_NO_FRAME_IMAGE
@@ -3562,6 +3587,7 @@ void Profiler::SymbolWorker()
     InitRpmalloc();
 #endif
     InitCallstack();
+    StartSymbolHelpers();
     while( m_timeBegin.load( std::memory_order_relaxed ) == 0 ) std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
 
     for(;;)
@@ -3572,6 +3598,7 @@ void Profiler::SymbolWorker()
         {
             if( shouldExit )
             {
+                StopSymbolHelpers();
                 s_symbolThreadGone.store( true, std::memory_order_release );
                 return;
             }
@@ -3583,13 +3610,21 @@ void Profiler::SymbolWorker()
         auto si = m_symbolQueue.front();
         if( si )
         {
-            HandleSymbolQueueItem( *si );
+            if( m_symbolHelperCount != 0 && ( si->type == SymbolQueueItemType::CallstackFrame || si->type == SymbolQueueItemType::SymbolQuery ) )
+            {
+                DispatchSymbolQueueItem( *si );
+            }
+            else
+            {
+                HandleSymbolQueueItem( *si );
+            }
             m_symbolQueue.pop();
         }
         else
         {
             if( shouldExit )
             {
+                StopSymbolHelpers();
                 s_symbolThreadGone.store( true, std::memory_order_release );
                 return;
             }
@@ -3597,6 +3632,88 @@ void Profiler::SymbolWorker()
         }
     }
 }
+
+// Call stack frame and symbol queries are independent of each other, and the server matches the
+// responses by address, so these may be resolved out of order by a pool of helper threads.
+void Profiler::StartSymbolHelpers()
+{
+    const auto count = std::min<uint32_t>( GetSymbolWorkerCount(), MaxSymbolHelpers );
+    if( count < 2 ) return;
+
+    m_symbolHelpers = (SymbolHelperData*)tracy_malloc( sizeof( SymbolHelperData ) * count );
+    for( uint32_t i=0; i<count; i++ )
+    {
+        new(m_symbolHelpers+i) SymbolHelperData( this, i );
+        s_symbolHelperThread[i] = (Thread*)tracy_malloc( sizeof( Thread ) );
+        new(s_symbolHelperThread[i]) Thread( LaunchSymbolHelper, m_symbolHelpers+i );
+    }
+    m_symbolHelperCount = count;
+}
+
+void Profiler::StopSymbolHelpers()
+{
+    m_symbolHelpersExit.store( true, std::memory_order_release );
+    for( uint32_t i=0; i<m_symbolHelperCount; i++ )
+    {
+        while( s_symbolHelperGone[i].load( std::memory_order_acquire ) == false ) { YieldThread(); }
+    }
+}
+
+void Profiler::DispatchSymbolQueueItem( const SymbolQueueItem& si )
+{
+    auto helper = m_symbolHelpers;
+    auto minSize = helper->queue.size();
+    for( uint32_t i=1; i<m_symbolHelperCount && minSize != 0; i++ )
+    {
+        const auto size = m_symbolHelpers[i].queue.size();
+        if( size < minSize )
+        {
+            helper = m_symbolHelpers+i;
+            minSize = size;
+        }
+    }
+    helper->queue.emplace( si );
+}
+
+void Profiler::SymbolHelper( SymbolHelperData& data )
+{
+#if defined __linux__ && !defined TRACY_NO_CRASH_HANDLER
+    s_symbolHelperTid[data.idx] = syscall( SYS_gettid );
+#endif
+
+    ThreadExitHandler threadExitHandler;
+    SetThreadName( "Tracy Symbol Helper" );
+#ifdef TRACY_USE_RPMALLOC
+    InitRpmalloc();
+#endif
+
+    for(;;)
+    {
+        // Items still queued at exit are resolved before the helper goes away.
+        const auto shouldExit = m_symbolHelpersExit.load( std::memory_order_acquire );
+#ifdef TRACY_ON_DEMAND
+        if( !IsConnected() )
+        {
+            while( data.queue.front() ) data.queue.pop();
+            if( shouldExit ) break;
+            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+            continue;
+        }
+#endif
+        auto si = data.queue.front();
+        if( si )
+        {
+            HandleSymbolQueueItem( *si );
+            data.queue.pop();
+        }
+        else
+        {
+            if( shouldExit ) break;
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+    }
+    s_symbolHelperGone[data.idx].store( true, std::memory_order_release );
+}
 #endif
 
 bool Profiler::HandleServerQuery()
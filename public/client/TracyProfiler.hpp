@@ -186,6 +186,15 @@ class Profiler
         uint32_t id;
     };
 
+    struct SymbolHelperData
+    {
+        SymbolHelperData( Profiler* profiler, uint32_t idx ) : profiler( profiler ), idx( idx ), queue( 1024 ) {}
+
+        Profiler* profiler;
+        uint32_t idx;
+        SPSCQueue<SymbolQueueItem> queue;
+    };
+
 public:
     Profiler();
     ~Profiler();
@@ -279,6 +288,22 @@ public:
         p.m_serialLock.unlock();
     }
 
+    // Reserves count consecutive serial queue items under a single lock. All of them
+    // must be written before calling QueueSerialFinish( count ).
+    static tracy_force_inline QueueItem* QueueSerialBatch( size_t count )
+    {
+        auto& p = GetProfiler();
+        p.m_serialLock.lock();
+        return p.m_serialQueue.prepare_next( count );
+    }
+
+    static tracy_force_inline void QueueSerialFinish( size_t count )
+    {
+        auto& p = GetProfiler();
+        p.m_serialQueue.commit_next( count );
+        p.m_serialLock.unlock();
+    }
+
     static tracy_force_inline void SendFrameMark( const char* name )
     {
         if( !name ) GetProfiler().m_frameCount.fetch_add( 1, std::memory_order_relaxed );
@@ -838,6 +863,11 @@ private:
 #ifdef TRACY_HAS_CALLSTACK
     static void LaunchSymbolWorker( void* ptr ) { ((Profiler*)ptr)->SymbolWorker(); }
     void SymbolWorker();
+    static void LaunchSymbolHelper( void* ptr ) { ((SymbolHelperData*)ptr)->profiler->SymbolHelper( *(SymbolHelperData*)ptr ); }
+    void SymbolHelper( SymbolHelperData& data );
+    void StartSymbolHelpers();
+    void StopSymbolHelpers();
+    void DispatchSymbolQueueItem( const SymbolQueueItem& si );
     void HandleSymbolQueueItem( const SymbolQueueItem& si );
 #endif
 
@@ -1026,6 +1056,9 @@ private:
 #endif
 
     SPSCQueue<SymbolQueueItem> m_symbolQueue;
+    SymbolHelperData* m_symbolHelpers;
+    uint32_t m_symbolHelperCount;
+    std::atomic<bool> m_symbolHelpersExit;
 
     std::atomic<uint64_t> m_frameCount;
     std::atomic<bool> m_isConnected;
@@ -36,6 +36,10 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "backtrace.hpp"
 #include "internal.hpp"
 
@@ -49,11 +53,91 @@ namespace tracy
    backtrace functions may not be safely invoked from a signal
    handler.  */
 
+/* The memory and views of a state which can be released with
+   backtrace_free_state.  Modules may be indexed by multiple threads,
+   so access is guarded by a lock.  */
+
+struct backtrace_owned
+{
+  std::mutex lock;
+  std::unordered_set<void *> mem;
+  std::unordered_map<void *, struct backtrace_view> views;
+};
+
+/* Replace the owned block OLD_MEM, which may be NULL, with NEW_MEM,
+   which may be NULL as well.  */
+
+static void
+backtrace_reown (struct backtrace_state *state, void *old_mem, void *new_mem)
+{
+  struct backtrace_owned *owned = state->owned;
+  if (owned == NULL || old_mem == new_mem)
+    return;
+  std::lock_guard<std::mutex> lock (owned->lock);
+  if (old_mem != NULL)
+    owned->mem.erase (old_mem);
+  if (new_mem != NULL)
+    owned->mem.insert (new_mem);
+}
+
+void
+backtrace_own_memory (struct backtrace_state *state)
+{
+  if (state->owned == NULL)
+    state->owned = new backtrace_owned;
+}
+
+void
+backtrace_own_view (struct backtrace_state *state,
+		    const struct backtrace_view *view)
+{
+  struct backtrace_owned *owned = state->owned;
+  if (owned == NULL)
+    return;
+  std::lock_guard<std::mutex> lock (owned->lock);
+  owned->views.emplace (view->base, *view);
+}
+
+void
+backtrace_disown_view (struct backtrace_state *state,
+		       const struct backtrace_view *view)
+{
+  struct backtrace_owned *owned = state->owned;
+  if (owned == NULL)
+    return;
+  std::lock_guard<std::mutex> lock (owned->lock);
+  owned->views.erase (view->base);
+}
+
+static void
+backtrace_free_state_error (void *data ATTRIBUTE_UNUSED,
+			    const char *msg ATTRIBUTE_UNUSED,
+			    int errnum ATTRIBUTE_UNUSED)
+{
+}
+
+void
+backtrace_free_state (struct backtrace_state *state)
+{
+  struct backtrace_owned *owned = state->owned;
+  if (owned != NULL)
+    {
+      state->owned = NULL;
+      for (auto &v : owned->views)
+	backtrace_release_view (state, &v.second, backtrace_free_state_error,
+				NULL);
+      for (auto p : owned->mem)
+	tracy_free (p);
+      delete owned;
+    }
+  tracy_free (state);
+}
+
 /* Allocate memory like malloc.  If ERROR_CALLBACK is NULL, don't
    report an error.  */
 
 void *
-backtrace_alloc (struct backtrace_state *state ATTRIBUTE_UNUSED,
+backtrace_alloc (struct backtrace_state *state,
 		 size_t size, backtrace_error_callback error_callback,
 		 void *data)
 {
@@ -65,24 +149,27 @@ backtrace_alloc (struct backtrace_state *state ATTRIBUTE_UNUSED,
       if (error_callback)
 	error_callback (data, "malloc", errno);
     }
+  else
+    backtrace_reown (state, NULL, ret);
   return ret;
 }
 
 /* Free memory.  */
 
 void
-backtrace_free (struct backtrace_state *state ATTRIBUTE_UNUSED,
+backtrace_free (struct backtrace_state *state,
 		void *p, size_t size ATTRIBUTE_UNUSED,
 		backtrace_error_callback error_callback ATTRIBUTE_UNUSED,
 		void *data ATTRIBUTE_UNUSED)
 {
+  backtrace_reown (state, p, NULL);
   tracy_free (p);
 }
 
 /* Grow VEC by SIZE bytes.  */
 
 void *
-backtrace_vector_grow (struct backtrace_state *state ATTRIBUTE_UNUSED,
+backtrace_vector_grow (struct backtrace_state *state,
 		       size_t size, backtrace_error_callback error_callback,
 		       void *data, struct backtrace_vector *vec)
 {
@@ -110,6 +197,7 @@ backtrace_vector_grow (struct backtrace_state *state ATTRIBUTE_UNUSED,
 	  return NULL;
 	}
 
+      backtrace_reown (state, vec->base, base);
       vec->base = base;
       vec->alc = alc - vec->size;
     }
@@ -145,7 +233,7 @@ backtrace_vector_finish (struct backtrace_state *state,
 /* Release any extra space allocated for VEC.  */
 
 int
-backtrace_vector_release (struct backtrace_state *state ATTRIBUTE_UNUSED,
+backtrace_vector_release (struct backtrace_state *state,
 			  struct backtrace_vector *vec,
 			  backtrace_error_callback error_callback,
 			  void *data)
@@ -156,18 +244,21 @@ backtrace_vector_release (struct backtrace_state *state ATTRIBUTE_UNUSED,
     {
       /* As of C17, realloc with size 0 is marked as an obsolescent feature, use
 	 free instead.  */
+      backtrace_reown (state, vec->base, NULL);
       tracy_free (vec->base);
       vec->base = NULL;
       return 1;
     }
 
-  vec->base = tracy_realloc (vec->base, vec->size);
-  if (vec->base == NULL)
+  void *base = tracy_realloc (vec->base, vec->size);
+  if (base == NULL)
     {
       error_callback (data, "realloc", errno);
       return 0;
     }
 
+  backtrace_reown (state, vec->base, base);
+  vec->base = base;
   return 1;
 }
 
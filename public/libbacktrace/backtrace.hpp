@@ -77,8 +77,9 @@ typedef void (*backtrace_error_callback) (void *data, const char *msg,
    pointer on success, NULL on error.  If an error occurs, this will
    call the ERROR_CALLBACK routine.
 
-   Calling this function allocates resources that cannot be freed.
-   There is no backtrace_free_state function.  The state is used to
+   Calling this function allocates resources that cannot be freed,
+   unless the state is passed to backtrace_initialize_file (see
+   backtrace_free_state below).  The state is used to
    cache information that is expensive to recompute.  Programs are
    expected to call this function at most once and to save the return
    value for all later calls to backtrace functions.  */
@@ -87,6 +88,34 @@ extern struct backtrace_state *backtrace_create_state (
     const char *filename, int threaded,
     backtrace_error_callback error_callback, void *data);
 
+/* Read the line and function information of each module in full when
+   it is first loaded, using up to THREADS threads, instead of reading
+   it piecemeal as addresses are looked up.  This must be called before
+   any other function using STATE.  */
+
+extern void backtrace_set_index_threads (struct backtrace_state *state,
+					 int threads);
+
+/* Load the debug information of the ELF file FILENAME into STATE,
+   instead of the images of the current process.  The file does not
+   have to be loaded.  The addresses passed to backtrace_pcinfo and
+   backtrace_syminfo are then offsets relative to the image base.  This
+   must be called before any other function using STATE, and is
+   intended for offline symbol resolution.  Returns 1 on success, 0 on
+   failure.  */
+
+extern int backtrace_initialize_file (struct backtrace_state *state,
+				      const char *filename,
+				      backtrace_error_callback error_callback,
+				      void *data);
+
+/* Release STATE, along with all the memory and file views allocated
+   for it.  This is only possible for a state which was passed to
+   backtrace_initialize_file, whether it succeeded or not.  STATE must
+   not be used by any other thread.  */
+
+extern void backtrace_free_state (struct backtrace_state *state);
+
 /* The type of the callback argument to the backtrace_full function.
    DATA is the argument passed to backtrace_full.  PC is the program
    counter.  FILENAME is the name of the file containing PC, or NULL
@@ -37,11 +37,18 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include <string.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
+#include <new>
+
 #include "filenames.hpp"
 
 #include "backtrace.hpp"
 #include "internal.hpp"
 
+#include "../client/TracyThread.hpp"
+#include "../common/TracyAlloc.hpp"
+
 namespace tracy
 {
 
@@ -3986,6 +3993,62 @@ report_inlined_functions (uintptr_t pc, struct function *function, const char* c
   return 0;
 }
 
+/* Read the line and function information for the unit U and store it
+   in the unit.  PFVEC is the vector to use for the function addresses,
+   or NULL to allocate a new one.  Set *NEW_DATA if the information was
+   read successfully.  Return the lines, which is (struct line *) -1 on
+   error.  */
+
+static struct line *
+read_unit_info (struct backtrace_state *state, struct dwarf_data *ddata,
+		struct unit *u, struct function_vector *pfvec,
+		backtrace_error_callback error_callback, void *data,
+		int *new_data)
+{
+  struct function_addrs *function_addrs;
+  size_t function_addrs_count;
+  struct line_header lhdr;
+  struct line *lines;
+  size_t count;
+
+  function_addrs = NULL;
+  function_addrs_count = 0;
+  if (read_line_info (state, ddata, error_callback, data, u, &lhdr,
+		      &lines, &count))
+    {
+      read_function_info (state, ddata, &lhdr, error_callback, data,
+			  u, pfvec, &function_addrs,
+			  &function_addrs_count);
+      free_line_header (state, &lhdr, error_callback, data);
+      *new_data = 1;
+    }
+
+  /* Atomically store the information we just read into the unit.
+     If another thread is simultaneously writing, it presumably
+     read the same information, and we don't care which one we
+     wind up with; we just leak the other one.  We do have to
+     write the lines field last, so that the acquire-loads in
+     dwarf_lookup_pc ensure that the other fields are set.  */
+
+  if (!state->threaded)
+    {
+      u->lines_count = count;
+      u->function_addrs = function_addrs;
+      u->function_addrs_count = function_addrs_count;
+      u->lines = lines;
+    }
+  else
+    {
+      backtrace_atomic_store_size_t (&u->lines_count, count);
+      backtrace_atomic_store_pointer (&u->function_addrs, function_addrs);
+      backtrace_atomic_store_size_t (&u->function_addrs_count,
+				     function_addrs_count);
+      backtrace_atomic_store_pointer (&u->lines, lines);
+    }
+
+  return lines;
+}
+
 /* Look for a PC in the DWARF mapping for one module.  On success,
    call CALLBACK and return whatever it returns.  On error, call
    ERROR_CALLBACK and return 0.  Sets *FOUND to 1 if the PC is found,
@@ -4087,56 +4150,13 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
   new_data = 0;
   if (lines == NULL)
     {
-      struct function_addrs *function_addrs;
-      size_t function_addrs_count;
-      struct line_header lhdr;
-      size_t count;
-
       /* We have never read the line information for this unit.  Read
-	 it now.  */
-
-      function_addrs = NULL;
-      function_addrs_count = 0;
-      if (read_line_info (state, ddata, error_callback, data, entry->u, &lhdr,
-			  &lines, &count))
-	{
-	  struct function_vector *pfvec;
-
-	  /* If not threaded, reuse DDATA->FVEC for better memory
-	     consumption.  */
-	  if (state->threaded)
-	    pfvec = NULL;
-	  else
-	    pfvec = &ddata->fvec;
-	  read_function_info (state, ddata, &lhdr, error_callback, data,
-			      entry->u, pfvec, &function_addrs,
-			      &function_addrs_count);
-	  free_line_header (state, &lhdr, error_callback, data);
-	  new_data = 1;
-	}
+	 it now.  If not threaded, reuse DDATA->FVEC for better memory
+	 consumption.  */
 
-      /* Atomically store the information we just read into the unit.
-	 If another thread is simultaneously writing, it presumably
-	 read the same information, and we don't care which one we
-	 wind up with; we just leak the other one.  We do have to
-	 write the lines field last, so that the acquire-loads above
-	 ensure that the other fields are set.  */
-
-      if (!state->threaded)
-	{
-	  u->lines_count = count;
-	  u->function_addrs = function_addrs;
-	  u->function_addrs_count = function_addrs_count;
-	  u->lines = lines;
-	}
-      else
-	{
-	  backtrace_atomic_store_size_t (&u->lines_count, count);
-	  backtrace_atomic_store_pointer (&u->function_addrs, function_addrs);
-	  backtrace_atomic_store_size_t (&u->function_addrs_count,
-					 function_addrs_count);
-	  backtrace_atomic_store_pointer (&u->lines, lines);
-	}
+      lines = read_unit_info (state, ddata, u,
+			      state->threaded ? NULL : &ddata->fvec,
+			      error_callback, data, &new_data);
     }
 
   /* Now all fields of U have been initialized.  */
@@ -4258,18 +4278,22 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
   }
 }
 
+/* Look for PC in the DWARF data of all modules, starting at the link *PP.  When PC
+   is not found, *PP is left at the terminating NULL link, so that a later call only
+   searches the entries appended in the meantime.  */
+
 bool dwarf_fileline_dwarf_lookup_pc_in_all_entries(struct backtrace_state *state, uintptr_t pc,
       backtrace_full_callback callback, backtrace_error_callback error_callback, void *data,
-      int& found, int ret)
+      int& found, int& ret, struct dwarf_data**& pp)
 {
-    for (struct dwarf_data* ddata = (struct dwarf_data *)state->fileline_data;
-         ddata != NULL;
-         ddata = ddata->next)
+    while (1)
     {
+      struct dwarf_data* ddata = state->threaded ? (struct dwarf_data *) backtrace_atomic_load_pointer (pp) : *pp;
+      if (ddata == NULL) return false;
       ret = dwarf_lookup_pc(state, ddata, pc, callback, error_callback, data, &found);
       if (ret != 0 || found) return true;
+      pp = &ddata->next;
     }
-    return false;
 }
 
 /* Return the file/line information for a PC using the DWARF mapping
@@ -4280,51 +4304,28 @@ dwarf_fileline (struct backtrace_state *state, uintptr_t pc,
 		backtrace_full_callback callback,
 		backtrace_error_callback error_callback, void *data)
 {
-  struct dwarf_data *ddata;
+  struct dwarf_data **pp;
   int found;
   int ret = 0;
 
-  if (!state->threaded)
+  pp = (struct dwarf_data **) (void *) &state->fileline_data;
+  if (dwarf_fileline_dwarf_lookup_pc_in_all_entries(state, pc, callback, error_callback, data, found, ret, pp))
   {
-    if (dwarf_fileline_dwarf_lookup_pc_in_all_entries(state, pc, callback, error_callback, data, found, ret))
-    {
-       return ret;
-    }
-
-    // if we failed to obtain an entry in range, it can mean that the address map has been changed and new entries
-    //  have been loaded in the meantime. Request a refresh and try again.
-    if (state->request_known_address_ranges_refresh_fn)
-    {
-        int new_range_count = state->request_known_address_ranges_refresh_fn(state, pc);
-        if (new_range_count > 0)
-        {
-          if (dwarf_fileline_dwarf_lookup_pc_in_all_entries(state, pc, callback, error_callback, data, found, ret))
-          {
-            return ret;
-          }
-        }
-    }
-
+     return ret;
   }
-  else
-    {
-      struct dwarf_data **pp;
-
-      pp = (struct dwarf_data **) (void *) &state->fileline_data;
-      while (1)
-	{
-	  ddata = backtrace_atomic_load_pointer (pp);
-	  if (ddata == NULL)
-	    break;
-
-	  ret = dwarf_lookup_pc (state, ddata, pc, callback, error_callback,
-				 data, &found);
-	  if (ret != 0 || found)
-	    return ret;
 
-	  pp = &ddata->next;
-	}
-    }
+  // if we failed to obtain an entry in range, it can mean that the address map has been changed and new entries
+  //  have been loaded in the meantime. Request a refresh and try again.
+  if (state->request_known_address_ranges_refresh_fn)
+  {
+      // Only the entries appended since the walk above are searched. With a threaded state these may have
+      //  been added by the refresh of another thread, in which case this refresh reports no new ranges.
+      state->request_known_address_ranges_refresh_fn(state, pc);
+      if (dwarf_fileline_dwarf_lookup_pc_in_all_entries(state, pc, callback, error_callback, data, found, ret, pp))
+      {
+        return ret;
+      }
+  }
 
   /* FIXME: See if any libraries have been dlopen'ed.  */
 
@@ -4388,6 +4389,80 @@ build_dwarf_data (struct backtrace_state *state,
   return fdata;
 }
 
+/* Eager indexing of all units of a module, shared by the index
+   threads.  */
+
+struct dwarf_index_job
+{
+  struct backtrace_state *state;
+  struct dwarf_data *ddata;
+  std::atomic<size_t> next;
+};
+
+/* Errors are not reported, as they are not related to any lookup.
+   Units that fail to parse are marked as such, just as they would be
+   on a lazy read.  */
+
+static void
+dwarf_index_error (void *, const char *, int)
+{
+}
+
+static void
+dwarf_index_worker (void *ptr)
+{
+  ThreadExitHandler threadExitHandler;
+  struct dwarf_index_job *job = (struct dwarf_index_job *) ptr;
+
+  while (1)
+    {
+      size_t i = job->next.fetch_add (1, std::memory_order_relaxed);
+      if (i >= job->ddata->units_count)
+	break;
+
+      struct unit *u = job->ddata->units[i];
+      if (backtrace_atomic_load_pointer (&u->lines) == NULL)
+	{
+	  int new_data;
+	  read_unit_info (job->state, job->ddata, u, NULL,
+			  dwarf_index_error, NULL, &new_data);
+	}
+    }
+}
+
+/* Read the line and function information of all units of DDATA,
+   using up to STATE->INDEX_THREADS threads, instead of reading each
+   unit on its first lookup.  This is done before DDATA is made
+   visible to lookups.  */
+
+static void
+dwarf_index_units (struct backtrace_state *state, struct dwarf_data *ddata)
+{
+  struct dwarf_index_job job;
+  size_t threads;
+  size_t i;
+  Thread *workers;
+
+  job.state = state;
+  job.ddata = ddata;
+  job.next.store (0, std::memory_order_relaxed);
+
+  threads = std::min ((size_t) state->index_threads, ddata->units_count);
+  if (threads < 2)
+    {
+      dwarf_index_worker (&job);
+      return;
+    }
+
+  workers = (Thread *) tracy_malloc (sizeof (Thread) * (threads - 1));
+  for (i = 0; i < threads - 1; ++i)
+    new (workers + i) Thread (dwarf_index_worker, &job);
+  dwarf_index_worker (&job);
+  for (i = 0; i < threads - 1; ++i)
+    workers[i].~Thread ();
+  tracy_free (workers);
+}
+
 /* Build our data structures from the DWARF sections for a module.
    Set FILELINE_FN and STATE->FILELINE_DATA.  Return 1 on success, 0
    on failure.  */
@@ -4409,6 +4484,9 @@ backtrace_dwarf_add (struct backtrace_state *state,
   if (fdata == NULL)
     return 0;
 
+  if (state->index_threads > 0)
+    dwarf_index_units (state, fdata);
+
   if (fileline_entry != NULL)
     *fileline_entry = fdata;
 
@@ -47,8 +47,11 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include "backtrace.hpp"
 #include "internal.hpp"
 
+#include <mutex>
+
 #include "../client/TracyFastVector.hpp"
 #include "../common/TracyAlloc.hpp"
+#include "../common/TracyMutex.hpp"
 
 #ifndef S_ISLNK
  #ifndef S_IFLNK
@@ -7372,6 +7375,8 @@ struct ElfAddrRange
   ElfW(Addr) dlpi_end_addr;
 };
 FastVector<ElfAddrRange> s_sortedKnownElfRanges(16);
+// Guards the two vectors above, for states shared by multiple threads.
+static TracyMutex s_elfRangesLock;
 
 static int address_in_known_elf_ranges(uintptr_t pc)
 {
@@ -7468,6 +7473,7 @@ phdr_callback (struct PhdrIterate *info, void *pdata)
 
 static int elf_iterate_phdr_and_add_new_files(phdr_data *pd)
 {
+	std::lock_guard<TracyMutex> lock(s_elfRangesLock);
 	assert(s_phdrData.empty());
 	// dl_iterate_phdr, will only add entries for elf files loaded in a previously unseen range
 	dl_iterate_phdr(phdr_callback_mock, nullptr);
@@ -7504,9 +7510,12 @@ static int elf_iterate_phdr_and_add_new_files(phdr_data *pd)
 This could mean that new images were dlopened and we need to add those new elf entries */
 static int elf_refresh_address_ranges_if_needed(struct backtrace_state *state, uintptr_t pc)
 {
-	if ( address_in_known_elf_ranges(pc) )
 	{
-		return 0;
+		std::lock_guard<TracyMutex> lock(s_elfRangesLock);
+		if ( address_in_known_elf_ranges(pc) )
+		{
+			return 0;
+		}
 	}
 
 	struct phdr_data pd;
@@ -7580,8 +7589,8 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
       if (found_sym)
 	backtrace_atomic_store_pointer (&state->syminfo_fn, &elf_syminfo);
       else
-	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, NULL,
-					     elf_nosyms);
+	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, (syminfo) NULL,
+					     &elf_nosyms);
     }
 
   if (!state->threaded)
@@ -7602,4 +7611,43 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
   return 1;
 }
 
+/* Initialize the backtrace data for a single ELF file, which does not
+   have to be loaded in the current process.  */
+
+int
+backtrace_initialize_file (struct backtrace_state *state, const char *filename,
+			   backtrace_error_callback error_callback, void *data)
+{
+  int descriptor;
+  int does_not_exist;
+  int found_sym;
+  int found_dwarf;
+  fileline elf_fileline_fn = elf_nodebug;
+  struct libbacktrace_base_address zero_base_address;
+
+  backtrace_own_memory (state);
+
+  descriptor = backtrace_open (filename, error_callback, data, &does_not_exist);
+  if (descriptor < 0)
+    {
+      state->fileline_initialization_failed = 1;
+      return 0;
+    }
+
+  memset (&zero_base_address, 0, sizeof zero_base_address);
+  if (elf_add (state, filename, descriptor, NULL, 0, zero_base_address,
+	       NULL, error_callback, data, &elf_fileline_fn, &found_sym,
+	       &found_dwarf, NULL, 0, 0, NULL, 0) != 1)
+    {
+      state->fileline_initialization_failed = 1;
+      return 0;
+    }
+
+  state->syminfo_fn = found_sym ? elf_syminfo : elf_nosyms;
+  state->fileline_fn = elf_fileline_fn;
+  state->request_known_address_ranges_refresh_fn = NULL;
+
+  return 1;
+}
+
 }
@@ -166,6 +166,12 @@ struct backtrace_state
   struct backtrace_freelist_struct *freelist;
   /* Trigger an known address range refresh */
   request_known_address_ranges_refresh request_known_address_ranges_refresh_fn;
+  /* Number of threads reading all debug info of a module when it is
+     added, or zero to read it as needed.  */
+  int index_threads;
+  /* Memory and views allocated for the state, if it can be released
+     with backtrace_free_state, or NULL.  */
+  struct backtrace_owned *owned;
 };
 
 /* Open a file for reading.  Returns -1 on error.  If DOES_NOT_EXIST
@@ -207,6 +213,17 @@ extern void backtrace_release_view (struct backtrace_state *state,
 				    backtrace_error_callback error_callback,
 				    void *data);
 
+/* Keep track of the views of a state which can be released with
+   backtrace_free_state.  These do nothing for other states.  */
+extern void backtrace_own_view (struct backtrace_state *state,
+				const struct backtrace_view *view);
+extern void backtrace_disown_view (struct backtrace_state *state,
+				   const struct backtrace_view *view);
+
+/* Start keeping track of the memory and views allocated for STATE, so
+   that backtrace_free_state can release them.  */
+extern void backtrace_own_memory (struct backtrace_state *state);
+
 /* Close a file opened by backtrace_open.  Returns 1 on success, 0 on
    error.  */
 
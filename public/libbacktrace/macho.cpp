@@ -1299,8 +1299,8 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
       if (found_sym)
 	backtrace_atomic_store_pointer (&state->syminfo_fn, &macho_syminfo);
       else
-	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, NULL,
-					     macho_nosyms);
+	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, (syminfo) NULL,
+					     &macho_nosyms);
     }
 
   if (!state->threaded)
@@ -1347,8 +1347,8 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
       if (found_sym)
 	backtrace_atomic_store_pointer (&state->syminfo_fn, &macho_syminfo);
       else
-	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, NULL,
-					     macho_nosyms);
+	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, (syminfo) NULL,
+					     &macho_nosyms);
     }
 
   if (!state->threaded)
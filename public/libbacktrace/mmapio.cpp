@@ -57,7 +57,7 @@ namespace tracy
 /* Create a view of SIZE bytes from DESCRIPTOR at OFFSET.  */
 
 int
-backtrace_get_view (struct backtrace_state *state ATTRIBUTE_UNUSED,
+backtrace_get_view (struct backtrace_state *state,
 		    int descriptor, off_t offset, uint64_t size,
 		    backtrace_error_callback error_callback,
 		    void *data, struct backtrace_view *view)
@@ -91,13 +91,15 @@ backtrace_get_view (struct backtrace_state *state ATTRIBUTE_UNUSED,
   view->base = map;
   view->len = size;
 
+  backtrace_own_view (state, view);
+
   return 1;
 }
 
 /* Release a view read by backtrace_get_view.  */
 
 void
-backtrace_release_view (struct backtrace_state *state ATTRIBUTE_UNUSED,
+backtrace_release_view (struct backtrace_state *state,
 			struct backtrace_view *view,
 			backtrace_error_callback error_callback,
 			void *data)
@@ -107,6 +109,8 @@ backtrace_release_view (struct backtrace_state *state ATTRIBUTE_UNUSED,
     void *v;
   } cc;
 
+  backtrace_disown_view (state, view);
+
   cc.cv = view->base;
   if (munmap (cc.v, view->len) < 0)
     error_callback (data, "munmap", errno);
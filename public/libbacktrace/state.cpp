@@ -73,4 +73,12 @@ backtrace_create_state (const char *filename, int threaded,
   return state;
 }
 
+/* Set the number of threads used to index debug info.  */
+
+void
+backtrace_set_index_threads (struct backtrace_state *state, int threads)
+{
+  state->index_threads = threads;
+}
+
 }
@@ -17,6 +17,7 @@
 #define TracyVkZoneTransient(c,x,y,z,w)
 #define TracyVkCollect(c,x)
 #define TracyVkCollectHost(c)
+#define TracyVkEnableReadbackBuffer(c) false
 
 #define TracyVkNamedZoneS(c,x,y,z,w,a)
 #define TracyVkNamedZoneCS(c,x,y,z,w,v,a)
@@ -43,6 +44,7 @@ using TracyVkCtx = void*;
 #include "../client/TracyProfiler.hpp"
 #include "../client/TracyCallstack.hpp"
 
+#include <algorithm>
 #include <atomic>
 
 namespace tracy
@@ -50,16 +52,29 @@ namespace tracy
 
 #if defined TRACY_VK_USE_SYMBOL_TABLE
 #define LoadVkDeviceCoreSymbols(Operation) \
+    Operation(vkAllocateMemory) \
     Operation(vkBeginCommandBuffer) \
+    Operation(vkBindBufferMemory) \
+    Operation(vkCmdCopyQueryPoolResults) \
+    Operation(vkCmdFillBuffer) \
+    Operation(vkCmdPipelineBarrier) \
     Operation(vkCmdResetQueryPool) \
     Operation(vkCmdWriteTimestamp) \
+    Operation(vkCreateBuffer) \
     Operation(vkCreateQueryPool) \
+    Operation(vkDestroyBuffer) \
     Operation(vkDestroyQueryPool) \
     Operation(vkEndCommandBuffer) \
+    Operation(vkFlushMappedMemoryRanges) \
+    Operation(vkFreeMemory) \
+    Operation(vkGetBufferMemoryRequirements) \
     Operation(vkGetQueryPoolResults) \
+    Operation(vkInvalidateMappedMemoryRanges) \
+    Operation(vkMapMemory) \
     Operation(vkQueueSubmit) \
     Operation(vkQueueWaitIdle) \
-    Operation(vkResetQueryPool)
+    Operation(vkResetQueryPool) \
+    Operation(vkUnmapMemory)
 
 #define LoadVkDeviceExtensionSymbols(Operation) \
     Operation(vkGetCalibratedTimestampsEXT)
@@ -68,6 +83,7 @@ namespace tracy
     Operation(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
 
 #define LoadVkInstanceCoreSymbols(Operation) \
+    Operation(vkGetPhysicalDeviceMemoryProperties) \
     Operation(vkGetPhysicalDeviceProperties)
 
 struct VkSymbolTable
@@ -92,6 +108,16 @@ class VkCtx
     friend class VkCtxScope;
 
     enum { QueryCount = 64 * 1024 };
+    enum { ReadbackBatchCount = 64 };
+
+    // A range of queries copied to the readback buffer by a single Collect() call.
+    struct ReadbackBatch
+    {
+        uint64_t first;     // first query, not wrapped
+        uint64_t offset;    // position in the readback ring, not wrapped
+        uint32_t count;
+        uint32_t seq;       // marker value written after the copy completes
+    };
 
 public:
 #if defined TRACY_VK_USE_SYMBOL_TABLE
@@ -100,6 +126,7 @@ public:
     VkCtx( VkPhysicalDevice physdev, VkDevice device, VkQueue queue, VkCommandBuffer cmdbuf, PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT vkGetPhysicalDeviceCalibrateableTimeDomainsEXT, PFN_vkGetCalibratedTimestampsEXT vkGetCalibratedTimestampsEXT)
 #endif
         : m_device( device )
+        , m_physdev( physdev )
         , m_timeDomain( VK_TIME_DOMAIN_DEVICE_EXT )
         , m_context( GetGpuCtxCounter().fetch_add( 1, std::memory_order_relaxed ) )
         , m_head( 0 )
@@ -185,6 +212,7 @@ public:
     VkCtx( VkPhysicalDevice physdev, VkDevice device, PFN_vkResetQueryPoolEXT vkResetQueryPool, PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT vkGetPhysicalDeviceCalibrateableTimeDomainsEXT, PFN_vkGetCalibratedTimestampsEXT vkGetCalibratedTimestampsEXT )
 #endif
         : m_device( device )
+        , m_physdev( physdev )
         , m_timeDomain( VK_TIME_DOMAIN_DEVICE_EXT )
         , m_context( GetGpuCtxCounter().fetch_add(1, std::memory_order_relaxed) )
         , m_head( 0 )
@@ -227,6 +255,12 @@ public:
 
     ~VkCtx()
     {
+        if( m_readback )
+        {
+            VK_FUNCTION_WRAPPER( vkUnmapMemory( m_device, m_readbackMemory ) );
+            VK_FUNCTION_WRAPPER( vkDestroyBuffer( m_device, m_readbackBuffer, nullptr ) );
+            VK_FUNCTION_WRAPPER( vkFreeMemory( m_device, m_readbackMemory, nullptr ) );
+        }
         tracy_free( m_res );
         VK_FUNCTION_WRAPPER( vkDestroyQueryPool( m_device, m_query, nullptr ) );
     }
@@ -247,6 +281,84 @@ public:
         Profiler::QueueSerialFinish();
     }
 
+    /**
+     * Switches Collect() with a command buffer to a readback path. Query results are copied with
+     * vkCmdCopyQueryPoolResults to a persistently mapped host buffer and are picked up by a later
+     * Collect() call, once the GPU has executed the copy. This avoids vkGetQueryPoolResults calls and
+     * queues the timestamps in bulk. Command buffers passed to Collect() must then be submitted, in
+     * the order Collect() was called, to a single queue. Returns false if the buffer can't be created,
+     * in which case the default path stays in use.
+     */
+    bool EnableReadbackBuffer()
+    {
+        if( m_readback ) return true;
+
+        const VkDeviceSize size = sizeof( int64_t ) * ( m_queryCount * 2 + 1 );
+
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if( VK_FUNCTION_WRAPPER( vkCreateBuffer( m_device, &bufferInfo, nullptr, &m_readbackBuffer ) ) != VK_SUCCESS ) return false;
+
+        VkMemoryRequirements req;
+        VK_FUNCTION_WRAPPER( vkGetBufferMemoryRequirements( m_device, m_readbackBuffer, &req ) );
+        VkPhysicalDeviceMemoryProperties prop;
+        VK_FUNCTION_WRAPPER( vkGetPhysicalDeviceMemoryProperties( m_physdev, &prop ) );
+
+        // Host reads from uncached memory are slow, prefer cached memory if there is any.
+        uint32_t memoryType = prop.memoryTypeCount;
+        for( uint32_t i=0; i<prop.memoryTypeCount; i++ )
+        {
+            if( ( req.memoryTypeBits & ( 1u << i ) ) == 0 ) continue;
+            const auto flags = prop.memoryTypes[i].propertyFlags;
+            if( ( flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) == 0 ) continue;
+            if( memoryType == prop.memoryTypeCount || ( flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT ) != 0 )
+            {
+                memoryType = i;
+                if( flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT ) break;
+            }
+        }
+
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = req.size;
+        allocInfo.memoryTypeIndex = memoryType;
+        void* ptr = nullptr;
+        if( memoryType == prop.memoryTypeCount ||
+            VK_FUNCTION_WRAPPER( vkAllocateMemory( m_device, &allocInfo, nullptr, &m_readbackMemory ) ) != VK_SUCCESS )
+        {
+            VK_FUNCTION_WRAPPER( vkDestroyBuffer( m_device, m_readbackBuffer, nullptr ) );
+            return false;
+        }
+        if( VK_FUNCTION_WRAPPER( vkBindBufferMemory( m_device, m_readbackBuffer, m_readbackMemory, 0 ) ) != VK_SUCCESS ||
+            VK_FUNCTION_WRAPPER( vkMapMemory( m_device, m_readbackMemory, 0, VK_WHOLE_SIZE, 0, &ptr ) ) != VK_SUCCESS )
+        {
+            VK_FUNCTION_WRAPPER( vkDestroyBuffer( m_device, m_readbackBuffer, nullptr ) );
+            VK_FUNCTION_WRAPPER( vkFreeMemory( m_device, m_readbackMemory, nullptr ) );
+            return false;
+        }
+        m_readbackCoherent = ( prop.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) != 0;
+
+        memset( ptr, 0, size );
+        if( !m_readbackCoherent )
+        {
+            VkMappedMemoryRange range = {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = m_readbackMemory;
+            range.size = VK_WHOLE_SIZE;
+            VK_FUNCTION_WRAPPER( vkFlushMappedMemoryRanges( m_device, 1, &range ) );
+        }
+
+        m_readback = (int64_t*)ptr;
+        m_readbackSeq = 0;
+        m_copied = m_tail;
+        m_ringHead = m_ringTail = 0;
+        m_batchHead = m_batchTail = 0;
+        return true;
+    }
+
     void Collect( VkCommandBuffer cmdbuf )
     {
         ZoneScopedC( Color::Red4 );
@@ -261,6 +373,7 @@ public:
                 VK_FUNCTION_WRAPPER( vkCmdResetQueryPool( cmdbuf, m_query, 0, m_queryCount ) ) :
                 VK_FUNCTION_WRAPPER( vkResetQueryPool( m_device, m_query, 0, m_queryCount ) );
             m_tail = head;
+            m_copied = head;
             m_oldCnt = 0;
             int64_t tgpu;
             if( m_timeDomain != VK_TIME_DOMAIN_DEVICE_EXT ) Calibrate( m_device, m_prevCalibration, tgpu );
@@ -269,44 +382,46 @@ public:
 #endif
         assert( head > m_tail );
 
-        const unsigned int wrappedTail = (unsigned int)( m_tail % m_queryCount );
-
-        unsigned int cnt;
-        if( m_oldCnt != 0 )
+        if( m_readback && cmdbuf )
         {
-            cnt = m_oldCnt;
-            m_oldCnt = 0;
+            CollectReadback( cmdbuf, head );
         }
         else
         {
-            cnt = (unsigned int)( head - m_tail );
-            assert( cnt <= m_queryCount );
-            if( wrappedTail + cnt > m_queryCount )
+            const unsigned int wrappedTail = (unsigned int)( m_tail % m_queryCount );
+
+            unsigned int cnt;
+            if( m_oldCnt != 0 )
             {
-                cnt = m_queryCount - wrappedTail;
+                cnt = m_oldCnt;
+                m_oldCnt = 0;
+            }
+            else
+            {
+                cnt = (unsigned int)( head - m_tail );
+                assert( cnt <= m_queryCount );
+                if( wrappedTail + cnt > m_queryCount )
+                {
+                    cnt = m_queryCount - wrappedTail;
+                }
             }
-        }
-
 
-        VK_FUNCTION_WRAPPER( vkGetQueryPoolResults( m_device, m_query, wrappedTail, cnt, sizeof( int64_t ) * m_queryCount * 2, m_res, sizeof( int64_t ) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT ) );
+            VK_FUNCTION_WRAPPER( vkGetQueryPoolResults( m_device, m_query, wrappedTail, cnt, sizeof( int64_t ) * m_queryCount * 2, m_res, sizeof( int64_t ) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT ) );
 
-        for( unsigned int idx=0; idx<cnt; idx++ )
-        {
-            int64_t avail = m_res[idx * 2 + 1];
-            if( avail == 0 )
+            unsigned int avail = 0;
+            while( avail < cnt && m_res[avail * 2 + 1] != 0 ) avail++;
+            if( avail != cnt )
             {
-                m_oldCnt = cnt - idx;
-                cnt = idx;
-
-                break;
+                m_oldCnt = cnt - avail;
+                cnt = avail;
             }
+            if( cnt != 0 ) WriteGpuTimes( m_res, wrappedTail, cnt );
 
-            auto item = Profiler::QueueSerial();
-            MemWrite( &item->hdr.type, QueueType::GpuTime );
-            MemWrite( &item->gpuTime.gpuTime, m_res[idx * 2] );
-            MemWrite( &item->gpuTime.queryId, uint16_t( wrappedTail + idx ) );
-            MemWrite( &item->gpuTime.context, m_context );
-            Profiler::QueueSerialFinish();
+            cmdbuf ?
+                VK_FUNCTION_WRAPPER( vkCmdResetQueryPool( cmdbuf, m_query, wrappedTail, cnt ) ) :
+                VK_FUNCTION_WRAPPER( vkResetQueryPool( m_device, m_query, wrappedTail, cnt ) );
+
+            m_tail += cnt;
         }
 
         if( m_timeDomain != VK_TIME_DOMAIN_DEVICE_EXT )
@@ -327,12 +442,6 @@ public:
                 Profiler::QueueSerialFinish();
             }
         }
-
-        cmdbuf ?
-            VK_FUNCTION_WRAPPER( vkCmdResetQueryPool( cmdbuf, m_query, wrappedTail, cnt ) ) :
-            VK_FUNCTION_WRAPPER( vkResetQueryPool( m_device, m_query, wrappedTail, cnt ) );
-
-        m_tail += cnt;
     }
 
     tracy_force_inline unsigned int NextQueryId()
@@ -352,6 +461,103 @@ public:
     }
 
 private:
+    // Results are interleaved with availability values, as returned with VK_QUERY_RESULT_WITH_AVAILABILITY_BIT.
+    tracy_force_inline void WriteGpuTimes( const int64_t* res, unsigned int queryId, unsigned int cnt )
+    {
+        auto item = Profiler::QueueSerialBatch( cnt );
+        for( unsigned int idx=0; idx<cnt; idx++ )
+        {
+            MemWrite( &item->hdr.type, QueueType::GpuTime );
+            MemWrite( &item->gpuTime.gpuTime, res[idx * 2] );
+            MemWrite( &item->gpuTime.queryId, uint16_t( queryId + idx ) );
+            MemWrite( &item->gpuTime.context, m_context );
+            item++;
+        }
+        Profiler::QueueSerialFinish( cnt );
+    }
+
+    // The readback buffer is a ring of m_queryCount result/availability pairs, followed by a marker that
+    // is written after each batch of copies. Batches are consumed once the marker shows that the GPU has
+    // executed them. Queries still unavailable at copy time are copied again by the next call.
+    void CollectReadback( VkCommandBuffer cmdbuf, uint64_t head )
+    {
+        // Results are read one collection later than on the default path, which needs more room in the pool.
+        assert( head - m_tail <= m_queryCount );
+
+        if( !m_readbackCoherent )
+        {
+            VkMappedMemoryRange range = {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = m_readbackMemory;
+            range.size = VK_WHOLE_SIZE;
+            VK_FUNCTION_WRAPPER( vkInvalidateMappedMemoryRanges( m_device, 1, &range ) );
+        }
+        const auto done = *(volatile uint32_t*)( m_readback + m_queryCount * 2 );
+
+        const uint64_t oldTail = m_tail;
+        while( m_batchTail != m_batchHead )
+        {
+            const auto& batch = m_batches[m_batchTail % ReadbackBatchCount];
+            if( int32_t( done - batch.seq ) < 0 ) break;
+            if( batch.first <= m_tail && m_tail < batch.first + batch.count )
+            {
+                const auto skip = uint32_t( m_tail - batch.first );
+                const auto max = batch.count - skip;
+                const int64_t* res = m_readback + ( batch.offset % m_queryCount + skip ) * 2;
+                unsigned int cnt = 0;
+                while( cnt < max && res[cnt * 2 + 1] != 0 ) cnt++;
+                if( cnt != 0 )
+                {
+                    WriteGpuTimes( res, (unsigned int)( m_tail % m_queryCount ), cnt );
+                    m_tail += cnt;
+                }
+                if( cnt != max ) m_copied = m_tail;
+            }
+            m_ringTail = batch.offset + batch.count;
+            m_batchTail++;
+        }
+
+        // Copies recorded by earlier calls have to finish reading the queries before they are reset.
+        if( m_tail != oldTail ) VK_FUNCTION_WRAPPER( vkCmdPipelineBarrier( cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr ) );
+        for( uint64_t pos = oldTail; pos != m_tail; )
+        {
+            const auto wrapped = (unsigned int)( pos % m_queryCount );
+            const auto cnt = (unsigned int)std::min<uint64_t>( m_tail - pos, m_queryCount - wrapped );
+            VK_FUNCTION_WRAPPER( vkCmdResetQueryPool( cmdbuf, m_query, wrapped, cnt ) );
+            pos += cnt;
+        }
+
+        if( m_copied < m_tail ) m_copied = m_tail;
+        bool recorded = false;
+        while( m_copied < head && m_batchHead - m_batchTail < ReadbackBatchCount )
+        {
+            const auto wrapped = (unsigned int)( m_copied % m_queryCount );
+            const auto ring = (unsigned int)( m_ringHead % m_queryCount );
+            uint64_t cnt = head - m_copied;
+            cnt = std::min<uint64_t>( cnt, m_queryCount - wrapped );
+            cnt = std::min<uint64_t>( cnt, m_queryCount - ring );
+            cnt = std::min<uint64_t>( cnt, m_queryCount - ( m_ringHead - m_ringTail ) );
+            if( cnt == 0 ) break;
+
+            VK_FUNCTION_WRAPPER( vkCmdCopyQueryPoolResults( cmdbuf, m_query, wrapped, (uint32_t)cnt, m_readbackBuffer, sizeof( int64_t ) * 2 * ring, sizeof( int64_t ) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT ) );
+            m_batches[m_batchHead % ReadbackBatchCount] = { m_copied, m_ringHead, (uint32_t)cnt, m_readbackSeq + 1 };
+            m_batchHead++;
+            m_copied += cnt;
+            m_ringHead += cnt;
+            recorded = true;
+        }
+        if( !recorded ) return;
+
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        VK_FUNCTION_WRAPPER( vkCmdPipelineBarrier( cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr ) );
+        VK_FUNCTION_WRAPPER( vkCmdFillBuffer( cmdbuf, m_readbackBuffer, sizeof( int64_t ) * 2 * m_queryCount, sizeof( uint32_t ), ++m_readbackSeq ) );
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        VK_FUNCTION_WRAPPER( vkCmdPipelineBarrier( cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr ) );
+    }
+
     tracy_force_inline void Calibrate( VkDevice device, int64_t& tCpu, int64_t& tGpu )
     {
         assert( m_timeDomain != VK_TIME_DOMAIN_DEVICE_EXT );
@@ -487,6 +693,7 @@ private:
 #endif
 
     VkDevice m_device;
+    VkPhysicalDevice m_physdev;
     VkQueryPool m_query;
     VkTimeDomainEXT m_timeDomain;
 #if defined TRACY_VK_USE_SYMBOL_TABLE
@@ -506,6 +713,18 @@ private:
 
     int64_t* m_res;
 
+    int64_t* m_readback = nullptr;
+    VkBuffer m_readbackBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_readbackMemory = VK_NULL_HANDLE;
+    bool m_readbackCoherent = false;
+    uint32_t m_readbackSeq = 0;
+    uint64_t m_copied = 0;
+    uint64_t m_ringHead = 0;
+    uint64_t m_ringTail = 0;
+    uint64_t m_batchHead = 0;
+    uint64_t m_batchTail = 0;
+    ReadbackBatch m_batches[ReadbackBatchCount];
+
     PFN_vkGetCalibratedTimestampsEXT m_vkGetCalibratedTimestampsEXT;
 };
 
@@ -727,6 +946,7 @@ using TracyVkCtx = tracy::VkCtx*;
 #endif
 #define TracyVkCollect( ctx, cmdbuf ) ctx->Collect( cmdbuf );
 #define TracyVkCollectHost( ctx ) ctx->Collect( VK_NULL_HANDLE );
+#define TracyVkEnableReadbackBuffer( ctx ) ctx->EnableReadbackBuffer()
 
 #ifdef TRACY_HAS_CALLSTACK
 #  define TracyVkNamedZoneS( ctx, varname, cmdbuf, name, depth, active ) static constexpr tracy::SourceLocationData TracyConcat(__tracy_gpu_source_location,TracyLine) { name, TracyFunction,  TracyFile, (uint32_t)TracyLine, 0 }; tracy::VkCtxScope varname( ctx, &TracyConcat(__tracy_gpu_source_location,TracyLine), cmdbuf, depth, active );
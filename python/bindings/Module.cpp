@@ -1,4 +1,5 @@
 #include "Memory.hpp"
+#include "Monitoring.hpp"
 #include "ScopedZone.hpp"
 #include "tracy/TracyC.h"
 
@@ -788,11 +789,19 @@ PYBIND11_MODULE(TracyClientBindings, m) {
       "data"_a.none(false), "width"_a.none(false), "height"_a.none(false),
       "offset"_a.none(false) = 0, "flip"_a.none(false) = false);
 
+  py::class_<PySourceLocation>(m, "_SourceLocation")
+      .def(py::init<const OptionalString &, uint32_t, const std::string &,
+                    const std::string &, uint32_t>(),
+           "name"_a, "color"_a.none(false), "function"_a.none(false),
+           "file"_a.none(false), "line"_a.none(false));
+
   py::class_<PyScopedZone, std::shared_ptr<PyScopedZone>>(m, "_ScopedZone")
       .def(py::init<const OptionalString &, uint32_t, OptionalInt, bool,
                     const std::string &, const std::string &, uint32_t>(),
            "name"_a, "color"_a.none(false), "depth"_a, "active"_a.none(false),
            "function"_a.none(false), "file"_a.none(false), "line"_a.none(false))
+      .def(py::init<const PySourceLocation &, OptionalInt, bool>(),
+           "srcloc"_a.none(false), "depth"_a, "active"_a.none(false))
       .def_property_readonly("is_active", &PyScopedZone::IsActive)
       .def("text", &PyScopedZone::Text<std::string>, "text"_a.none(false))
       .def("text", &PyScopedZone::Text<py::object>, "text"_a.none(false))
@@ -801,6 +810,25 @@ PYBIND11_MODULE(TracyClientBindings, m) {
       .def("enter", &PyScopedZone::Enter)
       .def("exit", &PyScopedZone::Exit);
 
+  m.def("_zone_call", &ZoneCall, "srcloc"_a.none(false), "depth"_a,
+        "function"_a.none(false));
+
+  m.def("_monitor_configure", &FunctionMonitor::Configure, "filter"_a,
+        "depth"_a);
+  m.def("_monitor_stop", &FunctionMonitor::Stop);
+  m.def("_monitor_start", [](const py::object &code, const py::args &) {
+    return FunctionMonitor::Start(code, true);
+  });
+  m.def("_monitor_throw", [](const py::object &code, const py::args &) {
+    return FunctionMonitor::Start(code, false);
+  });
+  m.def("_monitor_end", [](const py::object &code, const py::args &) {
+    return FunctionMonitor::End(code, true);
+  });
+  m.def("_monitor_unwind", [](const py::object &code, const py::args &) {
+    return FunctionMonitor::End(code, false);
+  });
+
   m.def("alloc", &MemoryAllocate<>, "ptr"_a.none(false), "size"_a.none(false),
         "name"_a = static_cast<OptionalString>(std::nullopt),
         "id"_a = static_cast<OptionalNumber>(std::nullopt),
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SourceLocation.hpp"
+#include "tracy/TracyC.h"
+
+// Callbacks for the sys.monitoring (PEP 669) based function profiler. Every
+// Python function that starts or resumes opens a zone, every return, yield or
+// unwind closes it. Source locations are resolved once per code object, the
+// callbacks are only called with the GIL held. The monitored frame is the
+// current frame while a callback runs, zones are tagged with it so that only
+// the frame that opened a zone can close it.
+
+#ifdef TRACY_ENABLE
+class FunctionMonitor {
+ public:
+  static void Configure(const py::object& filter,
+                        std::optional<int32_t> depth) {
+    auto& monitor = Instance();
+#if defined TRACY_HAS_CALLSTACK && defined TRACY_CALLSTACK
+    if (!depth) depth = TRACY_CALLSTACK;
+#endif
+    monitor.m_filter = filter;
+    monitor.m_depth = depth ? *depth : 0;
+    for (auto& v : monitor.m_code) Py_DECREF(v.first);
+    monitor.m_code.clear();
+    if (!monitor.m_disable)
+      monitor.m_disable =
+          py::module_::import("sys").attr("monitoring").attr("DISABLE");
+  }
+
+  // Only local events (start, resume, return, yield) may be disabled for a
+  // code object, throw and unwind have to keep returning None.
+  static py::object Start(const py::handle& code, bool local) {
+    auto& monitor = Instance();
+    auto srcloc = monitor.Lookup(code);
+    if (!srcloc) return local ? monitor.m_disable : py::none();
+    Stack().push_back(
+        {___tracy_emit_zone_begin_callstack(
+             reinterpret_cast<const ___tracy_source_location_data*>(srcloc),
+             monitor.m_depth, 1),
+         PyEval_GetFrame()});
+    return py::none();
+  }
+
+  static py::object End(const py::handle& code, bool local) {
+    auto& monitor = Instance();
+    auto it = monitor.m_code.find(code.ptr());
+    if (it != monitor.m_code.end() && !it->second)
+      return local ? monitor.m_disable : py::none();
+    // Frames that were already running when monitoring was enabled end
+    // without a matching start, their code may still have been seen in a
+    // later call.
+    auto& stack = Stack();
+    if (it == monitor.m_code.end() || stack.empty() ||
+        stack.back().frame != PyEval_GetFrame())
+      return py::none();
+    ___tracy_emit_zone_end(stack.back().ctx);
+    stack.pop_back();
+    return py::none();
+  }
+
+  // Closes the zones still open on the calling thread, their ends will not be
+  // reported once monitoring is turned off.
+  static void Stop() {
+    auto& stack = Stack();
+    while (!stack.empty()) {
+      ___tracy_emit_zone_end(stack.back().ctx);
+      stack.pop_back();
+    }
+  }
+
+ private:
+  const tracy::SourceLocationData* Lookup(const py::handle& code) {
+    auto it = m_code.find(code.ptr());
+    if (it != m_code.end()) return it->second;
+
+    const tracy::SourceLocationData* srcloc = nullptr;
+    if (m_filter.is_none() || m_filter(code).cast<bool>()) {
+      srcloc = SourceLocationCache::Get(
+          std::nullopt, code.attr("co_qualname").cast<std::string>(),
+          code.attr("co_filename").cast<std::string>(),
+          code.attr("co_firstlineno").cast<uint32_t>(), 0);
+    }
+    // Code objects are kept alive, so that their addresses are not reused.
+    Py_INCREF(code.ptr());
+    m_code.emplace(code.ptr(), srcloc);
+    return srcloc;
+  }
+
+  struct Zone {
+    TracyCZoneCtx ctx;
+    // Only compared, never dereferenced. A zone is closed before its frame
+    // goes away, so the address cannot be reused while the zone is open.
+    const PyFrameObject* frame;
+  };
+
+  static std::vector<Zone>& Stack() {
+    thread_local std::vector<Zone> stack;
+    return stack;
+  }
+
+  static FunctionMonitor& Instance() {
+    static auto monitor = new FunctionMonitor;
+    return *monitor;
+  }
+
+  py::object m_filter = py::none();
+  py::object m_disable;
+  int32_t m_depth = 0;
+  std::unordered_map<PyObject*, const tracy::SourceLocationData*> m_code;
+};
+#else
+
+class FunctionMonitor {
+ public:
+  static void Configure(const py::object&, std::optional<int32_t>) {}
+  static py::object Start(const py::handle&, bool) { return py::none(); }
+  static py::object End(const py::handle&, bool) { return py::none(); }
+  static void Stop() {}
+};
+#endif
@@ -9,6 +9,7 @@ using namespace pybind11::literals;
 #include <optional>
 #include <string>
 
+#include "SourceLocation.hpp"
 #include "tracy/Tracy.hpp"
 
 #ifdef TRACY_ENABLE
@@ -30,15 +31,13 @@ class PyScopedZone {
                std::optional<int32_t> depth, bool active,
                const std::string& function, const std::string& source,
                uint32_t line)
-      : m_name(name),
-        m_color(color),
-        m_depth(depth),
-        m_active(active),
-        m_function(function),
-        m_source(source),
-        m_line(line) {
+      : PyScopedZone(PySourceLocation(name, color, function, source, line),
+                     depth, active) {}
+  PyScopedZone(const PySourceLocation& srcloc, std::optional<int32_t> depth,
+               bool active)
+      : m_srcloc(srcloc.Data()), m_depth(depth), m_active(active) {
 #if defined TRACY_HAS_CALLSTACK && defined TRACY_CALLSTACK
-    if (!depth) depth = TRACY_CALLSTACK;
+    if (!m_depth) m_depth = TRACY_CALLSTACK;
 #endif
   }
   virtual ~PyScopedZone() { Exit(); };
@@ -50,9 +49,11 @@ class PyScopedZone {
 
   template <typename Type>
   bool Text(const Type& text) {
-    return SetText(text, m_zone);
+    return SetText(text, m_zone ? &*m_zone : nullptr);
   }
 
+  // Names and colors set at runtime are sent with each zone instead of being
+  // interned, as they may change with every use.
   bool Name(const std::string& name) {
     if (name.size() >= std::numeric_limits<uint16_t>::max()) return false;
     m_name = name;
@@ -64,45 +65,47 @@ class PyScopedZone {
   void Color(uint32_t color) {
     m_color = color;
     if (!m_zone) return;
-    m_zone->Color(m_color);
+    m_zone->Color(*m_color);
   }
 
   void Enter() {
-    if (m_depth)
-      m_zone = new tracy::ScopedZone(
-          m_line, m_source.c_str(), m_source.size(), m_function.c_str(),
-          m_function.size(), m_name ? m_name->c_str() : nullptr,
-          m_name ? m_name->size() : 0ul, m_color, *m_depth, m_active);
-    else
-      m_zone = new tracy::ScopedZone(
-          m_line, m_source.c_str(), m_source.size(), m_function.c_str(),
-          m_function.size(), m_name ? m_name->c_str() : nullptr,
-          m_name ? m_name->size() : 0ul, m_color, -1, m_active);
+    m_zone.emplace(m_srcloc, m_depth ? *m_depth : -1, m_active);
+    if (m_name) m_zone->Name(m_name->c_str(), m_name->size());
+    if (m_color) m_zone->Color(*m_color);
   }
 
-  void Exit() {
-    if (m_zone) delete m_zone;
-    m_zone = nullptr;
-  }
+  void Exit() { m_zone.reset(); }
 
  private:
-  std::optional<std::string> m_name;
-  uint32_t m_color;
+  const tracy::SourceLocationData* m_srcloc;
   std::optional<int32_t> m_depth;
   bool m_active;
 
-  std::string m_function;
-  std::string m_source;
-  uint32_t m_line;
+  std::optional<std::string> m_name;
+  std::optional<uint32_t> m_color;
 
-  tracy::ScopedZone* m_zone;
+  std::optional<tracy::ScopedZone> m_zone;
 };
+
+// Calls a function inside a zone. Used by the zone decorator, so that the hot
+// path does not touch any strings and the zone is closed on exceptions too.
+inline py::object ZoneCall(const PySourceLocation& srcloc,
+                           std::optional<int32_t> depth,
+                           const py::function& function, const py::args& args,
+                           const py::kwargs& kwargs) {
+#if defined TRACY_HAS_CALLSTACK && defined TRACY_CALLSTACK
+  if (!depth) depth = TRACY_CALLSTACK;
+#endif
+  tracy::ScopedZone zone(srcloc.Data(), depth ? *depth : -1, true);
+  return function(*args, **kwargs);
+}
 #else
 
 class PyScopedZone {
  public:
   PyScopedZone(const std::optional<std::string>&, uint32_t, std::optional<int32_t>,
                bool, const std::string&, const std::string&, uint32_t line) {}
+  PyScopedZone(const PySourceLocation&, std::optional<int32_t>, bool) {}
   virtual ~PyScopedZone(){};
 
   bool IsActive() const { return false; }
@@ -117,4 +120,10 @@ class PyScopedZone {
   void Enter() {}
   void Exit() {}
 };
+
+inline py::object ZoneCall(const PySourceLocation&, std::optional<int32_t>,
+                           const py::function& function, const py::args& args,
+                           const py::kwargs& kwargs) {
+  return function(*args, **kwargs);
+}
 #endif
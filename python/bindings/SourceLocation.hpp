@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "tracy/Tracy.hpp"
+
+#ifdef TRACY_ENABLE
+// Tracy refers to a source location by its address for the whole lifetime of
+// the program. Python zones intern their source locations here once, instead
+// of sending a freshly allocated copy of all strings with every zone. Entries
+// are never released.
+class SourceLocationCache {
+ public:
+  static const tracy::SourceLocationData* Get(
+      const std::optional<std::string>& name, const std::string& function,
+      const std::string& file, uint32_t line, uint32_t color) {
+    std::string key;
+    key.reserve(function.size() + file.size() + (name ? name->size() : 0) +
+                32);
+    key.append(function).push_back('\0');
+    key.append(file).push_back('\0');
+    key.append(std::to_string(line)).push_back(':');
+    key.append(std::to_string(color));
+    if (name) key.append("\0", 1).append(*name);
+
+    auto& cache = Instance();
+    std::lock_guard<std::mutex> lock(cache.m_lock);
+    auto it = cache.m_entries.find(key);
+    if (it != cache.m_entries.end()) return &it->second->data;
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->function = function;
+    entry->file = file;
+    entry->data = {entry->name ? entry->name->c_str() : nullptr,
+                   entry->function.c_str(), entry->file.c_str(), line, color};
+    auto ptr = &entry->data;
+    cache.m_entries.emplace(std::move(key), std::move(entry));
+    return ptr;
+  }
+
+ private:
+  struct Entry {
+    std::optional<std::string> name;
+    std::string function;
+    std::string file;
+    tracy::SourceLocationData data;
+  };
+
+  static SourceLocationCache& Instance() {
+    // Intentionally leaked, the profiler may still reference the entries
+    // while static destructors run.
+    static auto cache = new SourceLocationCache;
+    return *cache;
+  }
+
+  std::mutex m_lock;
+  std::unordered_map<std::string, std::unique_ptr<Entry>> m_entries;
+};
+
+class PySourceLocation {
+ public:
+  PySourceLocation(const std::optional<std::string>& name, uint32_t color,
+                   const std::string& function, const std::string& file,
+                   uint32_t line)
+      : m_data(SourceLocationCache::Get(name, function, file, line, color)) {}
+
+  const tracy::SourceLocationData* Data() const { return m_data; }
+
+ private:
+  const tracy::SourceLocationData* m_data;
+};
+#else
+
+class PySourceLocation {
+ public:
+  PySourceLocation(const std::optional<std::string>&, uint32_t,
+                   const std::string&, const std::string&, uint32_t) {}
+};
+#endif
@@ -0,0 +1,225 @@
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstring>
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+#include "TraceReader.hpp"
+
+namespace {
+
+py::object ToString(const char *str) {
+  if (!str) return py::none();
+  return py::reinterpret_steal<py::object>(
+      PyUnicode_DecodeUTF8(str, strlen(str), "replace"));
+}
+
+// Hands out a materialized column without copying it. The capsule keeps the
+// whole table alive for as long as any of its arrays is referenced.
+template <typename Table, typename T>
+py::array Column(const std::shared_ptr<const Table> &table,
+                 const std::vector<T> &column) {
+  auto owner = new std::shared_ptr<const Table>(table);
+  py::capsule base(owner, [](void *ptr) {
+    delete static_cast<std::shared_ptr<const Table> *>(ptr);
+  });
+  py::array_t<T> array(column.size(), column.data(), base);
+  array.attr("setflags")("write"_a = false);
+  return array;
+}
+
+// Strided view directly into the trace data, for fields whose in-memory
+// representation already is a plain number. The trace object is the base.
+template <typename T>
+py::array View(const py::object &self, const void *data, size_t count,
+               size_t offset, size_t stride) {
+  if (count == 0) return py::array_t<T>(0);
+  py::array_t<T> array(
+      {static_cast<py::ssize_t>(count)}, {static_cast<py::ssize_t>(stride)},
+      reinterpret_cast<const T *>(static_cast<const char *>(data) + offset),
+      self);
+  array.attr("setflags")("write"_a = false);
+  return array;
+}
+
+template <typename Get>
+auto Materialize(Get &&get) {
+  py::gil_scoped_release release;
+  return get();
+}
+
+}  // namespace
+
+PYBIND11_MODULE(TracyTraceBindings, m) {
+  py::class_<TraceReader, std::shared_ptr<TraceReader>>(m, "Trace")
+      .def(py::init([](const std::string &path) {
+             py::gil_scoped_release release;
+             return std::make_shared<TraceReader>(path);
+           }),
+           "path"_a.none(false))
+      .def_property_readonly("capture_name", &TraceReader::CaptureName)
+      .def_property_readonly("first_time", &TraceReader::FirstTime)
+      .def_property_readonly("last_time", &TraceReader::LastTime)
+      .def("string",
+           [](TraceReader &self, uint32_t idx) {
+             return ToString(self.String(idx));
+           },
+           "idx"_a.none(false))
+      .def("strings",
+           [](TraceReader &self, const py::array_t<uint32_t> &indices) {
+             auto idx = indices.unchecked<1>();
+             py::list out(idx.shape(0));
+             for (py::ssize_t i = 0; i < idx.shape(0); i++)
+               out[i] = ToString(self.String(idx(i)));
+             return out;
+           },
+           "indices"_a.none(false))
+      .def("threads",
+           [](TraceReader &self) {
+             auto t = Materialize([&] { return self.Threads(); });
+             py::dict out;
+             out["id"] = Column(t, t->id);
+             out["name"] = Column(t, t->name);
+             out["zones"] = Column(t, t->zones);
+             out["samples"] = Column(t, t->samples);
+             return out;
+           })
+      .def("source_locations",
+           [](TraceReader &self) {
+             auto t = Materialize([&] { return self.SourceLocations(); });
+             py::dict out;
+             out["id"] = Column(t, t->id);
+             out["name"] = Column(t, t->name);
+             out["function"] = Column(t, t->function);
+             out["file"] = Column(t, t->file);
+             out["line"] = Column(t, t->line);
+             out["color"] = Column(t, t->color);
+             out["count"] = Column(t, t->count);
+             out["total"] = Column(t, t->total);
+             return out;
+           })
+      .def("zones",
+           [](TraceReader &self, uint64_t thread) {
+             auto t = Materialize([&] { return self.Zones(thread); });
+             py::dict out;
+             out["start"] = Column(t, t->start);
+             out["end"] = Column(t, t->end);
+             out["srcloc"] = Column(t, t->srcloc);
+             out["depth"] = Column(t, t->depth);
+             out["parent"] = Column(t, t->parent);
+             out["text"] = Column(t, t->text);
+             out["name"] = Column(t, t->name);
+             return out;
+           },
+           "thread"_a.none(false))
+      .def("source_location_zones",
+           [](TraceReader &self, int16_t srcloc) {
+             auto t = Materialize(
+                 [&] { return self.ZonesForSourceLocation(srcloc); });
+             py::dict out;
+             out["start"] = Column(t, t->start);
+             out["end"] = Column(t, t->end);
+             out["thread"] = Column(t, t->thread);
+             out["text"] = Column(t, t->text);
+             return out;
+           },
+           "srcloc"_a.none(false))
+      .def("plots",
+           [](TraceReader &self) {
+             py::list out;
+             for (size_t i = 0; i < self.PlotCount(); i++)
+               out.append(ToString(self.PlotName(i)));
+             return out;
+           })
+      .def("plot",
+           [](const py::object &pyself, size_t idx) {
+             auto &self = pyself.cast<TraceReader &>();
+             auto plot = self.Plot(idx);
+             auto t = Materialize([&] { return self.PlotTimes(idx); });
+             py::dict out;
+             out["time"] = Column(t, t->time);
+             out["value"] =
+                 View<double>(pyself, plot->data.data(), plot->data.size(),
+                              sizeof(tracy::Int48), sizeof(tracy::PlotItem));
+             return out;
+           },
+           "idx"_a.none(false))
+      .def("samples",
+           [](TraceReader &self, uint64_t thread) {
+             auto t = Materialize([&] { return self.Samples(thread); });
+             py::dict out;
+             out["time"] = Column(t, t->time);
+             out["callstack"] = Column(t, t->callstack);
+             return out;
+           },
+           "thread"_a.none(false))
+      .def("callstack",
+           [](TraceReader &self, uint32_t idx) {
+             py::list out;
+             for (auto &frame : self.Callstack(idx)) {
+               out.append(py::make_tuple(ToString(self.String(frame.function)),
+                                         ToString(self.String(frame.file)),
+                                         frame.line, frame.inlined));
+             }
+             return out;
+           },
+           "idx"_a.none(false))
+      .def("memory_pools",
+           [](TraceReader &self) {
+             py::dict out;
+             for (auto pool : self.MemoryPools())
+               out[py::int_(pool)] = ToString(self.MemoryPoolName(pool));
+             return out;
+           })
+      .def("memory",
+           [](TraceReader &self, uint64_t pool) {
+             auto t = Materialize([&] { return self.Memory(pool); });
+             py::dict out;
+             out["ptr"] = Column(t, t->ptr);
+             out["size"] = Column(t, t->size);
+             out["time_alloc"] = Column(t, t->time_alloc);
+             out["time_free"] = Column(t, t->time_free);
+             out["thread_alloc"] = Column(t, t->thread_alloc);
+             out["thread_free"] = Column(t, t->thread_free);
+             out["cs_alloc"] = Column(t, t->cs_alloc);
+             out["cs_free"] = Column(t, t->cs_free);
+             return out;
+           },
+           "pool"_a.none(false) = 0)
+      .def("messages",
+           [](TraceReader &self) {
+             auto t = Materialize([&] { return self.Messages(); });
+             py::dict out;
+             out["time"] = Column(t, t->time);
+             out["thread"] = Column(t, t->thread);
+             out["text"] = Column(t, t->text);
+             out["color"] = Column(t, t->color);
+             out["callstack"] = Column(t, t->callstack);
+             return out;
+           })
+      .def("frame_sets",
+           [](TraceReader &self) {
+             py::list out;
+             for (size_t i = 0; i < self.FrameSetCount(); i++)
+               out.append(ToString(self.FrameSetName(i)));
+             return out;
+           })
+      .def("frames",
+           [](const py::object &pyself, size_t idx) {
+             auto &self = pyself.cast<TraceReader &>();
+             const auto &frames = self.FrameSet(idx)->frames;
+             py::dict out;
+             out["start"] =
+                 View<int64_t>(pyself, frames.data(), frames.size(),
+                               offsetof(tracy::FrameEvent, start),
+                               sizeof(tracy::FrameEvent));
+             out["end"] = View<int64_t>(pyself, frames.data(), frames.size(),
+                                        offsetof(tracy::FrameEvent, end),
+                                        sizeof(tracy::FrameEvent));
+             return out;
+           },
+           "idx"_a.none(false) = 0);
+}
@@ -0,0 +1,454 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TracyFileRead.hpp"
+#include "TracyWorker.hpp"
+
+// Columnar, read-only access to a saved trace. Each table is materialized once,
+// on first request, and the resulting vectors are shared with every consumer
+// (the Python bindings hand them out as NumPy arrays without copying). Strings
+// are referenced by index into a per-reader string table, so that no per-row
+// objects need to be created.
+
+constexpr uint32_t NoString = 0xFFFFFFFF;
+
+struct ThreadColumns {
+  std::vector<uint64_t> id;
+  std::vector<uint64_t> zones;
+  std::vector<uint64_t> samples;
+  std::vector<uint32_t> name;
+};
+
+struct SourceLocationColumns {
+  std::vector<int16_t> id;
+  std::vector<uint32_t> name;
+  std::vector<uint32_t> function;
+  std::vector<uint32_t> file;
+  std::vector<uint32_t> line;
+  std::vector<uint32_t> color;
+  std::vector<uint64_t> count;
+  std::vector<int64_t> total;
+};
+
+// Zones of a single thread, in pre-order. Parent is the row index of the
+// enclosing zone, or -1 for top-level zones.
+struct ZoneColumns {
+  std::vector<int64_t> start;
+  std::vector<int64_t> end;
+  std::vector<int16_t> srcloc;
+  std::vector<uint16_t> depth;
+  std::vector<int32_t> parent;
+  std::vector<uint32_t> text;
+  std::vector<uint32_t> name;
+};
+
+// Zones of a single source location, sorted by start time.
+struct SrcLocZoneColumns {
+  std::vector<int64_t> start;
+  std::vector<int64_t> end;
+  std::vector<uint64_t> thread;
+  std::vector<uint32_t> text;
+};
+
+struct PlotColumns {
+  std::vector<int64_t> time;
+};
+
+struct SampleColumns {
+  std::vector<int64_t> time;
+  std::vector<uint32_t> callstack;
+};
+
+struct MemoryColumns {
+  std::vector<uint64_t> ptr;
+  std::vector<uint64_t> size;
+  std::vector<int64_t> time_alloc;
+  std::vector<int64_t> time_free;
+  std::vector<uint64_t> thread_alloc;
+  std::vector<uint64_t> thread_free;
+  std::vector<uint32_t> cs_alloc;
+  std::vector<uint32_t> cs_free;
+};
+
+struct MessageColumns {
+  std::vector<int64_t> time;
+  std::vector<uint64_t> thread;
+  std::vector<uint32_t> text;
+  std::vector<uint32_t> color;
+  std::vector<uint32_t> callstack;
+};
+
+struct CallstackEntry {
+  uint32_t function;
+  uint32_t file;
+  uint32_t line;
+  bool inlined;
+};
+
+class TraceReader {
+ public:
+  explicit TraceReader(const std::string &path) {
+    std::unique_ptr<tracy::FileRead> file(tracy::FileRead::Open(path.c_str()));
+    if (!file) throw std::runtime_error("Cannot open trace file: " + path);
+    try {
+      m_worker = std::make_unique<tracy::Worker>(*file);
+    } catch (const tracy::UnsupportedVersion &e) {
+      throw std::runtime_error("Trace file version " +
+                               std::to_string(e.version) +
+                               " is not supported");
+    } catch (const tracy::LegacyVersion &) {
+      throw std::runtime_error("Legacy trace file, convert it with update");
+    } catch (const tracy::NotTracyDump &) {
+      throw std::runtime_error("Not a tracy dump: " + path);
+    } catch (const tracy::FileReadError &) {
+      throw std::runtime_error("Error reading trace file: " + path);
+    } catch (const tracy::LoadFailure &e) {
+      throw std::runtime_error("Failed to load trace: " + e.msg);
+    }
+  }
+
+  tracy::Worker &Worker() { return *m_worker; }
+
+  const std::string &CaptureName() const { return m_worker->GetCaptureName(); }
+  int64_t FirstTime() const { return m_worker->GetFirstTime(); }
+  int64_t LastTime() const { return m_worker->GetLastTime(); }
+
+  const char *String(uint32_t idx) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (idx >= m_strings.size()) return nullptr;
+    return m_strings[idx];
+  }
+
+  std::shared_ptr<const ThreadColumns> Threads() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_threads) return m_threads;
+    auto out = std::make_shared<ThreadColumns>();
+    for (auto &td : m_worker->GetThreadData()) {
+      out->id.push_back(td->id);
+      out->zones.push_back(td->count);
+      out->samples.push_back(td->samples.size());
+      out->name.push_back(Intern(m_worker->GetThreadName(td->id)));
+    }
+    m_threads = out;
+    return out;
+  }
+
+  std::shared_ptr<const SourceLocationColumns> SourceLocations() {
+    WaitForStatistics();
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_srclocs) return m_srclocs;
+    auto out = std::make_shared<SourceLocationColumns>();
+#ifndef TRACY_NO_STATISTICS
+    for (auto &it : m_worker->GetSourceLocationZones()) {
+      const auto &srcloc = m_worker->GetSourceLocation(it.first);
+      out->id.push_back(it.first);
+      out->name.push_back(srcloc.name.active
+                              ? Intern(m_worker->GetString(srcloc.name))
+                              : NoString);
+      out->function.push_back(Intern(m_worker->GetString(srcloc.function)));
+      out->file.push_back(Intern(m_worker->GetString(srcloc.file)));
+      out->line.push_back(srcloc.line);
+      out->color.push_back(srcloc.color);
+      out->count.push_back(it.second.zones.size());
+      out->total.push_back(it.second.total);
+    }
+#endif
+    m_srclocs = out;
+    return out;
+  }
+
+  std::shared_ptr<const ZoneColumns> Zones(uint64_t thread) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_zones.find(thread);
+    if (it != m_zones.end()) return it->second;
+    auto td = FindThread(thread);
+    auto out = std::make_shared<ZoneColumns>();
+    if (td) {
+      out->start.reserve(td->count);
+      out->end.reserve(td->count);
+      out->srcloc.reserve(td->count);
+      out->depth.reserve(td->count);
+      out->parent.reserve(td->count);
+      out->text.reserve(td->count);
+      out->name.reserve(td->count);
+      if (!td->timeline.empty()) CollectZones(*out, td->timeline, 0, -1);
+    }
+    m_zones.emplace(thread, out);
+    return out;
+  }
+
+  std::shared_ptr<const SrcLocZoneColumns> ZonesForSourceLocation(
+      int16_t srcloc) {
+    WaitForStatistics();
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_srclocZones.find(srcloc);
+    if (it != m_srclocZones.end()) return it->second;
+    auto out = std::make_shared<SrcLocZoneColumns>();
+#ifndef TRACY_NO_STATISTICS
+    auto &map = m_worker->GetSourceLocationZones();
+    auto sit = map.find(srcloc);
+    if (sit != map.end()) {
+      // The worker's list is only sorted on demand, and sorting it in place
+      // would race with other users of the worker.
+      const auto &list = sit->second.zones;
+      std::vector<tracy::Worker::ZoneThreadData> zones(list.begin(),
+                                                      list.end());
+      if (!list.is_sorted()) {
+        std::stable_sort(zones.begin(), zones.end(),
+                         [](const auto &l, const auto &r) {
+                           return l.Zone()->Start() < r.Zone()->Start();
+                         });
+      }
+      out->start.reserve(zones.size());
+      out->end.reserve(zones.size());
+      out->thread.reserve(zones.size());
+      out->text.reserve(zones.size());
+      for (auto &v : zones) {
+        const auto &zone = *v.Zone();
+        out->start.push_back(zone.Start());
+        out->end.push_back(m_worker->GetZoneEnd(zone));
+        out->thread.push_back(m_worker->DecompressThread(v.Thread()));
+        out->text.push_back(ZoneText(zone));
+      }
+    }
+#endif
+    m_srclocZones.emplace(srcloc, out);
+    return out;
+  }
+
+  size_t PlotCount() const { return m_worker->GetPlots().size(); }
+
+  const tracy::PlotData *Plot(size_t idx) const {
+    auto &plots = m_worker->GetPlots();
+    if (idx >= plots.size()) throw std::out_of_range("Invalid plot index");
+    return plots[idx];
+  }
+
+  const char *PlotName(size_t idx) const {
+    return m_worker->GetString(Plot(idx)->name);
+  }
+
+  // Plot values are read in place from the trace, only the 48-bit timestamps
+  // need to be widened.
+  std::shared_ptr<const PlotColumns> PlotTimes(size_t idx) {
+    auto plot = Plot(idx);
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_plots.find(idx);
+    if (it != m_plots.end()) return it->second;
+    auto out = std::make_shared<PlotColumns>();
+    out->time.reserve(plot->data.size());
+    for (auto &v : plot->data) out->time.push_back(v.time.Val());
+    m_plots.emplace(idx, out);
+    return out;
+  }
+
+  std::shared_ptr<const SampleColumns> Samples(uint64_t thread) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_samples.find(thread);
+    if (it != m_samples.end()) return it->second;
+    auto td = FindThread(thread);
+    auto out = std::make_shared<SampleColumns>();
+    if (td) {
+      out->time.reserve(td->samples.size());
+      out->callstack.reserve(td->samples.size());
+      for (auto &v : td->samples) {
+        out->time.push_back(v.time.Val());
+        out->callstack.push_back(v.callstack.Val());
+      }
+    }
+    m_samples.emplace(thread, out);
+    return out;
+  }
+
+  std::vector<CallstackEntry> Callstack(uint32_t idx) {
+    if (idx == 0) return {};
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<CallstackEntry> out;
+    for (auto &entry : m_worker->GetCallstack(idx)) {
+      auto frameData = m_worker->GetCallstackFrame(entry);
+      if (!frameData) {
+        out.push_back({NoString, NoString, 0, false});
+        continue;
+      }
+      for (uint8_t i = 0; i < frameData->size; i++) {
+        const auto &frame = frameData->data[i];
+        out.push_back({Intern(m_worker->GetString(frame.name)),
+                       Intern(m_worker->GetString(frame.file)), frame.line,
+                       i != frameData->size - 1});
+      }
+    }
+    return out;
+  }
+
+  std::vector<uint64_t> MemoryPools() const {
+    std::vector<uint64_t> out;
+    for (auto &v : m_worker->GetMemNameMap()) out.push_back(v.first);
+    std::sort(out.begin(), out.end());
+    return out;
+  }
+
+  const char *MemoryPoolName(uint64_t pool) const {
+    return pool == 0 ? "Default" : m_worker->GetString(pool);
+  }
+
+  std::shared_ptr<const MemoryColumns> Memory(uint64_t pool) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_memory.find(pool);
+    if (it != m_memory.end()) return it->second;
+    auto out = std::make_shared<MemoryColumns>();
+    auto &map = m_worker->GetMemNameMap();
+    auto mit = map.find(pool);
+    if (mit != map.end()) {
+      const auto &data = mit->second->data;
+      const auto sz = data.size();
+      out->ptr.reserve(sz);
+      out->size.reserve(sz);
+      out->time_alloc.reserve(sz);
+      out->time_free.reserve(sz);
+      out->thread_alloc.reserve(sz);
+      out->thread_free.reserve(sz);
+      out->cs_alloc.reserve(sz);
+      out->cs_free.reserve(sz);
+      for (auto &v : data) {
+        const auto freed = v.TimeFree() >= 0;
+        out->ptr.push_back(v.Ptr());
+        out->size.push_back(v.Size());
+        out->time_alloc.push_back(v.TimeAlloc());
+        out->time_free.push_back(v.TimeFree());
+        out->thread_alloc.push_back(m_worker->DecompressThread(v.ThreadAlloc()));
+        out->thread_free.push_back(
+            freed ? m_worker->DecompressThread(v.ThreadFree()) : 0);
+        out->cs_alloc.push_back(v.CsAlloc());
+        out->cs_free.push_back(v.csFree.Val());
+      }
+    }
+    m_memory.emplace(pool, out);
+    return out;
+  }
+
+  std::shared_ptr<const MessageColumns> Messages() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_messages) return m_messages;
+    auto out = std::make_shared<MessageColumns>();
+    const auto &msgs = m_worker->GetMessages();
+    out->time.reserve(msgs.size());
+    out->thread.reserve(msgs.size());
+    out->text.reserve(msgs.size());
+    out->color.reserve(msgs.size());
+    out->callstack.reserve(msgs.size());
+    for (auto &v : msgs) {
+      out->time.push_back(v->time);
+      out->thread.push_back(m_worker->DecompressThread(v->thread));
+      out->text.push_back(Intern(m_worker->GetString(v->ref)));
+      out->color.push_back(v->color);
+      out->callstack.push_back(v->callstack.Val());
+    }
+    m_messages = out;
+    return out;
+  }
+
+  size_t FrameSetCount() const { return m_worker->GetFrames().size(); }
+
+  const tracy::FrameData *FrameSet(size_t idx) const {
+    auto &frames = m_worker->GetFrames();
+    if (idx >= frames.size()) throw std::out_of_range("Invalid frame set index");
+    return frames[idx];
+  }
+
+  const char *FrameSetName(size_t idx) const {
+    return m_worker->GetString(FrameSet(idx)->name);
+  }
+
+ private:
+  void WaitForStatistics() const {
+#ifdef TRACY_NO_STATISTICS
+    throw std::runtime_error("Statistics are not available in this build");
+#else
+    while (!m_worker->AreSourceLocationZonesReady())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+  }
+
+  const tracy::ThreadData *FindThread(uint64_t thread) const {
+    for (auto &td : m_worker->GetThreadData()) {
+      if (td->id == thread) return td;
+    }
+    return nullptr;
+  }
+
+  uint32_t Intern(const char *str) {
+    auto it = m_stringMap.find(str);
+    if (it != m_stringMap.end()) return it->second;
+    const auto idx = uint32_t(m_strings.size());
+    m_strings.push_back(str);
+    m_stringMap.emplace(str, idx);
+    return idx;
+  }
+
+  uint32_t ZoneText(const tracy::ZoneEvent &zone) {
+    if (!m_worker->HasZoneExtra(zone)) return NoString;
+    const auto &extra = m_worker->GetZoneExtra(zone);
+    if (!extra.text.Active()) return NoString;
+    return Intern(m_worker->GetString(extra.text));
+  }
+
+  uint32_t ZoneName(const tracy::ZoneEvent &zone) {
+    if (!m_worker->HasZoneExtra(zone)) return NoString;
+    const auto &extra = m_worker->GetZoneExtra(zone);
+    if (!extra.name.Active()) return NoString;
+    return Intern(m_worker->GetString(extra.name));
+  }
+
+  void AddZone(ZoneColumns &out, const tracy::ZoneEvent &zone, uint16_t depth,
+               int32_t parent) {
+    const auto row = int32_t(out.start.size());
+    out.start.push_back(zone.Start());
+    out.end.push_back(m_worker->GetZoneEnd(zone));
+    out.srcloc.push_back(zone.SrcLoc());
+    out.depth.push_back(depth);
+    out.parent.push_back(parent);
+    out.text.push_back(ZoneText(zone));
+    out.name.push_back(ZoneName(zone));
+    if (zone.HasChildren()) {
+      CollectZones(out, m_worker->GetZoneChildren(zone.Child()), depth + 1,
+                   row);
+    }
+  }
+
+  void CollectZones(ZoneColumns &out,
+                    const tracy::Vector<tracy::short_ptr<tracy::ZoneEvent>> &vec,
+                    uint16_t depth, int32_t parent) {
+    if (vec.is_magic()) {
+      auto &zones = *(tracy::Vector<tracy::ZoneEvent> *)&vec;
+      for (auto &zone : zones) AddZone(out, zone, depth, parent);
+    } else {
+      for (auto &zone : vec) AddZone(out, *zone, depth, parent);
+    }
+  }
+
+  std::unique_ptr<tracy::Worker> m_worker;
+  std::mutex m_lock;
+
+  std::vector<const char *> m_strings;
+  std::unordered_map<const char *, uint32_t> m_stringMap;
+
+  std::shared_ptr<const ThreadColumns> m_threads;
+  std::shared_ptr<const SourceLocationColumns> m_srclocs;
+  std::shared_ptr<const MessageColumns> m_messages;
+  std::unordered_map<uint64_t, std::shared_ptr<const ZoneColumns>> m_zones;
+  std::unordered_map<int16_t, std::shared_ptr<const SrcLocZoneColumns>>
+      m_srclocZones;
+  std::unordered_map<size_t, std::shared_ptr<const PlotColumns>> m_plots;
+  std::unordered_map<uint64_t, std::shared_ptr<const SampleColumns>> m_samples;
+  std::unordered_map<uint64_t, std::shared_ptr<const MemoryColumns>> m_memory;
+};
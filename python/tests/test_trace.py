@@ -0,0 +1,58 @@
+# -*- coding: utf-8 -*-
+"""Checks the trace reader against zones.json, imported with tracy-import-chrome.
+
+The trace has two threads. Thread 1 runs 10 Outer zones, each with two Inner
+zones, and thread 2 runs 10 Outer zones with one Inner zone each, interleaved
+in time with the zones of thread 1. The path of the imported trace is taken
+from the TRACY_TEST_TRACE environment variable.
+"""
+
+import os
+import unittest
+
+import numpy as np
+
+from tracy_client.trace import Trace
+
+
+class TraceReaderTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.trace = Trace(os.environ["TRACY_TEST_TRACE"])
+
+    def source_locations(self):
+        srclocs = self.trace.source_locations()
+        names = self.trace.strings(srclocs["function"])
+        return {name: i for i, name in enumerate(names)}, srclocs
+
+    def test_source_location_counts(self):
+        index, srclocs = self.source_locations()
+        self.assertEqual(sorted(index), ["Inner", "Outer"])
+        self.assertEqual(srclocs["count"][index["Outer"]], 20)
+        self.assertEqual(srclocs["count"][index["Inner"]], 30)
+        # 10 zones of 60 us and 10 of 40 us
+        self.assertEqual(srclocs["total"][index["Outer"]], 1000000)
+
+    def test_source_location_zones_sorted(self):
+        index, srclocs = self.source_locations()
+        for name, i in index.items():
+            zones = self.trace.source_location_zones(srclocs["id"][i])
+            self.assertEqual(len(zones["start"]), srclocs["count"][i], name)
+            self.assertTrue(np.all(np.diff(zones["start"]) >= 0), name)
+            self.assertTrue(np.all(zones["end"] > zones["start"]), name)
+            self.assertEqual(len(np.unique(zones["thread"])), 2, name)
+
+    def test_thread_zones(self):
+        threads = self.trace.threads()
+        self.assertEqual(len(threads["id"]), 2)
+        self.assertEqual(sorted(threads["zones"]), [20, 30])
+        for thread, count in zip(threads["id"], threads["zones"]):
+            zones = self.trace.zones(thread)
+            self.assertEqual(len(zones["start"]), count)
+            top = zones["parent"] == -1
+            self.assertEqual(np.count_nonzero(top), 10)
+            self.assertTrue(np.all(np.diff(zones["start"][top]) > 0))
+
+
+if __name__ == "__main__":
+    unittest.main()
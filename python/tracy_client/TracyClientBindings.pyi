@@ -2788,7 +2788,10 @@ class PlotFormatType():
     __members__: dict # value = {'Number': <PlotFormatType.Number: 0>, 'Memory': <PlotFormatType.Memory: 1>, 'Percentage': <PlotFormatType.Percentage: 2>}
     pass
 class _ScopedZone():
+    @typing.overload
     def __init__(self, name: typing.Optional[str], color: int, depth: typing.Optional[int], active: bool, function: str, file: str, line: int) -> None: ...
+    @typing.overload
+    def __init__(self, srcloc: _SourceLocation, depth: typing.Optional[int], active: bool) -> None: ...
     def _color(self, color: int) -> None: ...
     def enter(self) -> None: ...
     def exit(self) -> None: ...
@@ -2803,8 +2806,25 @@ class _ScopedZone():
         :type: bool
         """
     pass
+class _SourceLocation():
+    def __init__(self, name: typing.Optional[str], color: int, function: str, file: str, line: int) -> None: ...
+    pass
+def _monitor_configure(filter: typing.Optional[typing.Callable[[object], bool]], depth: typing.Optional[int]) -> None:
+    pass
+def _monitor_end(code: object, *args) -> object:
+    pass
+def _monitor_start(code: object, *args) -> object:
+    pass
+def _monitor_stop() -> None:
+    pass
+def _monitor_throw(code: object, *args) -> object:
+    pass
+def _monitor_unwind(code: object, *args) -> object:
+    pass
 def _plot_config(name: str, type: int, step: bool, fill: bool, color: int) -> typing.Optional[int]:
     pass
+def _zone_call(srcloc: _SourceLocation, depth: typing.Optional[int], function: typing.Callable, *args, **kwargs) -> object:
+    pass
 @typing.overload
 def alloc(ptr: int, size: int, name: typing.Optional[str] = None, id: typing.Optional[int] = None, depth: typing.Optional[int] = None) -> typing.Optional[int]:
     pass
@@ -0,0 +1,91 @@
+# -*- coding: utf-8 -*-
+
+import sys
+
+from types import CodeType
+from typing import Callable, Optional
+
+from tracy_client.TracyClientBindings import (
+    is_enabled,
+    _monitor_configure,
+    _monitor_stop,
+    _monitor_start,
+    _monitor_throw,
+    _monitor_end,
+    _monitor_unwind,
+)
+
+CodeFilter = Callable[[CodeType], bool]
+
+_TOOL_NAME = "tracy"
+
+
+def _events():
+    events = sys.monitoring.events
+    return {
+        events.PY_START: _monitor_start,
+        events.PY_RESUME: _monitor_start,
+        events.PY_THROW: _monitor_throw,
+        events.PY_RETURN: _monitor_end,
+        events.PY_YIELD: _monitor_end,
+        events.PY_UNWIND: _monitor_unwind,
+    }
+
+
+def start_function_zones(
+    filter: Optional[CodeFilter] = None, depth: Optional[int] = None
+) -> bool:
+    """Emits a zone for every Python function call, using sys.monitoring.
+
+    Requires Python 3.12 or newer. The filter is called once per code object;
+    functions it rejects are not reported again."""
+    if sys.version_info < (3, 12):
+        raise RuntimeError("function zones require Python 3.12 or newer")
+    if not is_enabled():
+        return False
+
+    monitoring = sys.monitoring
+    tool = monitoring.PROFILER_ID
+    if monitoring.get_tool(tool) is not None:
+        return False
+    monitoring.use_tool_id(tool, _TOOL_NAME)
+
+    _monitor_configure(filter, depth)
+    mask = 0
+    for event, callback in _events().items():
+        monitoring.register_callback(tool, event, callback)
+        mask |= event
+    monitoring.set_events(tool, mask)
+    monitoring.restart_events()
+    return True
+
+
+def stop_function_zones() -> None:
+    if sys.version_info < (3, 12):
+        return
+
+    monitoring = sys.monitoring
+    tool = monitoring.PROFILER_ID
+    if monitoring.get_tool(tool) != _TOOL_NAME:
+        return
+
+    monitoring.set_events(tool, 0)
+    for event in _events():
+        monitoring.register_callback(tool, event, None)
+    monitoring.free_tool_id(tool)
+    _monitor_stop()
+
+
+class FunctionZones:
+    def __init__(
+        self, filter: Optional[CodeFilter] = None, depth: Optional[int] = None
+    ) -> None:
+        self.__filter = filter
+        self.__depth = depth
+
+    def __enter__(self):
+        start_function_zones(self.__filter, self.__depth)
+        return self
+
+    def __exit__(self, *args):
+        stop_function_zones()
@@ -3,11 +3,13 @@
 import sys
 
 from functools import wraps
-from typing import Callable, Optional, Union
+from typing import Callable, Dict, Optional, Tuple, Union
 
 from tracy_client.TracyClientBindings import (
     is_enabled,
     _ScopedZone,
+    _SourceLocation,
+    _zone_call,
     ColorType,
     frame_mark_start,
     frame_mark_end,
@@ -15,6 +17,9 @@ from tracy_client.TracyClientBindings import (
 
 Color = Union[int, ColorType]
 
+# Source locations of ScopedZone instances, per code object and line.
+_source_locations: Dict[Tuple[object, int, Optional[str], int], _SourceLocation] = {}
+
 
 class ScopedZone(_ScopedZone):
     def __init__(
@@ -25,16 +30,18 @@ class ScopedZone(_ScopedZone):
         active: bool = True,
     ) -> None:
         frame = sys._getframe(1)
-        _ScopedZone.__init__(
-            self,
-            name,
-            int(color),
-            depth,
-            active,
-            frame.f_code.co_name,
-            frame.f_code.co_filename,
-            frame.f_lineno,
-        )
+        key = (frame.f_code, frame.f_lineno, name, int(color))
+        srcloc = _source_locations.get(key)
+        if srcloc is None:
+            srcloc = _SourceLocation(
+                name,
+                int(color),
+                frame.f_code.co_name,
+                frame.f_code.co_filename,
+                frame.f_lineno,
+            )
+            _source_locations[key] = srcloc
+        _ScopedZone.__init__(self, srcloc, depth, active)
 
     def color(self, color: Color) -> None:
         self._color(int(color))
@@ -56,18 +63,16 @@ def ScopedZoneDecorator(
 ):
 
     def decorator(function: Callable):
-        if not is_enabled():
+        if not is_enabled() or not active:
             return function
 
         source = function.__name__
         if class_name is not None:
             source = f"{class_name}:{source}"
 
-        zone = _ScopedZone(
+        srcloc = _SourceLocation(
             name,
             int(color),
-            depth,
-            active,
             source,
             function.__code__.co_filename,
             function.__code__.co_firstlineno,
@@ -75,10 +80,7 @@ def ScopedZoneDecorator(
 
         @wraps(function)
         def wrapped(*args, **kwargs):
-            zone.enter()
-            value = function(*args, **kwargs)
-            zone.exit()
-            return value
+            return _zone_call(srcloc, depth, function, *args, **kwargs)
 
         return wrapped
 
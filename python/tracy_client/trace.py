@@ -0,0 +1,23 @@
+# -*- coding: utf-8 -*-
+
+from typing import Dict
+
+import numpy as np
+
+from tracy_client.TracyTraceBindings import Trace
+
+NO_STRING = 0xFFFFFFFF
+
+Columns = Dict[str, np.ndarray]
+
+
+def to_arrow(columns: Columns):
+    """Wraps columns returned by Trace in a pyarrow Table.
+
+    Contiguous columns are shared with Arrow without copying."""
+    import pyarrow as pa
+
+    return pa.table({name: pa.array(column) for name, column in columns.items()})
+
+
+__all__ = ["Trace", "to_arrow", "NO_STRING"]
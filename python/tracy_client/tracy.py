@@ -26,6 +26,11 @@ from tracy_client.scoped import (
     ScopedZoneDecorator,
     ScopedFrameDecorator,
 )
+from tracy_client.monitoring import (
+    FunctionZones,
+    start_function_zones,
+    stop_function_zones,
+)
 
 PlotType = Union[int, PlotFormatType]
 
@@ -0,0 +1,57 @@
+#include <assert.h>
+
+#include "TracyAnalysisEngine.hpp"
+#include "TracyWorker.hpp"
+
+namespace tracy
+{
+
+static std::unique_lock<std::mutex> LockWorker( Worker* worker, bool live )
+{
+    std::unique_lock<std::mutex> lock( worker->GetDataLock(), std::defer_lock );
+    if( live ) lock.lock();
+    return lock;
+}
+
+AnalysisEngine::AnalysisEngine( Worker& worker )
+    : m_worker( &worker )
+    , m_other( nullptr )
+    , m_live( false )
+    , m_otherLive( false )
+    , m_abort( false )
+    , m_done( false )
+    , m_progress( 0 )
+    , m_total( 0 )
+{
+}
+
+AnalysisEngine::AnalysisEngine( Worker& worker, Worker& other )
+    : m_worker( &worker )
+    , m_other( &other )
+    , m_live( false )
+    , m_otherLive( false )
+    , m_abort( false )
+    , m_done( false )
+    , m_progress( 0 )
+    , m_total( 0 )
+{
+}
+
+void AnalysisEngine::Begin()
+{
+    m_live = m_worker->IsConnected();
+    if( m_other ) m_otherLive = m_other->IsConnected();
+}
+
+std::unique_lock<std::mutex> AnalysisEngine::LockData() const
+{
+    return LockWorker( m_worker, m_live );
+}
+
+std::unique_lock<std::mutex> AnalysisEngine::LockOtherData() const
+{
+    assert( m_other );
+    return LockWorker( m_other, m_otherLive );
+}
+
+}
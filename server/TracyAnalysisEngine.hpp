@@ -0,0 +1,75 @@
+#ifndef __TRACYANALYSISENGINE_HPP__
+#define __TRACYANALYSISENGINE_HPP__
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+
+#include "TracyTaskDispatch.hpp"
+
+namespace tracy
+{
+
+class Worker;
+
+// Common part of the engines which analyze the worker data in the background, while the
+// UI polls for progress. The derived Process() blocks until the results are ready. While
+// the worker is still capturing, its data may be reallocated, so each unit of work is done
+// holding the data lock. The lock is not held for the whole run, and the capture goes on.
+class AnalysisEngine
+{
+public:
+    void Abort() { m_abort.store( true, std::memory_order_relaxed ); }
+
+    bool IsDone() const { return m_done.load( std::memory_order_acquire ); }
+    size_t GetProgress() const { return m_progress.load( std::memory_order_relaxed ); }
+    size_t GetTotal() const { return m_total.load( std::memory_order_relaxed ); }
+
+protected:
+    explicit AnalysisEngine( Worker& worker );
+    // For engines comparing the data of two workers.
+    AnalysisEngine( Worker& worker, Worker& other );
+
+    // Process() calls Begin() first and Finish() last, also when aborted.
+    void Begin();
+    void Finish() { m_done.store( true, std::memory_order_release ); }
+
+    // Holds the worker data lock if the worker was capturing when processing began.
+    std::unique_lock<std::mutex> LockData() const;
+    // Same, for the second worker. When both are needed, lock the first worker first.
+    std::unique_lock<std::mutex> LockOtherData() const;
+
+    bool IsAborted() const { return m_abort.load( std::memory_order_relaxed ); }
+    void SetTotal( size_t total ) { m_total.store( total, std::memory_order_relaxed ); }
+
+    // Queues func( i ) for each i in [0, count), counting one unit of progress per task.
+    // Tasks still queued after an abort do nothing. Wait for them with td.Sync().
+    template<typename Func>
+    void QueueTasks( TaskDispatch& td, size_t count, const Func& func )
+    {
+        for( size_t i=0; i<count; i++ )
+        {
+            td.Queue( [this, func, i] {
+                if( IsAborted() ) return;
+                func( i );
+                m_progress.fetch_add( 1, std::memory_order_relaxed );
+            } );
+        }
+    }
+
+    Worker* m_worker;
+    Worker* m_other;
+
+private:
+    bool m_live;
+    bool m_otherLive;
+
+    std::atomic<bool> m_abort;
+    std::atomic<bool> m_done;
+    std::atomic<size_t> m_progress;
+    std::atomic<size_t> m_total;
+};
+
+}
+
+#endif
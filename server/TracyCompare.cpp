@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string>
+
+#include "TracyCompare.hpp"
+#include "TracyTaskDispatch.hpp"
+#include "TracyWorker.hpp"
+
+namespace tracy
+{
+
+// 1% relative accuracy
+constexpr double SketchAlpha = 0.01;
+constexpr double SketchGamma = ( 1 + SketchAlpha ) / ( 1 - SketchAlpha );
+static const double SketchInvLogGamma = 1. / log( SketchGamma );
+
+int32_t LogSketch::Index( int64_t val )
+{
+    if( val <= 1 ) return 0;
+    return (int32_t)ceil( log( double( val ) ) * SketchInvLogGamma );
+}
+
+int64_t LogSketch::Value( int32_t idx )
+{
+    if( idx == 0 ) return 1;
+    return (int64_t)llround( 2 * pow( SketchGamma, idx ) / ( SketchGamma + 1 ) );
+}
+
+void LogSketch::Init( int64_t min, int64_t max )
+{
+    assert( min <= max );
+    m_offset = Index( min );
+    m_count = 0;
+    m_bins.clear();
+    m_bins.resize( Index( max ) - m_offset + 1 );
+}
+
+void LogSketch::Add( int64_t val )
+{
+    const auto idx = std::clamp( Index( val ) - m_offset, 0, int32_t( m_bins.size() - 1 ) );
+    m_bins[idx]++;
+    m_count++;
+}
+
+int64_t LogSketch::Quantile( double q ) const
+{
+    if( m_count == 0 ) return 0;
+    const auto rank = uint64_t( q * ( m_count - 1 ) );
+    uint64_t cnt = 0;
+    for( size_t i=0; i<m_bins.size(); i++ )
+    {
+        cnt += m_bins[i];
+        if( cnt > rank ) return Value( m_offset + int32_t( i ) );
+    }
+    return Value( End() - 1 );
+}
+
+
+TraceCompare::TraceCompare( Worker& w0, Worker& w1 )
+    : AnalysisEngine( w0, w1 )
+{
+}
+
+void TraceCompare::Process( TaskDispatch& td )
+{
+#ifndef TRACY_NO_STATISTICS
+    assert( m_worker->AreSourceLocationZonesReady() && m_other->AreSourceLocationZonesReady() );
+
+    Begin();
+    {
+        auto lock0 = LockData();
+        auto lock1 = LockOtherData();
+        Match();
+    }
+    SetTotal( m_results.size() );
+
+    QueueTasks( td, m_results.size(), [this] ( size_t i ) { Compare( m_results[i] ); } );
+    td.Sync();
+#endif
+    Finish();
+}
+
+void TraceCompare::Test( const LogSketch& s0, const LogSketch& s1, double& ks, double& pValue, double& effect )
+{
+    // Both tests work on bins, with all values in a bin treated as ties.
+    const double n0 = s0.Count();
+    const double n1 = s1.Count();
+    if( n0 == 0 || n1 == 0 )
+    {
+        ks = 0;
+        pValue = 1;
+        effect = 0;
+        return;
+    }
+    const auto begin = std::min( s0.Begin(), s1.Begin() );
+    const auto end = std::max( s0.End(), s1.End() );
+    uint64_t c0 = 0, c1 = 0;
+    double u0 = 0;
+    double ties = 0;
+    ks = 0;
+    for( int32_t i=begin; i<end; i++ )
+    {
+        const auto b0 = s0.Bin( i );
+        const auto b1 = s1.Bin( i );
+        if( b0 == 0 && b1 == 0 ) continue;
+        u0 += b0 * ( c1 + 0.5 * b1 );
+        const double t = double( b0 + b1 );
+        ties += t * t * t - t;
+        c0 += b0;
+        c1 += b1;
+        ks = std::max( ks, fabs( c0 / n0 - c1 / n1 ) );
+    }
+
+    const auto nn = n0 * n1;
+    const auto n = n0 + n1;
+    effect = 2 * u0 / nn - 1;
+
+    const auto var = nn / 12 * ( ( n + 1 ) - ( n > 1 ? ties / ( n * ( n - 1 ) ) : 0 ) );
+    if( var > 0 )
+    {
+        const auto z = ( u0 - nn / 2 ) / sqrt( var );
+        pValue = erfc( fabs( z ) / sqrt( 2. ) );
+    }
+    else
+    {
+        pValue = 1;
+    }
+}
+
+#ifndef TRACY_NO_STATISTICS
+void TraceCompare::Match()
+{
+    auto& w0 = *m_worker;
+    auto& w1 = *m_other;
+
+    // Prefer the most specific match, same as FindMatchingZone() in the compare window.
+    unordered_flat_map<std::string, int16_t> exact, file, name;
+    for( auto& v : w1.GetSourceLocationZones() )
+    {
+        if( v.second.zones.empty() ) continue;
+        auto& srcloc = w1.GetSourceLocation( v.first );
+        std::string key = w1.GetZoneName( srcloc );
+        name.emplace( key, v.first );
+        key += '\0';
+        key += w1.GetString( srcloc.file );
+        file.emplace( key, v.first );
+        key += '\0';
+        key += std::to_string( srcloc.line );
+        exact.emplace( std::move( key ), v.first );
+    }
+
+    for( auto& v : w0.GetSourceLocationZones() )
+    {
+        if( v.second.zones.empty() ) continue;
+        auto& srcloc = w0.GetSourceLocation( v.first );
+        std::string key = w0.GetZoneName( srcloc );
+        const auto nsz = key.size();
+        key += '\0';
+        key += w0.GetString( srcloc.file );
+        const auto fsz = key.size();
+        key += '\0';
+        key += std::to_string( srcloc.line );
+
+        Result res = {};
+        res.srcloc[0] = v.first;
+        auto it = exact.find( key );
+        if( it != exact.end() )
+        {
+            res.match = MatchExact;
+        }
+        else
+        {
+            key.resize( fsz );
+            it = file.find( key );
+            if( it != file.end() )
+            {
+                res.match = MatchFile;
+            }
+            else
+            {
+                key.resize( nsz );
+                it = name.find( key );
+                if( it == name.end() ) continue;
+                res.match = MatchName;
+            }
+        }
+        res.srcloc[1] = it->second;
+        m_results.emplace_back( res );
+    }
+}
+
+void TraceCompare::Compare( Result& res )
+{
+    LogSketch sketch[2];
+    for( int i=0; i<2; i++ )
+    {
+        auto& worker = i == 0 ? *m_worker : *m_other;
+        auto lock = i == 0 ? LockData() : LockOtherData();
+        auto& slz = worker.GetZonesForSourceLocation( res.srcloc[i] );
+        sketch[i].Init( slz.min, slz.max );
+        for( auto& v : slz.zones )
+        {
+            auto zone = v.Zone();
+            sketch[i].Add( zone->End() - zone->Start() );
+        }
+        res.count[i] = sketch[i].Count();
+        res.total[i] = slz.total;
+        res.mean[i] = double( slz.total ) / res.count[i];
+        res.median[i] = sketch[i].Quantile( 0.5 );
+        res.p90[i] = sketch[i].Quantile( 0.9 );
+        res.p99[i] = sketch[i].Quantile( 0.99 );
+    }
+
+    Test( sketch[0], sketch[1], res.ks, res.pValue, res.effect );
+}
+#endif
+
+}
@@ -0,0 +1,86 @@
+#ifndef __TRACYCOMPARE_HPP__
+#define __TRACYCOMPARE_HPP__
+
+#include <stdint.h>
+#include <vector>
+
+#include "TracyAnalysisEngine.hpp"
+
+namespace tracy
+{
+
+// Log-bucketed histogram with bounded relative error. Bucket boundaries do not depend on
+// the data, so sketches built from two different traces can be compared bin by bin.
+class LogSketch
+{
+public:
+    LogSketch() : m_offset( 0 ), m_count( 0 ) {}
+
+    void Init( int64_t min, int64_t max );
+    void Add( int64_t val );
+
+    uint64_t Count() const { return m_count; }
+    int64_t Quantile( double q ) const;
+
+    static int32_t Index( int64_t val );
+    static int64_t Value( int32_t idx );
+
+    int32_t Begin() const { return m_offset; }
+    int32_t End() const { return m_offset + (int32_t)m_bins.size(); }
+    uint64_t Bin( int32_t idx ) const { return idx < m_offset || idx >= End() ? 0 : m_bins[idx - m_offset]; }
+
+private:
+    int32_t m_offset;
+    uint64_t m_count;
+    std::vector<uint64_t> m_bins;
+};
+
+// Matches source locations of two traces and computes per source location timing
+// distributions, along with a significance test and effect size of the difference.
+// Trace 1 is treated as the baseline, positive deltas mean trace 0 is slower.
+class TraceCompare : public AnalysisEngine
+{
+public:
+    enum MatchType : uint8_t
+    {
+        MatchExact,         // name, file and line
+        MatchFile,          // name and file
+        MatchName           // name only
+    };
+
+    struct Result
+    {
+        int16_t srcloc[2];
+        MatchType match;
+        uint64_t count[2];
+        int64_t total[2];
+        double mean[2];
+        int64_t median[2];
+        int64_t p90[2];
+        int64_t p99[2];
+        double ks;          // Kolmogorov-Smirnov statistic
+        double pValue;      // Mann-Whitney U test, two-sided
+        double effect;      // Cliff's delta, in range [-1, 1]
+    };
+
+    TraceCompare( Worker& w0, Worker& w1 );
+
+    // Requires source location zones to be ready in both workers. One unit of progress per
+    // matched source location.
+    void Process( TaskDispatch& td );
+
+    // Mann-Whitney U test, Kolmogorov-Smirnov statistic and Cliff's delta of two distributions.
+    static void Test( const LogSketch& s0, const LogSketch& s1, double& ks, double& pValue, double& effect );
+
+    const std::vector<Result>& GetResults() const { return m_results; }
+
+private:
+    void Match();
+    void Compare( Result& res );
+
+    std::vector<Result> m_results;
+};
+
+}
+
+#endif
@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <assert.h>
+
+#include "TracyCriticalPath.hpp"
+#include "TracySchedulerAnalysis.hpp"
+#include "TracyTaskDispatch.hpp"
+#include "TracyWorker.hpp"
+
+namespace tracy
+{
+
+enum { FrameChunk = 256 };
+
+static tracy_force_inline const ZoneEvent& Deref( const ZoneEvent& zone ) { return zone; }
+static tracy_force_inline const ZoneEvent& Deref( const short_ptr<ZoneEvent>& zone ) { return *zone; }
+
+
+CriticalPath::CriticalPath( Worker& worker, const FrameData* frames, int64_t start, int64_t end )
+    : AnalysisEngine( worker )
+    , m_frames( frames )
+    , m_start( start )
+    , m_end( end )
+    , m_frameCount( 0 )
+    , m_pathStart( start )
+    , m_pathEnd( end )
+    , m_pathFrame( 0 )
+    , m_totalTime( 0 )
+    , m_untracked( 0 )
+{
+}
+
+void CriticalPath::Process( TaskDispatch& td )
+{
+    std::vector<std::pair<uint32_t, const LockMap*>> locks;
+    std::vector<std::pair<uint64_t, const ContextSwitch*>> threads;
+    size_t firstFrame = 0;
+    size_t lastFrame = 0;
+
+    Begin();
+    {
+        auto lock = LockData();
+
+        for( auto& t : m_worker->GetThreadData() )
+        {
+            if( !t->isFiber ) m_index.emplace( t->id, ThreadIndex { t } );
+        }
+        for( auto& v : m_worker->GetLockMap() )
+        {
+            if( v.second->valid && !v.second->timeline.empty() ) locks.emplace_back( v.first, v.second );
+        }
+        for( auto& v : m_worker->GetContextSwitchMap() )
+        {
+            if( m_index.find( v.first ) != m_index.end() ) threads.emplace_back( v.first, v.second );
+        }
+        if( m_frames )
+        {
+            auto& frames = m_frames->frames;
+            firstFrame = std::lower_bound( frames.begin(), frames.end(), m_start, []( const auto& l, int64_t r ) { return l.start < r; } ) - frames.begin();
+            lastFrame = std::lower_bound( frames.begin() + firstFrame, frames.end(), m_end, []( const auto& l, int64_t r ) { return l.start < r; } ) - frames.begin();
+        }
+        else
+        {
+            lastFrame = 1;
+        }
+    }
+    const auto chunks = ( lastFrame - firstFrame + FrameChunk - 1 ) / FrameChunk;
+    SetTotal( locks.size() + threads.size() + chunks );
+
+    std::vector<std::vector<std::pair<uint64_t, Wait>>> lockWaits( locks.size() );
+    QueueTasks( td, locks.size(), [this, &locks, &lockWaits] ( size_t i ) { IndexLock( *locks[i].second, locks[i].first, lockWaits[i] ); } );
+    std::vector<std::vector<Wait>> threadWaits( threads.size() );
+    QueueTasks( td, threads.size(), [this, &threads, &threadWaits] ( size_t i ) { IndexThread( threads[i].first, *threads[i].second, threadWaits[i] ); } );
+    td.Sync();
+    if( IsAborted() )
+    {
+        Finish();
+        return;
+    }
+
+    for( size_t i=0; i<threads.size(); i++ )
+    {
+        m_index.find( threads[i].first )->second.waits = std::move( threadWaits[i] );
+    }
+    for( auto& waits : lockWaits )
+    {
+        for( auto& v : waits )
+        {
+            auto it = m_index.find( v.first );
+            if( it != m_index.end() ) it->second.waits.emplace_back( v.second );
+        }
+    }
+    lockWaits.clear();
+    for( auto& v : m_index )
+    {
+        auto& waits = v.second.waits;
+        if( waits.size() > 1 )
+        {
+            td.Queue( [&waits] {
+                std::sort( waits.begin(), waits.end(), []( const auto& l, const auto& r ) { return l.end < r.end; } );
+            } );
+        }
+    }
+    td.Sync();
+
+    m_state.resize( chunks );
+    QueueTasks( td, chunks, [this, firstFrame, lastFrame] ( size_t i ) {
+        const auto first = firstFrame + i * FrameChunk;
+        const auto last = std::min<size_t>( first + FrameChunk, lastFrame );
+        auto lock = LockData();
+        for( size_t j=first; j<last; j++ )
+        {
+            if( m_frames )
+            {
+                const auto start = m_worker->GetFrameBegin( *m_frames, j );
+                const auto end = m_worker->GetFrameEnd( *m_frames, j );
+                if( end <= m_end ) ProcessFrame( j, start, end, m_state[i] );
+            }
+            else
+            {
+                ProcessFrame( 0, m_start, m_end, m_state[i] );
+            }
+        }
+    } );
+    td.Sync();
+
+    if( !IsAborted() ) Merge();
+    m_state.clear();
+    m_state.shrink_to_fit();
+    m_index.clear();
+    Finish();
+}
+
+void CriticalPath::IndexLock( const LockMap& lockmap, uint32_t id, std::vector<std::pair<uint64_t, Wait>>& out )
+{
+    auto lock = LockData();
+
+    struct Release
+    {
+        uint8_t thread;
+        int64_t time;
+    };
+
+    enum { NoThread = 0xFF };
+    int64_t waitStart[MaxLockThreads];
+    for( auto& v : waitStart ) v = -1;
+    // Exclusive waiters are blocked by any holder, shared waiters only by an exclusive one.
+    Release lastRelease = { NoThread, -1 };
+    Release lastExclusive = { NoThread, -1 };
+
+    const auto& threadList = lockmap.threadList;
+    for( auto& v : lockmap.timeline )
+    {
+        const auto& ev = *v.ptr;
+        const auto time = ev.Time();
+        const auto thread = ev.thread;
+        switch( ev.type )
+        {
+        case LockEvent::Type::Wait:
+        case LockEvent::Type::WaitShared:
+            waitStart[thread] = time;
+            break;
+        case LockEvent::Type::Obtain:
+        case LockEvent::Type::ObtainShared:
+        {
+            const auto& release = ev.type == LockEvent::Type::Obtain ? lastRelease : lastExclusive;
+            const auto start = waitStart[thread];
+            if( start >= 0 && time > start && release.thread != NoThread && release.thread != thread && release.time >= start )
+            {
+                out.emplace_back( threadList[thread], Wait { start, time, threadList[release.thread], release.time, id } );
+            }
+            waitStart[thread] = -1;
+            break;
+        }
+        case LockEvent::Type::Release:
+            if( v.lockCount == 0 )
+            {
+                lastRelease = { thread, time };
+                lastExclusive = lastRelease;
+            }
+            break;
+        case LockEvent::Type::ReleaseShared:
+            lastRelease = { thread, time };
+            break;
+        default:
+            assert( false );
+            break;
+        }
+    }
+}
+
+void CriticalPath::IndexThread( uint64_t thread, const ContextSwitch& cs, std::vector<Wait>& out )
+{
+    auto lock = LockData();
+
+    const auto cpuData = m_worker->GetCpuData();
+    const auto cpuCnt = m_worker->GetCpuDataCpuCount();
+    auto& v = cs.v;
+    for( size_t i=1; i<v.size(); i++ )
+    {
+        auto& prev = v[i-1];
+        auto& ev = v[i];
+        if( !prev.IsEndValid() || ev.Reason() == ContextSwitchData::Wakeup ) continue;
+        if( prev.Reason() == ContextSwitchData::Fiber ) continue;
+        // A preempted thread did not wait for another thread.
+        if( SchedulerAnalysis::IsPreempted( prev ) ) continue;
+        const auto start = prev.End();
+        const auto end = ev.Start();
+        const auto wakeup = ev.WakeupVal();
+        if( wakeup <= start || wakeup > end || ev.WakeupCpu() >= cpuCnt ) continue;
+
+        // The waker is the thread that was running on the waking CPU at the wakeup time.
+        const auto& cpucs = cpuData[ev.WakeupCpu()].cs;
+        auto it = std::lower_bound( cpucs.begin(), cpucs.end(), wakeup, []( const auto& l, int64_t r ) { return l.End() < r; } );
+        if( it == cpucs.end() || it->Start() >= wakeup || !it->IsEndValid() || it->End() <= wakeup ) continue;
+        const auto waker = m_worker->DecompressThreadExternal( it->Thread() );
+        if( waker == thread ) continue;
+        out.emplace_back( Wait { start, end, waker, wakeup, NoLock } );
+    }
+}
+
+void CriticalPath::ComputeSegments( int64_t start, int64_t end, std::vector<Segment>& segments ) const
+{
+    // The path ends in the thread whose zones finished last. Zones still running at the end
+    // of the range did not bound it (frame marks don't record the thread which issued them),
+    // so they are only used if no zone ends within the range. Equal ends go to the lowest
+    // thread id, which keeps the choice independent of the index iteration order.
+    uint64_t thread = 0;
+    int64_t t = start;
+    bool inside = false;
+    for( auto& v : m_index )
+    {
+        auto& timeline = v.second.td->timeline;
+        if( timeline.empty() ) continue;
+        int64_t zoneEnd;
+        if( timeline.is_magic() )
+        {
+            auto& vec = *(Vector<ZoneEvent>*)&timeline;
+            auto it = std::lower_bound( vec.begin(), vec.end(), end, []( const auto& l, int64_t r ) { return l.Start() < r; } );
+            if( it == vec.begin() ) continue;
+            zoneEnd = m_worker->GetZoneEnd( *(it-1) );
+        }
+        else
+        {
+            auto it = std::lower_bound( timeline.begin(), timeline.end(), end, []( const auto& l, int64_t r ) { return l->Start() < r; } );
+            if( it == timeline.begin() ) continue;
+            zoneEnd = m_worker->GetZoneEnd( **(it-1) );
+        }
+        const auto zoneInside = zoneEnd <= end;
+        zoneEnd = std::min( zoneEnd, end );
+        if( zoneEnd <= start ) continue;
+        if( thread != 0 )
+        {
+            if( zoneInside != inside )
+            {
+                if( !zoneInside ) continue;
+            }
+            else if( zoneEnd != t )
+            {
+                if( zoneEnd < t ) continue;
+            }
+            else if( v.first > thread ) continue;
+        }
+        t = zoneEnd;
+        thread = v.first;
+        inside = zoneInside;
+    }
+    if( thread == 0 ) return;
+
+    auto segEnd = t;
+    while( t > start )
+    {
+        const auto& waits = m_index.find( thread )->second.waits;
+        auto it = std::upper_bound( waits.begin(), waits.end(), t, []( int64_t l, const auto& r ) { return l < r.end; } );
+        const Wait* wait = nullptr;
+        while( it != waits.begin() )
+        {
+            --it;
+            if( it->end <= start ) break;
+            if( it->wakeTime < t && m_index.find( it->waker ) != m_index.end() )
+            {
+                wait = &*it;
+                break;
+            }
+        }
+        if( !wait )
+        {
+            segments.emplace_back( Segment { thread, start, segEnd, Edge::None, NoLock } );
+            break;
+        }
+        const auto edge = wait->lock != NoLock ? Edge::Lock : Edge::Wakeup;
+        segments.emplace_back( Segment { thread, std::max( wait->wakeTime, start ), segEnd, edge, wait->lock } );
+        thread = wait->waker;
+        t = segEnd = wait->wakeTime;
+    }
+    std::reverse( segments.begin(), segments.end() );
+}
+
+template<typename Func>
+void CriticalPath::CollectZones( const Segment& segment, const Func& func )
+{
+    const auto& timeline = m_index.find( segment.thread )->second.td->timeline;
+    if( timeline.is_magic() )
+    {
+        CollectZones( *(Vector<ZoneEvent>*)&timeline, nullptr, segment.thread, segment.start, segment.end, func );
+    }
+    else
+    {
+        CollectZones( timeline, nullptr, segment.thread, segment.start, segment.end, func );
+    }
+}
+
+template<typename V, typename Func>
+void CriticalPath::CollectZones( const V& zones, const ZoneEvent* parent, uint64_t thread, int64_t start, int64_t end, const Func& func )
+{
+    auto it = std::lower_bound( zones.begin(), zones.end(), start, [this]( const auto& l, int64_t r ) { return m_worker->GetZoneEnd( Deref( l ) ) <= r; } );
+    auto cursor = start;
+    for( ; it != zones.end(); ++it )
+    {
+        const auto& zone = Deref( *it );
+        const auto zs = std::max( zone.Start(), start );
+        if( zs >= end ) break;
+        const auto ze = std::min( m_worker->GetZoneEnd( zone ), end );
+        if( ze <= zs ) continue;
+        if( zs > cursor ) func( parent, thread, cursor, zs );
+        if( zone.HasChildren() )
+        {
+            auto& children = m_worker->GetZoneChildren( zone.Child() );
+            if( children.is_magic() )
+            {
+                CollectZones( *(Vector<ZoneEvent>*)&children, &zone, thread, zs, ze, func );
+            }
+            else
+            {
+                CollectZones( children, &zone, thread, zs, ze, func );
+            }
+        }
+        else
+        {
+            func( &zone, thread, zs, ze );
+        }
+        cursor = ze;
+    }
+    if( cursor < end ) func( parent, thread, cursor, end );
+}
+
+void CriticalPath::ProcessFrame( size_t frame, int64_t start, int64_t end, FrameState& state )
+{
+    if( end <= start ) return;
+    state.frames++;
+    state.totalTime += end - start;
+
+    auto& segments = state.segments;
+    segments.clear();
+    ComputeSegments( start, end, segments );
+
+    int64_t tracked = 0;
+    for( auto& segment : segments )
+    {
+        state.threads[segment.thread] += segment.end - segment.start;
+        CollectZones( segment, [&state, &tracked, frame] ( const ZoneEvent* zone, uint64_t, int64_t t0, int64_t t1 ) {
+            if( !zone ) return;
+            auto it = state.srcloc.find( zone->SrcLoc() );
+            if( it == state.srcloc.end() ) it = state.srcloc.emplace( zone->SrcLoc(), SrcLocState { 0, 0, 0, 0, std::numeric_limits<size_t>::max() } ).first;
+            auto& sl = it->second;
+            if( sl.lastFrame != frame )
+            {
+                sl.maxTime = std::max( sl.maxTime, sl.frameTime );
+                sl.frameTime = 0;
+                sl.frames++;
+                sl.lastFrame = frame;
+            }
+            sl.time += t1 - t0;
+            sl.frameTime += t1 - t0;
+            tracked += t1 - t0;
+        } );
+    }
+    state.untracked += end - start - tracked;
+
+    if( end - start > state.longestTime )
+    {
+        state.longestTime = end - start;
+        state.longestFrame = frame;
+        state.longestStart = start;
+    }
+}
+
+void CriticalPath::Merge()
+{
+    unordered_flat_map<int16_t, SrcLocResult> srcloc;
+    unordered_flat_map<uint64_t, int64_t> threads;
+    int64_t longest = 0;
+    for( auto& state : m_state )
+    {
+        for( auto& v : state.srcloc )
+        {
+            const auto maxTime = std::max( v.second.maxTime, v.second.frameTime );
+            auto it = srcloc.find( v.first );
+            if( it == srcloc.end() )
+            {
+                srcloc.emplace( v.first, SrcLocResult { v.first, v.second.time, maxTime, v.second.frames } );
+            }
+            else
+            {
+                it->second.time += v.second.time;
+                it->second.maxTime = std::max( it->second.maxTime, maxTime );
+                it->second.frames += v.second.frames;
+            }
+        }
+        for( auto& v : state.threads ) threads[v.first] += v.second;
+        m_frameCount += state.frames;
+        m_totalTime += state.totalTime;
+        m_untracked += state.untracked;
+        if( state.longestTime > longest )
+        {
+            longest = state.longestTime;
+            m_pathFrame = state.longestFrame;
+            m_pathStart = state.longestStart;
+            m_pathEnd = state.longestStart + state.longestTime;
+        }
+    }
+
+    m_srcloc.reserve( srcloc.size() );
+    for( auto& v : srcloc ) m_srcloc.emplace_back( v.second );
+    m_threads.reserve( threads.size() );
+    for( auto& v : threads ) m_threads.emplace_back( ThreadResult { v.first, v.second } );
+    if( longest == 0 ) return;
+
+    auto lock = LockData();
+    ComputeSegments( m_pathStart, m_pathEnd, m_segments );
+    for( auto& segment : m_segments )
+    {
+        CollectZones( segment, [this] ( const ZoneEvent* zone, uint64_t thread, int64_t t0, int64_t t1 ) {
+            if( !m_path.empty() )
+            {
+                auto& back = m_path.back();
+                if( back.zone == zone && back.thread == thread && back.end == t0 )
+                {
+                    back.end = t1;
+                    return;
+                }
+            }
+            m_path.emplace_back( PathZone { zone, thread, t0, t1 } );
+        } );
+    }
+}
+
+}
@@ -0,0 +1,160 @@
+#ifndef __TRACYCRITICALPATH_HPP__
+#define __TRACYCRITICALPATH_HPP__
+
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+#include "TracyAnalysisEngine.hpp"
+#include "TracyEvent.hpp"
+
+namespace tracy
+{
+
+// Chain of thread activity which bounded the duration of a frame or a time range.
+// The path is walked backwards from the thread which finished last. Whenever the
+// current thread was waiting, the path continues in the thread that ended the wait:
+// the thread which released the awaited lock, or the thread which woke it up (found
+// through the context switch data). Waits without a known cause stay on the same
+// thread. The path time is attributed to the innermost zones running on the path.
+class CriticalPath : public AnalysisEngine
+{
+public:
+    enum { NoLock = std::numeric_limits<uint32_t>::max() };
+
+    enum class Edge : uint8_t
+    {
+        None,
+        Lock,
+        Wakeup
+    };
+
+    // Activity of one thread on the path. The edge tells how the previous segment
+    // unblocked this thread.
+    struct Segment
+    {
+        uint64_t thread;
+        int64_t start;
+        int64_t end;
+        Edge edge;
+        uint32_t lock;
+    };
+
+    // Part of the path spent in a zone, excluding the time spent in its children on
+    // the path. The zone is null for path time outside of zones.
+    struct PathZone
+    {
+        const ZoneEvent* zone;
+        uint64_t thread;
+        int64_t start;
+        int64_t end;
+    };
+
+    struct SrcLocResult
+    {
+        int16_t srcloc;
+        int64_t time;
+        int64_t maxTime;        // in a single frame
+        uint32_t frames;
+    };
+
+    struct ThreadResult
+    {
+        uint64_t thread;
+        int64_t time;
+    };
+
+    // If frames is set, the critical path is computed for every frame of the set which
+    // lies within the range, and the path of the longest frame is kept. Otherwise a
+    // single path covering the range is computed.
+    CriticalPath( Worker& worker, const FrameData* frames, int64_t start, int64_t end );
+
+    // One unit of progress per lock and thread indexed, and per chunk of frames.
+    void Process( TaskDispatch& td );
+
+    const FrameData* GetFrames() const { return m_frames; }
+    size_t GetFrameCount() const { return m_frameCount; }
+    // Frame (or range) the detailed path was computed for.
+    int64_t GetPathStart() const { return m_pathStart; }
+    int64_t GetPathEnd() const { return m_pathEnd; }
+    size_t GetPathFrame() const { return m_pathFrame; }
+
+    const std::vector<Segment>& GetSegments() const { return m_segments; }
+    const std::vector<PathZone>& GetPath() const { return m_path; }
+    const std::vector<SrcLocResult>& GetSourceLocations() const { return m_srcloc; }
+    const std::vector<ThreadResult>& GetThreads() const { return m_threads; }
+    // Sum of the durations of all processed frames, and the part of it not spent in zones.
+    int64_t GetTotalTime() const { return m_totalTime; }
+    int64_t GetUntrackedTime() const { return m_untracked; }
+
+private:
+    // Interval during which a thread was waiting, and the thread (and time) which ended
+    // the wait. Waits with an unknown cause are not indexed.
+    struct Wait
+    {
+        int64_t start;
+        int64_t end;
+        uint64_t waker;
+        int64_t wakeTime;
+        uint32_t lock;
+    };
+
+    struct ThreadIndex
+    {
+        const ThreadData* td;
+        std::vector<Wait> waits;
+    };
+
+    struct SrcLocState
+    {
+        int64_t time;
+        int64_t maxTime;
+        int64_t frameTime;
+        uint32_t frames;
+        size_t lastFrame;
+    };
+
+    struct FrameState
+    {
+        std::vector<Segment> segments;
+        unordered_flat_map<int16_t, SrcLocState> srcloc;
+        unordered_flat_map<uint64_t, int64_t> threads;
+        size_t frames = 0;
+        int64_t totalTime = 0;
+        int64_t untracked = 0;
+        size_t longestFrame = 0;
+        int64_t longestStart = 0;
+        int64_t longestTime = -1;
+    };
+
+    void IndexLock( const LockMap& lockmap, uint32_t id, std::vector<std::pair<uint64_t, Wait>>& out );
+    void IndexThread( uint64_t thread, const ContextSwitch& cs, std::vector<Wait>& out );
+
+    void ComputeSegments( int64_t start, int64_t end, std::vector<Segment>& segments ) const;
+    template<typename Func> void CollectZones( const Segment& segment, const Func& func );
+    template<typename V, typename Func> void CollectZones( const V& zones, const ZoneEvent* parent, uint64_t thread, int64_t start, int64_t end, const Func& func );
+    void ProcessFrame( size_t frame, int64_t start, int64_t end, FrameState& state );
+    void Merge();
+
+    const FrameData* m_frames;
+    int64_t m_start;
+    int64_t m_end;
+
+    unordered_flat_map<uint64_t, ThreadIndex> m_index;
+    std::vector<FrameState> m_state;
+
+    size_t m_frameCount;
+    int64_t m_pathStart;
+    int64_t m_pathEnd;
+    size_t m_pathFrame;
+    std::vector<Segment> m_segments;
+    std::vector<PathZone> m_path;
+    std::vector<SrcLocResult> m_srcloc;
+    std::vector<ThreadResult> m_threads;
+    int64_t m_totalTime;
+    int64_t m_untracked;
+};
+
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <string>
 #include <string.h>
+#include <vector>
 
 #include "TracyCharUtil.hpp"
 #include "TracyShortPtr.hpp"
@@ -277,6 +278,20 @@ struct SampleDataRange
 enum { SampleDataRangeSize = sizeof( SampleDataRange ) };
 
 
+struct SymbolCount
+{
+    uint32_t incl, excl;
+};
+
+struct SampleBlockCount
+{
+    uint64_t symAddr;
+    SymbolCount count;
+};
+
+enum { SampleBlockCountSize = sizeof( SampleBlockCount ) };
+
+
 struct HwSampleData
 {
     SortedVector<Int48, Int48Sort> cycles;
@@ -737,6 +752,9 @@ struct ThreadData
     Vector<GhostZone> ghostZones;
     uint64_t ghostIdx;
     SortedVector<SampleData, SampleDataSort> postponedSamples;
+    Vector<Vector<SampleBlockCount>> sampleBlocks;
+    uint64_t offCpuIdx;                                 // context switch samples already attributed
+    unordered_flat_map<uint32_t, int64_t> offCpuStacks;  // callstack -> time spent switched out
 #endif
     Vector<SampleData> samples;
     SampleData pendingSample;
@@ -751,10 +769,22 @@ struct ThreadData
     tracy_force_inline bool DecStackCount( int16_t srcloc ) { return --stackCount[uint16_t(srcloc)] != 0; }
 };
 
+struct FlameGraphItem
+{
+    int64_t srcloc;
+    int64_t time;
+    StringIdx name;
+    int64_t begin;
+    std::vector<FlameGraphItem> children;
+};
+
 struct GpuCtxThreadData
 {
     Vector<short_ptr<GpuEvent>> timeline;
     Vector<short_ptr<GpuEvent>> stack;
+#ifndef TRACY_NO_STATISTICS
+    uint64_t flameGraphIdx;
+#endif
 };
 
 struct GpuCtxData
@@ -775,6 +805,9 @@ struct GpuCtxData
     StringIdx name;
     unordered_flat_map<uint64_t, GpuCtxThreadData> threadData;
     short_ptr<GpuEvent> query[64*1024];
+#ifndef TRACY_NO_STATISTICS
+    std::vector<FlameGraphItem> flameGraph;
+#endif
 };
 
 enum { GpuCtxDataSize = sizeof( GpuCtxData ) };
@@ -797,6 +830,12 @@ enum class PlotValueFormatting : uint8_t
     Watt
 };
 
+struct PlotLodItem
+{
+    uint32_t min;
+    uint32_t max;
+};
+
 struct PlotData
 {
     struct PlotItemSort { bool operator()( const PlotItem& lhs, const PlotItem& rhs ) const { return lhs.time.Val() < rhs.time.Val(); }; };
@@ -813,6 +852,17 @@ struct PlotData
     uint32_t color;
 
     double rMin, rMax, num;
+
+    // Indices of min and max values in blocks of consecutive data points, each level doubling the
+    // block size. Built lazily, see Worker::UpdatePlotLod().
+    std::vector<std::vector<PlotLodItem>> lod;
+};
+
+struct MemCheckpoint
+{
+    int64_t time;
+    uint32_t next;                  // first allocation made after the checkpoint
+    std::vector<uint32_t> live;     // allocations live at checkpoint time, in allocation order
 };
 
 struct MemData
@@ -826,6 +876,7 @@ struct MemData
     PlotData* plot = nullptr;
     bool reconstruct = false;
     uint64_t name = 0;
+    std::vector<MemCheckpoint> checkpoints;    // see Worker::UpdateMemoryCheckpoints()
 };
 
 struct FrameData
@@ -906,16 +957,6 @@ struct SymbolStats
 
 enum { SymbolStatsSize = sizeof( SymbolStats ) };
 
-
-struct FlameGraphItem
-{
-    int64_t srcloc;
-    int64_t time;
-    StringIdx name;
-    int64_t begin;
-    std::vector<FlameGraphItem> children;
-};
-
 }
 
 #endif
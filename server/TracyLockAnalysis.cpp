@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <assert.h>
+
+#include "TracyLockAnalysis.hpp"
+#include "TracyPopcnt.hpp"
+#include "TracyTaskDispatch.hpp"
+#include "TracyWorker.hpp"
+
+namespace tracy
+{
+
+static void AddStats( LockAnalysis::Stats& dst, const LockAnalysis::Stats& src )
+{
+    dst.acquisitions += src.acquisitions;
+    dst.contended += src.contended;
+    dst.wait += src.wait;
+    dst.waitMax = std::max( dst.waitMax, src.waitMax );
+    dst.hold += src.hold;
+    dst.holdMax = std::max( dst.holdMax, src.holdMax );
+    dst.blocking += src.blocking;
+}
+
+static bool WaitCompare( const LockAnalysis::WaitResult& lhs, const LockAnalysis::WaitResult& rhs )
+{
+    return lhs.end - lhs.start > rhs.end - rhs.start;
+}
+
+static bool ConvoyCompare( const LockAnalysis::Convoy& lhs, const LockAnalysis::Convoy& rhs )
+{
+    return lhs.end - lhs.start > rhs.end - rhs.start;
+}
+
+template<typename T, typename Compare>
+static void PushTop( std::vector<T>& top, size_t limit, const T& item, Compare compare )
+{
+    if( top.size() < limit )
+    {
+        top.emplace_back( item );
+        std::push_heap( top.begin(), top.end(), compare );
+    }
+    else if( compare( item, top.front() ) )
+    {
+        std::pop_heap( top.begin(), top.end(), compare );
+        top.back() = item;
+        std::push_heap( top.begin(), top.end(), compare );
+    }
+}
+
+
+LockAnalysis::LockAnalysis( Worker& worker )
+    : AnalysisEngine( worker )
+{
+}
+
+void LockAnalysis::Process( TaskDispatch& td )
+{
+    Begin();
+    {
+        auto lock = LockData();
+
+        for( auto& v : m_worker->GetLockMap() )
+        {
+            if( !v.second->valid || v.second->timeline.empty() ) continue;
+            m_locks.emplace_back( LockResult { v.first, v.second } );
+        }
+    }
+    m_state.resize( m_locks.size() );
+    SetTotal( m_locks.size() );
+
+    QueueTasks( td, m_locks.size(), [this] ( size_t i ) { ProcessLock( m_locks[i], m_state[i] ); } );
+    td.Sync();
+
+    if( !IsAborted() ) Merge();
+    m_state.clear();
+    m_state.shrink_to_fit();
+    Finish();
+}
+
+void LockAnalysis::ProcessLock( LockResult& res, LockState& state )
+{
+    auto lock = LockData();
+
+    struct Waiter
+    {
+        int64_t start;
+        int16_t srcloc;
+        bool contended;
+        uint8_t holder;
+        int16_t holderSrcLoc;
+        int64_t holderTime;
+    };
+    struct Holder
+    {
+        int64_t start;
+        int16_t srcloc;
+    };
+
+    enum { NoThread = 0xFF };
+    Waiter waiters[MaxLockThreads];
+    Holder shared[MaxLockThreads];
+    for( auto& w : waiters ) w.start = -1;
+    for( auto& s : shared ) s.start = -1;
+    Holder exclusive = { -1, 0 };
+    uint8_t holdThread = NoThread;
+
+    const auto& lockmap = *res.lock;
+    const auto& tl = lockmap.timeline;
+    const bool isShared = lockmap.type == LockType::SharedLockable;
+    auto& stats = res.stats;
+    res.events = tl.size();
+    res.maxWaiters = 0;
+
+    auto GetSrcLoc = [&state] ( int16_t srcloc ) -> Stats& {
+        auto it = state.srcloc.find( srcloc );
+        if( it == state.srcloc.end() ) it = state.srcloc.emplace( srcloc, SrcLocResult { srcloc } ).first;
+        return it->second.stats;
+    };
+    auto AddHold = [&] ( int16_t srcloc, int64_t time ) {
+        auto& sl = GetSrcLoc( srcloc );
+        sl.hold += time;
+        sl.holdMax = std::max( sl.holdMax, time );
+        stats.hold += time;
+        stats.holdMax = std::max( stats.holdMax, time );
+        state.holds.emplace_back( Sample { srcloc, time } );
+    };
+
+    uint8_t lockCount = 0;
+    uint8_t lockingThread = 0;
+    uint64_t waitList = 0;
+    uint64_t waitShared = 0;
+    uint64_t sharedList = 0;
+    int64_t prevTime = 0;
+
+    bool inConvoy = false;
+    Convoy convoy = {};
+
+    for( auto& v : tl )
+    {
+        const auto& ev = *v.ptr;
+        const auto time = ev.Time();
+        const auto thread = ev.thread;
+        const auto tbit = uint64_t( 1 ) << thread;
+        const auto waiting = waitList | waitShared;
+
+        if( waiting != 0 && time > prevTime )
+        {
+            if( lockCount != 0 && holdThread != NoThread )
+            {
+                const auto blocking = ( time - prevTime ) * TracyCountBits( waiting & ~( uint64_t( 1 ) << holdThread ) );
+                stats.blocking += blocking;
+                GetSrcLoc( exclusive.srcloc ).blocking += blocking;
+            }
+            else if( sharedList != 0 )
+            {
+                stats.blocking += ( time - prevTime ) * TracyCountBits( waitList & ~sharedList );
+            }
+        }
+
+        switch( ev.type )
+        {
+        case LockEvent::Type::Wait:
+        case LockEvent::Type::WaitShared:
+        {
+            auto& w = waiters[thread];
+            w.start = time;
+            w.srcloc = ev.SrcLoc();
+            w.contended = ( lockCount != 0 && lockingThread != thread ) || ( ev.type == LockEvent::Type::Wait && ( sharedList & ~tbit ) != 0 );
+            w.holder = NoThread;
+            w.holderTime = 0;
+            break;
+        }
+        case LockEvent::Type::Obtain:
+        case LockEvent::Type::ObtainShared:
+        {
+            if( inConvoy ) convoy.handoffs++;
+            if( ev.type == LockEvent::Type::Obtain )
+            {
+                if( lockCount == 0 )
+                {
+                    exclusive = { time, ev.SrcLoc() };
+                    holdThread = thread;
+                }
+            }
+            else
+            {
+                shared[thread] = { time, ev.SrcLoc() };
+            }
+
+            auto& w = waiters[thread];
+            if( w.start < 0 ) break;
+            const auto wait = time - w.start;
+            auto& sl = GetSrcLoc( w.srcloc );
+            sl.acquisitions++;
+            sl.wait += wait;
+            sl.waitMax = std::max( sl.waitMax, wait );
+            stats.acquisitions++;
+            stats.wait += wait;
+            stats.waitMax = std::max( stats.waitMax, wait );
+            if( w.contended )
+            {
+                sl.contended++;
+                stats.contended++;
+            }
+            state.waits.emplace_back( Sample { w.srcloc, wait } );
+            if( wait > 0 )
+            {
+                WaitResult item = { res.id, lockmap.threadList[thread], w.srcloc, w.start, time, 0, 0, w.holderTime };
+                if( w.holder != NoThread )
+                {
+                    item.holder = lockmap.threadList[w.holder];
+                    item.holderSrcLoc = w.holderSrcLoc;
+                }
+                PushTop( state.waitHeap, TopWaits, item, WaitCompare );
+            }
+            w.start = -1;
+            break;
+        }
+        case LockEvent::Type::Release:
+            if( lockCount != 1 || holdThread == NoThread ) break;
+            AddHold( exclusive.srcloc, time - exclusive.start );
+            // Record the holder against every thread that was waiting for this hold to end.
+            for( uint64_t bits = waiting & ~( uint64_t( 1 ) << holdThread ); bits != 0; bits &= bits - 1 )
+            {
+                auto& w = waiters[TracyCountBits( ( bits & ~( bits - 1 ) ) - 1 )];
+                if( w.start < 0 ) continue;
+                const auto overlap = time - std::max( w.start, exclusive.start );
+                if( overlap > w.holderTime )
+                {
+                    w.holder = holdThread;
+                    w.holderSrcLoc = exclusive.srcloc;
+                    w.holderTime = overlap;
+                }
+            }
+            holdThread = NoThread;
+            break;
+        case LockEvent::Type::ReleaseShared:
+            if( shared[thread].start < 0 ) break;
+            AddHold( shared[thread].srcloc, time - shared[thread].start );
+            shared[thread].start = -1;
+            break;
+        default:
+            assert( false );
+            break;
+        }
+
+        lockCount = v.lockCount;
+        lockingThread = v.lockingThread;
+        waitList = v.waitList;
+        if( isShared )
+        {
+            const auto evs = (const LockEventShared*)(const LockEvent*)v.ptr;
+            waitShared = evs->waitShared;
+            sharedList = evs->sharedList;
+        }
+        prevTime = time;
+
+        const auto queue = waitList | waitShared;
+        if( queue != 0 )
+        {
+            const uint32_t count = TracyCountBits( queue );
+            res.maxWaiters = std::max( res.maxWaiters, count );
+            if( !inConvoy )
+            {
+                inConvoy = true;
+                convoy = { res.id, time, time, 0, count };
+            }
+            else
+            {
+                convoy.maxWaiters = std::max( convoy.maxWaiters, count );
+            }
+        }
+        else if( inConvoy )
+        {
+            inConvoy = false;
+            convoy.end = time;
+            // A single handoff is an ordinary acquisition, as every lock is waited for.
+            if( convoy.handoffs > 1 ) PushTop( state.convoyHeap, TopConvoys, convoy, ConvoyCompare );
+        }
+    }
+
+    stats.waitDist.Init( 1, std::max<int64_t>( 1, stats.waitMax ) );
+    stats.holdDist.Init( 1, std::max<int64_t>( 1, stats.holdMax ) );
+    for( auto& s : state.waits ) stats.waitDist.Add( s.time );
+    for( auto& s : state.holds ) stats.holdDist.Add( s.time );
+}
+
+void LockAnalysis::Merge()
+{
+    unordered_flat_map<int16_t, SrcLocResult> srcloc;
+    for( auto& state : m_state )
+    {
+        for( auto& v : state.srcloc )
+        {
+            auto it = srcloc.find( v.first );
+            if( it == srcloc.end() )
+            {
+                srcloc.emplace( v.first, v.second );
+            }
+            else
+            {
+                AddStats( it->second.stats, v.second.stats );
+            }
+        }
+        m_waits.insert( m_waits.end(), state.waitHeap.begin(), state.waitHeap.end() );
+        m_convoys.insert( m_convoys.end(), state.convoyHeap.begin(), state.convoyHeap.end() );
+    }
+
+    // The distribution ranges are known only after all locks are processed.
+    for( auto& v : srcloc )
+    {
+        auto& stats = v.second.stats;
+        stats.waitDist.Init( 1, std::max<int64_t>( 1, stats.waitMax ) );
+        stats.holdDist.Init( 1, std::max<int64_t>( 1, stats.holdMax ) );
+    }
+    for( auto& state : m_state )
+    {
+        for( auto& s : state.waits ) srcloc.find( s.srcloc )->second.stats.waitDist.Add( s.time );
+        for( auto& s : state.holds ) srcloc.find( s.srcloc )->second.stats.holdDist.Add( s.time );
+    }
+
+    m_srcloc.reserve( srcloc.size() );
+    for( auto& v : srcloc ) m_srcloc.emplace_back( std::move( v.second ) );
+
+    std::sort( m_waits.begin(), m_waits.end(), WaitCompare );
+    if( m_waits.size() > TopWaits ) m_waits.resize( TopWaits );
+    std::sort( m_convoys.begin(), m_convoys.end(), ConvoyCompare );
+    if( m_convoys.size() > TopConvoys ) m_convoys.resize( TopConvoys );
+}
+
+}
@@ -0,0 +1,120 @@
+#ifndef __TRACYLOCKANALYSIS_HPP__
+#define __TRACYLOCKANALYSIS_HPP__
+
+#include <stdint.h>
+#include <vector>
+
+#include "TracyAnalysisEngine.hpp"
+#include "TracyCompare.hpp"
+#include "TracyEvent.hpp"
+
+namespace tracy
+{
+
+// Lock contention statistics, derived from the lock event timelines. Wait time is measured
+// from the wait event to the obtain event of a thread. Hold time is measured from the first
+// obtain to the last release of an exclusive lock, or from a shared obtain to its release.
+// An acquisition is contended if another thread was holding the lock when the wait started.
+// The time other threads spent waiting while the lock was held exclusively is blocking time
+// of the holder.
+class LockAnalysis : public AnalysisEngine
+{
+public:
+    enum { TopWaits = 100 };
+    enum { TopConvoys = 100 };
+
+    struct Stats
+    {
+        uint64_t acquisitions = 0;
+        uint64_t contended = 0;
+        int64_t wait = 0;
+        int64_t waitMax = 0;
+        int64_t hold = 0;
+        int64_t holdMax = 0;
+        int64_t blocking = 0;
+        LogSketch waitDist;
+        LogSketch holdDist;
+    };
+
+    struct LockResult
+    {
+        uint32_t id;
+        const LockMap* lock;
+        uint64_t events;
+        uint32_t maxWaiters;
+        Stats stats;
+    };
+
+    // Statistics of the acquisition site. Blocking time is counted for the site which
+    // obtained the lock.
+    struct SrcLocResult
+    {
+        int16_t srcloc;
+        Stats stats;
+    };
+
+    // The critical holder is the thread which held the lock for the longest part of the
+    // wait. It is not known (zero) if the lock was only held in shared mode.
+    struct WaitResult
+    {
+        uint32_t lock;
+        uint64_t thread;
+        int16_t srcloc;
+        int64_t start;
+        int64_t end;
+        uint64_t holder;
+        int16_t holderSrcLoc;
+        int64_t holderTime;
+    };
+
+    // A period during which the wait queue of a lock was never empty. Each handoff is an
+    // acquisition by a queued thread.
+    struct Convoy
+    {
+        uint32_t lock;
+        int64_t start;
+        int64_t end;
+        uint32_t handoffs;
+        uint32_t maxWaiters;
+    };
+
+    explicit LockAnalysis( Worker& worker );
+
+    // One unit of progress per valid lock.
+    void Process( TaskDispatch& td );
+
+    const std::vector<LockResult>& GetLocks() const { return m_locks; }
+    const std::vector<SrcLocResult>& GetSourceLocations() const { return m_srcloc; }
+    // Longest waits and convoys, in descending order.
+    const std::vector<WaitResult>& GetLongestWaits() const { return m_waits; }
+    const std::vector<Convoy>& GetLongestConvoys() const { return m_convoys; }
+
+private:
+    struct Sample
+    {
+        int16_t srcloc;
+        int64_t time;
+    };
+
+    struct LockState
+    {
+        std::vector<Sample> waits;
+        std::vector<Sample> holds;
+        unordered_flat_map<int16_t, SrcLocResult> srcloc;
+        std::vector<WaitResult> waitHeap;
+        std::vector<Convoy> convoyHeap;
+    };
+
+    void ProcessLock( LockResult& res, LockState& state );
+    void Merge();
+
+    std::vector<LockResult> m_locks;
+    std::vector<LockState> m_state;
+    std::vector<SrcLocResult> m_srcloc;
+    std::vector<WaitResult> m_waits;
+    std::vector<Convoy> m_convoys;
+};
+
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <assert.h>
+
+#include "TracySchedulerAnalysis.hpp"
+#include "TracyTaskDispatch.hpp"
+#include "TracyWorker.hpp"
+
+namespace tracy
+{
+
+bool SchedulerAnalysis::IsPreempted( const ContextSwitchData& cs )
+{
+    switch( cs.Reason() )
+    {
+    case ContextSwitchData::Win32_WrQuantumEnd:
+    case ContextSwitchData::Win32_WrPreempted:
+    case ContextSwitchData::Win32_WrDeferredPreempt:
+        return true;
+    default:
+        break;
+    }
+    switch( cs.State() )
+    {
+    case 1:     // Windows, ready
+    case 7:     // Windows, deferred ready
+    case 103:   // Linux, R (running or on run queue)
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void AddStats( SchedulerAnalysis::Stats& dst, const SchedulerAnalysis::Stats& src )
+{
+    dst.periods += src.periods;
+    dst.preemptions += src.preemptions;
+    dst.migrations += src.migrations;
+    dst.offCpu += src.offCpu;
+    dst.blocked += src.blocked;
+    dst.runQueue += src.runQueue;
+    dst.preempted += src.preempted;
+    dst.maxRunQueue = std::max( dst.maxRunQueue, src.maxRunQueue );
+}
+
+static bool TopCompare( const SchedulerAnalysis::ZoneResult& lhs, const SchedulerAnalysis::ZoneResult& rhs )
+{
+    return lhs.preempted > rhs.preempted;
+}
+
+
+SchedulerAnalysis::SchedulerAnalysis( Worker& worker )
+    : AnalysisEngine( worker )
+{
+}
+
+void SchedulerAnalysis::Process( TaskDispatch& td )
+{
+    Begin();
+    {
+        auto lock = LockData();
+
+        unordered_flat_map<uint64_t, const ThreadData*> threads;
+        for( auto& t : m_worker->GetThreadData() ) threads.emplace( t->id, t );
+
+        for( auto& v : m_worker->GetContextSwitchMap() )
+        {
+            auto it = threads.find( v.first );
+            const ThreadData* thread = it != threads.end() ? it->second : nullptr;
+            if( thread && thread->isFiber ) continue;
+            m_threads.emplace_back( ThreadResult { v.first } );
+            m_state.emplace_back( ThreadState { v.second, thread } );
+        }
+    }
+    SetTotal( m_threads.size() );
+
+    QueueTasks( td, m_threads.size(), [this] ( size_t i ) { ProcessThread( m_threads[i], m_state[i] ); } );
+    td.Sync();
+
+    if( !IsAborted() ) Merge();
+    m_state.clear();
+    m_state.shrink_to_fit();
+    Finish();
+}
+
+void SchedulerAnalysis::ProcessThread( ThreadResult& res, ThreadState& state )
+{
+    auto lock = LockData();
+
+    CollectGaps( res, state );
+    if( state.td && !state.gaps.empty() && !state.td->timeline.empty() )
+    {
+        ProcessZones( state, res.thread, state.td->timeline );
+    }
+    state.gaps.clear();
+    state.gaps.shrink_to_fit();
+}
+
+void SchedulerAnalysis::CollectGaps( ThreadResult& res, ThreadState& state )
+{
+    auto& v = state.cs->v;
+    auto& gaps = state.gaps;
+    auto& stats = res.stats;
+    res.running = state.cs->runningTime;
+
+    int64_t maxOffCpu = 1;
+    for( size_t i=1; i<v.size(); i++ )
+    {
+        auto& prev = v[i-1];
+        auto& ev = v[i];
+        // The last item may be a wakeup of a thread that is not running yet.
+        if( !prev.IsEndValid() || ev.Reason() == ContextSwitchData::Wakeup ) continue;
+        if( prev.Reason() == ContextSwitchData::Fiber ) continue;
+        const auto start = prev.End();
+        const auto end = ev.Start();
+        if( end < start ) continue;
+
+        const bool preempted = IsPreempted( prev );
+        const auto wakeup = preempted ? start : std::clamp( ev.WakeupVal(), start, end );
+        const bool migration = prev.Cpu() != ev.Cpu();
+        gaps.emplace_back( Gap { start, wakeup, end, preempted, migration } );
+
+        const auto offCpu = end - start;
+        const auto runQueue = end - wakeup;
+        stats.periods++;
+        stats.offCpu += offCpu;
+        stats.blocked += wakeup - start;
+        stats.runQueue += runQueue;
+        stats.maxRunQueue = std::max( stats.maxRunQueue, runQueue );
+        if( preempted )
+        {
+            stats.preemptions++;
+            stats.preempted += offCpu;
+        }
+        if( migration ) stats.migrations++;
+        maxOffCpu = std::max( maxOffCpu, offCpu );
+    }
+
+    res.wakeupLatency.Init( 1, std::max<int64_t>( 1, stats.maxRunQueue ) );
+    res.runQueue.Init( 1, std::max<int64_t>( 1, stats.maxRunQueue ) );
+    res.offCpu.Init( 1, maxOffCpu );
+    for( auto& g : gaps )
+    {
+        if( !g.preempted ) res.wakeupLatency.Add( g.end - g.wakeup );
+        res.runQueue.Add( g.end - g.wakeup );
+        res.offCpu.Add( g.end - g.start );
+    }
+}
+
+void SchedulerAnalysis::ProcessZones( ThreadState& state, uint64_t thread, const Vector<short_ptr<ZoneEvent>>& zones )
+{
+    if( zones.is_magic() )
+    {
+        auto& vec = *(Vector<ZoneEvent>*)&zones;
+        for( auto& v : vec ) ProcessZone( state, thread, v );
+    }
+    else
+    {
+        for( auto& v : zones ) ProcessZone( state, thread, *v );
+    }
+}
+
+void SchedulerAnalysis::ProcessZone( ThreadState& state, uint64_t thread, const ZoneEvent& zone )
+{
+    if( !zone.IsEndValid() ) return;
+    const auto zs = zone.Start();
+    const auto ze = zone.End();
+    if( ze <= zs ) return;
+
+    Stats stats;
+    auto& gaps = state.gaps;
+    auto it = std::lower_bound( gaps.begin(), gaps.end(), zs, []( const Gap& l, int64_t r ) { return l.end <= r; } );
+    for( ; it != gaps.end() && it->start < ze; ++it )
+    {
+        const auto t0 = std::max( it->start, zs );
+        const auto t1 = std::min( it->end, ze );
+        if( t1 <= t0 ) continue;
+        const auto wakeup = std::clamp( it->wakeup, t0, t1 );
+        stats.periods++;
+        stats.offCpu += t1 - t0;
+        stats.blocked += wakeup - t0;
+        stats.runQueue += t1 - wakeup;
+        stats.maxRunQueue = std::max( stats.maxRunQueue, t1 - wakeup );
+        if( it->preempted )
+        {
+            stats.preemptions++;
+            stats.preempted += t1 - t0;
+        }
+        if( it->migration ) stats.migrations++;
+    }
+
+    const auto srcloc = zone.SrcLoc();
+    auto sit = state.srcloc.find( srcloc );
+    if( sit == state.srcloc.end() ) sit = state.srcloc.emplace( srcloc, SrcLocResult { srcloc } ).first;
+    sit->second.zones++;
+    sit->second.time += ze - zs;
+    AddStats( sit->second.stats, stats );
+
+    if( stats.preempted > 0 )
+    {
+        auto& top = state.top;
+        if( top.size() < TopZones )
+        {
+            top.emplace_back( ZoneResult { &zone, thread, stats.preempted, stats.offCpu } );
+            std::push_heap( top.begin(), top.end(), TopCompare );
+        }
+        else if( top.front().preempted < stats.preempted )
+        {
+            std::pop_heap( top.begin(), top.end(), TopCompare );
+            top.back() = ZoneResult { &zone, thread, stats.preempted, stats.offCpu };
+            std::push_heap( top.begin(), top.end(), TopCompare );
+        }
+    }
+
+    if( zone.HasChildren() ) ProcessZones( state, thread, m_worker->GetZoneChildren( zone.Child() ) );
+}
+
+void SchedulerAnalysis::Merge()
+{
+    unordered_flat_map<int16_t, SrcLocResult> srcloc;
+    for( auto& state : m_state )
+    {
+        for( auto& v : state.srcloc )
+        {
+            auto it = srcloc.find( v.first );
+            if( it == srcloc.end() )
+            {
+                srcloc.emplace( v.first, v.second );
+            }
+            else
+            {
+                it->second.zones += v.second.zones;
+                it->second.time += v.second.time;
+                AddStats( it->second.stats, v.second.stats );
+            }
+        }
+        m_topZones.insert( m_topZones.end(), state.top.begin(), state.top.end() );
+    }
+
+    m_srcloc.reserve( srcloc.size() );
+    for( auto& v : srcloc ) m_srcloc.emplace_back( v.second );
+
+    std::sort( m_topZones.begin(), m_topZones.end(), TopCompare );
+    if( m_topZones.size() > TopZones ) m_topZones.resize( TopZones );
+}
+
+}
@@ -0,0 +1,110 @@
+#ifndef __TRACYSCHEDULERANALYSIS_HPP__
+#define __TRACYSCHEDULERANALYSIS_HPP__
+
+#include <stdint.h>
+#include <vector>
+
+#include "TracyAnalysisEngine.hpp"
+#include "TracyCompare.hpp"
+#include "TracyEvent.hpp"
+
+namespace tracy
+{
+
+// Scheduler behavior of the profiled threads, derived from the context switch data.
+// Each off-CPU period of a thread is split at the wakeup time. The part before the
+// wakeup is blocked time, the part after it is run queue time (wakeup to run latency).
+// A thread that was switched out while still runnable was preempted, and its whole
+// off-CPU period is run queue time.
+class SchedulerAnalysis : public AnalysisEngine
+{
+public:
+    enum { TopZones = 100 };
+
+    struct Stats
+    {
+        uint64_t periods = 0;       // off-CPU periods
+        uint64_t preemptions = 0;
+        uint64_t migrations = 0;
+        int64_t offCpu = 0;
+        int64_t blocked = 0;
+        int64_t runQueue = 0;
+        int64_t preempted = 0;
+        int64_t maxRunQueue = 0;
+    };
+
+    struct ThreadResult
+    {
+        uint64_t thread;
+        int64_t running;
+        Stats stats;
+        LogSketch wakeupLatency;    // run queue time after a wakeup
+        LogSketch runQueue;         // run queue time of all off-CPU periods
+        LogSketch offCpu;
+    };
+
+    // Off-CPU time is counted for every zone it overlaps with, so parent zones include
+    // the time of their children.
+    struct SrcLocResult
+    {
+        int16_t srcloc;
+        uint64_t zones;
+        int64_t time;
+        Stats stats;
+    };
+
+    struct ZoneResult
+    {
+        const ZoneEvent* zone;
+        uint64_t thread;
+        int64_t preempted;
+        int64_t offCpu;
+    };
+
+    explicit SchedulerAnalysis( Worker& worker );
+
+    // Was the thread switched out while it was still runnable?
+    static bool IsPreempted( const ContextSwitchData& cs );
+
+    // One unit of progress per thread with context switch data.
+    void Process( TaskDispatch& td );
+
+    const std::vector<ThreadResult>& GetThreads() const { return m_threads; }
+    const std::vector<SrcLocResult>& GetSourceLocations() const { return m_srcloc; }
+    // Zones that lost the most time to preemption, in descending order.
+    const std::vector<ZoneResult>& GetTopPreemptedZones() const { return m_topZones; }
+
+private:
+    struct Gap
+    {
+        int64_t start;
+        int64_t wakeup;
+        int64_t end;
+        bool preempted;
+        bool migration;
+    };
+
+    struct ThreadState
+    {
+        const ContextSwitch* cs;
+        const ThreadData* td;
+        std::vector<Gap> gaps;
+        unordered_flat_map<int16_t, SrcLocResult> srcloc;
+        std::vector<ZoneResult> top;
+    };
+
+    void ProcessThread( ThreadResult& res, ThreadState& state );
+    void CollectGaps( ThreadResult& res, ThreadState& state );
+    void ProcessZones( ThreadState& state, uint64_t thread, const Vector<short_ptr<ZoneEvent>>& zones );
+    void ProcessZone( ThreadState& state, uint64_t thread, const ZoneEvent& zone );
+    void Merge();
+
+    std::vector<ThreadResult> m_threads;
+    std::vector<ThreadState> m_state;
+    std::vector<SrcLocResult> m_srcloc;
+    std::vector<ZoneResult> m_topZones;
+};
+
+}
+
+#endif
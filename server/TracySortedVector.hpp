@@ -49,6 +49,7 @@ public:
     tracy_force_inline bool empty() const { return v.empty(); }
     tracy_force_inline size_t size() const { return v.size(); }
     tracy_force_inline bool is_sorted() const { return sortedEnd == 0; }
+    tracy_force_inline size_t sorted_end() const { return sortedEnd == 0 ? v.size() : sortedEnd; }
 
     tracy_force_inline T* data() { return v.data(); }
     tracy_force_inline const T* data() const { return v.data(); };
@@ -103,9 +104,9 @@ public:
         const auto sl = se - 1;
         const auto ue = v.end();
 #ifdef __EMSCRIPTEN__
-        pdqsort_branchless( sb, se, comp );
+        pdqsort_branchless( se, ue, comp );
 #else
-        ppqsort::sort( ppqsort::execution::par, sb, se, comp );
+        ppqsort::sort( ppqsort::execution::par, se, ue, comp );
 #endif
         const auto ss = std::lower_bound( sb, se, *se, comp );
         const auto uu = std::lower_bound( se, ue, *sl, comp );
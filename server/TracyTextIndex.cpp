@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <assert.h>
+#include <iterator>
+#include <string.h>
+
+#include "TracyTextIndex.hpp"
+
+namespace tracy
+{
+
+static tracy_force_inline uint8_t Lower( uint8_t c )
+{
+    return ( c >= 'A' && c <= 'Z' ) ? c - 'A' + 'a' : c;
+}
+
+tracy_force_inline uint32_t TextIndex::Key( uint8_t c0, uint8_t c1, uint8_t c2 )
+{
+    return ( uint32_t( Lower( c0 ) ) << 16 ) | ( uint32_t( Lower( c1 ) ) << 8 ) | uint32_t( Lower( c2 ) );
+}
+
+void TextIndex::Add( uint32_t id, const char* text )
+{
+    Add( id, text, strlen( text ) );
+}
+
+void TextIndex::Add( uint32_t id, const char* text, size_t len )
+{
+    if( len < MinQueryLength ) return;
+    auto ptr = (const uint8_t*)text;
+    for( size_t i=0; i<=len-MinQueryLength; i++ )
+    {
+        auto& posting = m_postings[Key( ptr[i], ptr[i+1], ptr[i+2] )];
+        if( posting.count != 0 )
+        {
+            assert( id >= posting.last );
+            if( posting.last == id ) continue;
+        }
+        // Ids are stored as deltas to the previous one, in 7-bit varint encoding.
+        auto delta = id - posting.last;
+        while( delta >= 0x80 )
+        {
+            posting.data.push_back( uint8_t( delta | 0x80 ) );
+            delta >>= 7;
+        }
+        posting.data.push_back( uint8_t( delta ) );
+        posting.last = id;
+        posting.count++;
+    }
+}
+
+void TextIndex::Decode( const Posting& posting, std::vector<uint32_t>& out )
+{
+    out.clear();
+    out.reserve( posting.count );
+    uint32_t id = 0;
+    auto ptr = posting.data.data();
+    for( uint32_t i=0; i<posting.count; i++ )
+    {
+        uint32_t delta = 0;
+        int shift = 0;
+        uint8_t v;
+        do
+        {
+            v = *ptr++;
+            delta |= uint32_t( v & 0x7F ) << shift;
+            shift += 7;
+        }
+        while( v & 0x80 );
+        id += delta;
+        out.push_back( id );
+    }
+}
+
+bool TextIndex::Query( const char* text, size_t len, std::vector<uint32_t>& out ) const
+{
+    if( len < MinQueryLength ) return false;
+
+    std::vector<const Posting*> list;
+    auto ptr = (const uint8_t*)text;
+    for( size_t i=0; i<=len-MinQueryLength; i++ )
+    {
+        auto it = m_postings.find( Key( ptr[i], ptr[i+1], ptr[i+2] ) );
+        if( it == m_postings.end() )
+        {
+            out.clear();
+            return true;
+        }
+        list.push_back( &it->second );
+    }
+    std::sort( list.begin(), list.end(), [] ( const auto& l, const auto& r ) { return l->count < r->count || ( l->count == r->count && l < r ); } );
+    list.erase( std::unique( list.begin(), list.end() ), list.end() );
+
+    // Start with the rarest trigram, to keep the intersections small.
+    Decode( *list[0], out );
+    std::vector<uint32_t> tmp, res;
+    for( size_t i=1; i<list.size() && !out.empty(); i++ )
+    {
+        Decode( *list[i], tmp );
+        res.clear();
+        std::set_intersection( out.begin(), out.end(), tmp.begin(), tmp.end(), std::back_inserter( res ) );
+        std::swap( out, res );
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef __TRACYTEXTINDEX_HPP__
+#define __TRACYTEXTINDEX_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "TracyVector.hpp"
+#include "../public/common/TracyForceInline.hpp"
+#include "tracy_robin_hood.h"
+
+namespace tracy
+{
+
+// Inverted index of case-insensitive character trigrams. Documents are identified by ids,
+// which must be added in non-decreasing order. Queries return a superset of documents
+// containing the searched substring, which has to be verified by the caller.
+class TextIndex
+{
+public:
+    enum { MinQueryLength = 3 };
+
+    void Add( uint32_t id, const char* text );
+    void Add( uint32_t id, const char* text, size_t len );
+
+    // Returns false if the index cannot be used for the query. Otherwise the candidate
+    // document ids are stored in out, in ascending order.
+    bool Query( const char* text, size_t len, std::vector<uint32_t>& out ) const;
+
+private:
+    struct Posting
+    {
+        uint32_t last = 0;
+        uint32_t count = 0;
+        Vector<uint8_t> data;
+    };
+
+    static tracy_force_inline uint32_t Key( uint8_t c0, uint8_t c1, uint8_t c2 );
+    static void Decode( const Posting& posting, std::vector<uint32_t>& out );
+
+    unordered_flat_map<uint32_t, Posting> m_postings;
+};
+
+}
+
+#endif
@@ -10,8 +10,10 @@
 #  include <alloca.h>
 #endif
 
+#include <algorithm>
 #include <cctype>
 #include <chrono>
+#include <memory>
 #include <math.h>
 #include <string.h>
 
@@ -58,6 +60,11 @@ enum { FileHeaderMagic = 5 };
 static const int CurrentVersion = FileVersion( Version::Major, Version::Minor, Version::Patch );
 static const int MinSupportedVersion = FileVersion( 0, 9, 0 );
 
+constexpr uint32_t PlotLodBits = 6;
+constexpr uint32_t PlotLodBlock = 1 << PlotLodBits;
+
+constexpr size_t SampleBlockSize = 64 * 1024;
+
 
 static void UpdateLockCountLockable( LockMap& lockmap, size_t pos )
 {
@@ -286,6 +293,8 @@ Worker::Worker( const char* addr, uint16_t port, int64_t memoryLimit )
 
     memset( (char*)m_gpuCtxMap, 0, sizeof( m_gpuCtxMap ) );
 
+    m_data.textIndexReady = true;
+
 #ifndef TRACY_NO_STATISTICS
     m_data.sourceLocationZonesReady = true;
     m_data.gpuSourceLocationZonesReady = true;
@@ -300,6 +309,15 @@ Worker::Worker( const char* addr, uint16_t port, int64_t memoryLimit )
 }
 
 Worker::Worker( const char* name, const char* program, const std::vector<ImportEventTimeline>& timeline, const std::vector<ImportEventMessages>& messages, const std::vector<ImportEventPlots>& plots, const std::unordered_map<uint64_t, std::string>& threadNames )
+    : Worker( name, program )
+{
+    ImportTimeline( timeline.data(), timeline.size() );
+    ImportMessages( messages.data(), messages.size() );
+    for( auto& v : plots ) ImportPlot( v );
+    FinishImport( threadNames );
+}
+
+Worker::Worker( const char* name, const char* program )
     : m_hasData( true )
     , m_resolution( 0 )
     , m_captureName( name )
@@ -322,26 +340,18 @@ Worker::Worker( const char* name, const char* program, const std::vector<ImportE
     m_data.symbolLocInline.push_back( std::numeric_limits<uint64_t>::max() );
     m_data.memory = m_slab.AllocInit<MemData>();
     m_data.memNameMap.emplace( 0, m_data.memory );
-
+    m_data.textIndexReady = true;
     m_data.lastTime = 0;
-    if( !timeline.empty() )
-    {
-        m_data.lastTime = timeline.back().timestamp;
-    }
-    if( !messages.empty() )
-    {
-        if( m_data.lastTime < (int64_t)messages.back().timestamp ) m_data.lastTime = messages.back().timestamp;
-    }
-    if( !plots.empty() )
-    {
-        for( auto& v : plots )
-        {
-            if( m_data.lastTime < v.data.back().first ) m_data.lastTime = v.data.back().first;
-        }
-    }
+}
 
-    for( auto& v : timeline )
+void Worker::ImportTimeline( const ImportEventTimeline* events, size_t count )
+{
+    if( count == 0 ) return;
+    if( m_data.lastTime < (int64_t)events[count-1].timestamp ) m_data.lastTime = events[count-1].timestamp;
+
+    for( size_t i=0; i<count; i++ )
     {
+        auto& v = events[i];
         if( !v.isEnd )
         {
             SourceLocation srcloc {{
@@ -386,6 +396,7 @@ Worker::Worker( const char* name, const char* program, const std::vector<ImportE
             {
                 auto& extra = RequestZoneExtra( *zone );
                 extra.text = StringIdx( StoreString( v.text.c_str(), v.text.size() ).idx );
+                IndexZoneText( zone );
             }
 
             if( m_threadCtx != v.tid )
@@ -416,18 +427,23 @@ Worker::Worker( const char* name, const char* program, const std::vector<ImportE
 #endif
         }
     }
+}
 
-    std::unordered_map<std::string, uint64_t> frameNames;
+void Worker::ImportMessages( const ImportEventMessages* events, size_t count )
+{
+    if( count == 0 ) return;
+    if( m_data.lastTime < (int64_t)events[count-1].timestamp ) m_data.lastTime = events[count-1].timestamp;
 
-    for( auto& v : messages )
+    for( size_t i=0; i<count; i++ )
     {
+        auto& v = events[i];
         // There is no specific chrome-tracing type for frame events. We use messages that contain the word "frame"
         std::string lower( v.message );
         std::transform( lower.begin(), lower.end(), lower.begin(), []( char c ) { return char( std::tolower( c ) ); } );
         if( lower.find( "frame" ) != std::string::npos )
         {
             // Reserve 0 as the default FrameSet, since it replaces the name with "Frame" and we want to keep our custom names.
-            auto result = frameNames.emplace( v.message, frameNames.size() + 1 );
+            auto result = m_importFrameNames.emplace( v.message, m_importFrameNames.size() + 1 );
             auto fd = m_data.frames.Retrieve( result.first->second, [&] ( uint64_t name ) {
                 auto fd = m_slab.AllocInit<FrameData>();
                 fd->name = name;
@@ -458,46 +474,48 @@ Worker::Worker( const char* name, const char* program, const std::vector<ImportE
             InsertMessageData( msg );
         }
     }
+}
 
-    for( auto& v : plots )
-    {
-        uint64_t nptr = (uint64_t)&v.name;
-        auto it = m_data.strings.find( nptr );
-        if( it == m_data.strings.end() )
-        {
-            const auto sl = StoreString( v.name.c_str(), v.name.size() );
-            m_data.strings.emplace( nptr, sl.ptr );
-        }
+void Worker::ImportPlot( const ImportEventPlots& v )
+{
+    if( v.data.empty() ) return;
+    if( m_data.lastTime < v.data.back().first ) m_data.lastTime = v.data.back().first;
 
-        auto plot = m_slab.AllocInit<PlotData>();
-        plot->name = nptr;
-        plot->type = PlotType::User;
-        plot->format = v.format;
-        plot->showSteps = false;
-        plot->fill = true;
-        plot->color = 0;
+    const auto sl = StoreString( v.name.c_str(), v.name.size() );
+    uint64_t nptr = (uint64_t)sl.ptr;
+    if( m_data.strings.find( nptr ) == m_data.strings.end() ) m_data.strings.emplace( nptr, sl.ptr );
 
-        double sum = 0;
-        double min = v.data.begin()->second;
-        double max = v.data.begin()->second;
-        plot->data.reserve_exact( v.data.size(), m_slab );
-        size_t idx = 0;
-        for( auto& p : v.data )
-        {
-            plot->data[idx].time.SetVal( p.first );
-            plot->data[idx].val = p.second;
-            idx++;
-            if( min > p.second ) min = p.second;
-            else if( max < p.second ) max = p.second;
-            sum += p.second;
-        }
-        plot->min = min;
-        plot->max = max;
-        plot->sum = sum;
+    auto plot = m_slab.AllocInit<PlotData>();
+    plot->name = nptr;
+    plot->type = PlotType::User;
+    plot->format = v.format;
+    plot->showSteps = false;
+    plot->fill = true;
+    plot->color = 0;
 
-        m_data.plots.Data().push_back( plot );
+    double sum = 0;
+    double min = v.data.begin()->second;
+    double max = v.data.begin()->second;
+    plot->data.reserve_exact( v.data.size(), m_slab );
+    size_t idx = 0;
+    for( auto& p : v.data )
+    {
+        plot->data[idx].time.SetVal( p.first );
+        plot->data[idx].val = p.second;
+        idx++;
+        if( min > p.second ) min = p.second;
+        else if( max < p.second ) max = p.second;
+        sum += p.second;
     }
+    plot->min = min;
+    plot->max = max;
+    plot->sum = sum;
 
+    m_data.plots.Data().push_back( plot );
+}
+
+void Worker::FinishImport( const std::unordered_map<uint64_t, std::string>& threadNames )
+{
     for( auto& t : m_threadMap )
     {
         auto name = threadNames.find(t.first);
@@ -532,7 +550,7 @@ Worker::Worker( const char* name, const char* program, const std::vector<ImportE
     }
 
     // Add a default frame if we didn't have any framesets
-    if( frameNames.empty() )
+    if( m_importFrameNames.empty() )
     {
         m_data.framesBase = m_data.frames.Retrieve( 0, [this] ( uint64_t name ) {
             auto fd = m_slab.AllocInit<FrameData>();
@@ -1018,6 +1036,9 @@ Worker::Worker( FileRead& f, EventType::Type eventMask, bool bgTasks, bool allow
             td->groupHint = 0;
         }
         td->id = tid;
+#ifndef TRACY_NO_STATISTICS
+        td->offCpuIdx = 0;
+#endif
         m_data.zonesCnt += td->count;
         uint32_t tsz;
         f.Read( tsz );
@@ -1221,6 +1242,7 @@ Worker::Worker( FileRead& f, EventType::Type eventMask, bool bgTasks, bool allow
             if( sz != 0 )
             {
                 memdata.reconstruct = true;
+                UpdateMemoryCheckpoints( memdata );
             }
         }
         else
@@ -1681,37 +1703,20 @@ Worker::Worker( FileRead& f, EventType::Type eventMask, bool bgTasks, bool allow
                 if( mem.second->reconstruct ) jobs.emplace_back( std::thread( [this, mem = mem.second] { ReconstructMemAllocPlot( *mem ); } ) );
             }
 
-            std::function<void(uint8_t*, Vector<short_ptr<ZoneEvent>>&, uint16_t)> ProcessTimeline;
-            ProcessTimeline = [this, &ProcessTimeline] ( uint8_t* countMap, Vector<short_ptr<ZoneEvent>>& _vec, uint16_t thread )
-            {
-                if( m_shutdown.load( std::memory_order_relaxed ) ) return;
-                assert( _vec.is_magic() );
-                auto& vec = *(Vector<ZoneEvent>*)( &_vec );
-                for( auto& zone : vec )
+            jobs.emplace_back( std::thread( [this] { ReconstructSourceLocationZones(); } ) );
+
+            jobs.emplace_back( std::thread( [this] {
+                for( auto& msg : m_data.messages )
                 {
-                    if( zone.IsEndValid() ) ReconstructZoneStatistics( countMap, zone, thread );
-                    if( zone.HasChildren() )
-                    {
-                        countMap[uint16_t(zone.SrcLoc())]++;
-                        ProcessTimeline( countMap, GetZoneChildrenMutable( zone.Child() ), thread );
-                        countMap[uint16_t(zone.SrcLoc())]--;
-                    }
+                    IndexMessage( msg );
                 }
-            };
-
-            jobs.emplace_back( std::thread( [this, ProcessTimeline] {
                 for( auto& t : m_data.threads )
                 {
                     if( m_shutdown.load( std::memory_order_relaxed ) ) return;
-                    if( !t->timeline.empty() )
-                    {
-                        uint8_t countMap[64*1024];
-                        // Don't touch thread compression cache in a thread.
-                        ProcessTimeline( countMap, t->timeline, m_data.localThreadCompress.DecompressMustRaw( t->id ) );
-                    }
+                    BuildTextIndex( t->timeline );
                 }
                 std::lock_guard<std::mutex> lock( m_data.lock );
-                m_data.sourceLocationZonesReady = true;
+                m_data.textIndexReady = true;
             } ) );
 
             std::function<void(Vector<short_ptr<GpuEvent>>&, uint16_t)> ProcessTimelineGpu;
@@ -1739,6 +1744,7 @@ Worker::Worker( FileRead& f, EventType::Type eventMask, bool bgTasks, bool allow
                         if( !td.second.timeline.empty() )
                         {
                             ProcessTimelineGpu( td.second.timeline, td.first );
+                            UpdateGpuFlameGraph( *t, td.second, true );
                         }
                     }
                 }
@@ -1808,6 +1814,11 @@ Worker::Worker( FileRead& f, EventType::Type eventMask, bool bgTasks, bool allow
                             }
                         }
                         for( auto& v : counts ) UpdateSampleStatistics( v.first, v.second, false );
+                        for( auto& t : m_data.threads )
+                        {
+                            if( m_shutdown.load( std::memory_order_relaxed ) ) return;
+                            UpdateOffCpuStacks( *t );
+                        }
                     }
                     std::lock_guard<std::mutex> lock( m_data.lock );
                     m_data.callstackSamplesReady = true;
@@ -1894,6 +1905,16 @@ Worker::Worker( FileRead& f, EventType::Type eventMask, bool bgTasks, bool allow
                     std::lock_guard<std::mutex> lock( m_data.lock );
                     m_data.symbolSamplesReady = true;
                 } ) );
+
+                jobs.emplace_back( std::thread( [this] {
+                    for( auto& t : m_data.threads )
+                    {
+                        if( m_shutdown.load( std::memory_order_relaxed ) ) return;
+                        BuildSampleBlocks( *t );
+                    }
+                    std::lock_guard<std::mutex> lock( m_data.lock );
+                    m_data.sampleBlocksReady = true;
+                } ) );
             }
 
             for( auto& job : jobs ) job.join();
@@ -1929,6 +1950,9 @@ Worker::~Worker()
 #ifndef TRACY_NO_STATISTICS
         v->childTimeStack.~Vector();
         v->ghostZones.~Vector();
+        for( auto& block : v->sampleBlocks ) block.~Vector();
+        v->sampleBlocks.~Vector();
+        std::destroy_at( &v->offCpuStacks );
 #endif
     }
     for( auto& v : m_data.gpuData )
@@ -1938,6 +1962,9 @@ Worker::~Worker()
             vt.second.timeline.~Vector();
             vt.second.stack.~Vector();
         }
+#ifndef TRACY_NO_STATISTICS
+        v->flameGraph.~vector();
+#endif
     }
     for( auto& v : m_data.plots.Data() )
     {
@@ -2244,6 +2271,81 @@ const Vector<ChildSample>* Worker::GetChildSamples( uint64_t addr ) const
     if( it == m_data.childSamples.end() ) return nullptr;
     return &it->second;
 }
+
+void Worker::GetSymbolCountsForRange( int64_t min, int64_t max, unordered_flat_map<uint64_t, SymbolCount>& out, TaskDispatch& td ) const
+{
+    assert( m_data.sampleBlocksReady );
+    out.clear();
+
+    // Blocks fully inside the range contribute their precomputed tables. Samples at the range
+    // edges are counted individually. The work is split into jobs, each with its own output map.
+    constexpr size_t BlocksPerJob = 16;
+    std::vector<std::function<void(unordered_flat_map<uint64_t, SymbolCount>&)>> jobs;
+    for( auto& t : m_data.threads )
+    {
+        const auto& samples = t->samples;
+        if( samples.empty() ) continue;
+        auto sb = std::lower_bound( samples.begin(), samples.end(), min, [] ( const auto& l, const auto& r ) { return l.time.Val() < r; } );
+        auto se = std::lower_bound( sb, samples.end(), max, [] ( const auto& l, const auto& r ) { return l.time.Val() < r; } );
+        const size_t begin = sb - samples.begin();
+        const size_t end = se - samples.begin();
+        if( begin == end ) continue;
+
+        const auto bb = ( begin + SampleBlockSize - 1 ) / SampleBlockSize;
+        const auto be = end / SampleBlockSize;
+        const ThreadData* thread = t;
+        if( bb >= be )
+        {
+            jobs.emplace_back( [this, thread, begin, end] ( auto& res ) { CountRangeSamples( *thread, begin, end, res ); } );
+            continue;
+        }
+        jobs.emplace_back( [this, thread, begin, end, bb, be] ( auto& res ) {
+            CountRangeSamples( *thread, begin, bb * SampleBlockSize, res );
+            CountRangeSamples( *thread, be * SampleBlockSize, end, res );
+        } );
+        for( size_t b=bb; b<be; b+=BlocksPerJob )
+        {
+            const auto bl = std::min( be, b + BlocksPerJob );
+            jobs.emplace_back( [thread, b, bl] ( auto& res ) {
+                for( size_t i=b; i<bl; i++ )
+                {
+                    for( auto& v : thread->sampleBlocks[i] )
+                    {
+                        auto& cnt = res[v.symAddr];
+                        cnt.incl += v.count.incl;
+                        cnt.excl += v.count.excl;
+                    }
+                }
+            } );
+        }
+    }
+    if( jobs.empty() ) return;
+
+    std::vector<unordered_flat_map<uint64_t, SymbolCount>> results( jobs.size() - 1 );
+    for( size_t i=1; i<jobs.size(); i++ )
+    {
+        td.Queue( [&jobs, &results, i] { jobs[i]( results[i-1] ); } );
+    }
+    jobs[0]( out );
+    td.Sync();
+
+    for( auto& res : results )
+    {
+        for( auto& v : res )
+        {
+            auto it = out.find( v.first );
+            if( it == out.end() )
+            {
+                out.emplace( v.first, v.second );
+            }
+            else
+            {
+                it->second.incl += v.second.incl;
+                it->second.excl += v.second.excl;
+            }
+        }
+    }
+}
 #endif
 
 const SymbolData* Worker::GetSymbolData( uint64_t sym ) const
@@ -3403,6 +3505,85 @@ void Worker::InsertMessageData( MessageData* msg )
         auto tmit = std::lower_bound( vec->begin(), vec->end(), msg->time, [] ( const auto& lhs, const auto& rhs ) { return lhs->time < rhs; } );
         vec->insert( tmit, msg );
     }
+
+    if( m_data.textIndexReady ) IndexMessage( msg );
+}
+
+void Worker::IndexMessage( const MessageData* msg )
+{
+    // Literal messages may arrive before their string is retrieved from the client. These are
+    // kept aside and reported as candidates, until AddString() indexes them.
+    if( !msg->ref.isidx && m_pendingStrings != 0 )
+    {
+        auto it = m_data.strings.find( msg->ref.str );
+        if( it == m_data.strings.end() || strcmp( it->second, "???" ) == 0 )
+        {
+            m_data.messageIndexPending.push_back( msg );
+            return;
+        }
+    }
+    AddMessageToIndex( msg );
+}
+
+void Worker::AddMessageToIndex( const MessageData* msg )
+{
+    const auto id = uint32_t( m_data.messageIndexDocs.size() );
+    m_data.messageIndexDocs.push_back( msg );
+    m_data.messageIndex.Add( id, GetString( msg->ref ) );
+}
+
+void Worker::IndexZoneText( const ZoneEvent* zone )
+{
+    // Zones with appended text are added again, duplicates are removed when querying.
+    const auto id = uint32_t( m_data.zoneTextDocs.size() );
+    m_data.zoneTextDocs.push_back( zone );
+    m_data.zoneTextIndex.Add( id, GetString( GetZoneExtra( *zone ).text ) );
+}
+
+void Worker::BuildTextIndex( const Vector<short_ptr<ZoneEvent>>& vec )
+{
+    if( vec.is_magic() )
+    {
+        auto& v = *(Vector<ZoneEvent>*)( &vec );
+        for( auto& zone : v )
+        {
+            if( HasZoneExtra( zone ) && GetZoneExtra( zone ).text.Active() ) IndexZoneText( &zone );
+            if( zone.HasChildren() ) BuildTextIndex( GetZoneChildren( zone.Child() ) );
+        }
+    }
+    else
+    {
+        for( auto& zone : vec )
+        {
+            if( HasZoneExtra( *zone ) && GetZoneExtra( *zone ).text.Active() ) IndexZoneText( zone );
+            if( zone->HasChildren() ) BuildTextIndex( GetZoneChildren( zone->Child() ) );
+        }
+    }
+}
+
+bool Worker::GetMessageCandidates( const char* text, size_t len, std::vector<const MessageData*>& out ) const
+{
+    if( !m_data.textIndexReady ) return false;
+    std::vector<uint32_t> ids;
+    if( !m_data.messageIndex.Query( text, len, ids ) ) return false;
+    out.clear();
+    out.reserve( ids.size() + m_data.messageIndexPending.size() );
+    for( auto& id : ids ) out.emplace_back( m_data.messageIndexDocs[id] );
+    for( auto& msg : m_data.messageIndexPending ) out.emplace_back( msg );
+    return true;
+}
+
+bool Worker::GetZoneTextCandidates( const char* text, size_t len, std::vector<const ZoneEvent*>& out ) const
+{
+    if( !m_data.textIndexReady ) return false;
+    std::vector<uint32_t> ids;
+    if( !m_data.zoneTextIndex.Query( text, len, ids ) ) return false;
+    out.clear();
+    out.reserve( ids.size() );
+    for( auto& id : ids ) out.emplace_back( m_data.zoneTextDocs[id] );
+    std::sort( out.begin(), out.end() );
+    out.erase( std::unique( out.begin(), out.end() ), out.end() );
+    return true;
 }
 
 ThreadData* Worker::NoticeThreadReal( uint64_t thread )
@@ -3502,6 +3683,79 @@ const MemData& Worker::GetMemoryNamed( uint64_t name ) const
     return *it->second;
 }
 
+static void FilterMemoryLive( const MemData& mem, int64_t time, const uint32_t* begin, const uint32_t* end, std::vector<uint32_t>& out )
+{
+    while( begin != end )
+    {
+        const auto tf = mem.data[*begin].TimeFree();
+        if( tf < 0 || tf > time ) out.emplace_back( *begin );
+        begin++;
+    }
+}
+
+static void FilterMemoryLive( const MemData& mem, int64_t time, uint32_t begin, uint32_t end, std::vector<uint32_t>& out )
+{
+    while( begin != end )
+    {
+        const auto tf = mem.data[begin].TimeFree();
+        if( tf < 0 || tf > time ) out.emplace_back( begin );
+        begin++;
+    }
+}
+
+// Allocations are ordered by allocation time, so the live set at any time is the live set of the
+// nearest preceding checkpoint, extended with the allocations made since, minus anything freed in
+// the meantime. Checkpoints are spaced at least as far apart as the size of the previous live set,
+// which keeps both the total snapshot size and the replay length bounded. During a live capture
+// a checkpoint may still hold allocations whose free arrives later, queries filter them out.
+void Worker::UpdateMemoryCheckpoints( MemData& mem )
+{
+    constexpr uint32_t MinSpacing = 64 * 1024;
+
+    const auto& data = mem.data;
+    const auto end = uint32_t( data.size() );
+    auto& cp = mem.checkpoints;
+    for(;;)
+    {
+        const auto prev = cp.empty() ? nullptr : &cp.back();
+        const auto from = prev ? prev->next : 0;
+        const auto spacing = std::max<uint32_t>( MinSpacing, prev ? uint32_t( prev->live.size() ) : 0 );
+        if( end <= from || end - from <= spacing ) break;
+        const auto cpTime = data[from + spacing - 1].TimeAlloc();
+        const auto next = uint32_t( std::upper_bound( data.begin() + from + spacing, data.end(), cpTime, [] ( const auto& lhs, const auto& rhs ) { return lhs < rhs.TimeAlloc(); } ) - data.begin() );
+        // Allocations with the same timestamp must not be split across checkpoints.
+        if( next == end ) break;
+
+        MemCheckpoint checkpoint { cpTime, next };
+        if( prev ) FilterMemoryLive( mem, cpTime, prev->live.data(), prev->live.data() + prev->live.size(), checkpoint.live );
+        FilterMemoryLive( mem, cpTime, from, next, checkpoint.live );
+        cp.emplace_back( std::move( checkpoint ) );
+    }
+}
+
+// Allocations live at any moment of [t0, t1] are the ones live at t0, plus the ones made up to t1.
+// The output is in allocation order.
+void Worker::GetMemoryLive( const MemData& mem, int64_t t0, int64_t t1, std::vector<uint32_t>& out ) const
+{
+    assert( t0 <= t1 );
+    out.clear();
+    const auto& data = mem.data;
+    const auto end = uint32_t( std::upper_bound( data.begin(), data.end(), t1, [] ( const auto& lhs, const auto& rhs ) { return lhs < rhs.TimeAlloc(); } ) - data.begin() );
+
+    const auto& cp = mem.checkpoints;
+    auto it = std::upper_bound( cp.begin(), cp.end(), t0, [] ( const auto& lhs, const auto& rhs ) { return lhs < rhs.time; } );
+    if( it == cp.begin() )
+    {
+        FilterMemoryLive( mem, t0, 0, end, out );
+    }
+    else
+    {
+        --it;
+        FilterMemoryLive( mem, t0, it->live.data(), it->live.data() + it->live.size(), out );
+        FilterMemoryLive( mem, t0, it->next, end, out );
+    }
+}
+
 ThreadData* Worker::NewThread( uint64_t thread, bool fiber, int32_t groupHint )
 {
     auto td = m_slab.AllocInit<ThreadData>();
@@ -3510,6 +3764,7 @@ ThreadData* Worker::NewThread( uint64_t thread, bool fiber, int32_t groupHint )
     td->nextZoneId = 0;
 #ifndef TRACY_NO_STATISTICS
     td->ghostIdx = 0;
+    td->offCpuIdx = 0;
 #endif
     td->kernelSampleCnt = 0;
     td->pendingSample.time.Clear();
@@ -3753,6 +4008,21 @@ void Worker::AddString( uint64_t ptr, const char* str, size_t sz )
     const auto sl = StoreString( str, sz );
     it->second = sl.ptr;
 
+    auto& pending = m_data.messageIndexPending;
+    for( size_t i=0; i<pending.size(); )
+    {
+        if( pending[i]->ref.str == ptr )
+        {
+            AddMessageToIndex( pending[i] );
+            pending[i] = pending.back();
+            pending.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+
     StringRef ref( StringRef::Ptr, ptr );
     auto sit = m_pendingFileStrings.find( ref );
     if( sit != m_pendingFileStrings.end() )
@@ -4153,6 +4423,99 @@ void Worker::InsertPlot( PlotData* plot, int64_t time, double val )
     }
 }
 
+void Worker::SortPlot( PlotData& plot )
+{
+    assert( !plot.data.is_sorted() );
+
+    // Sorting doesn't move the points that precede all of the out of order ones.
+    auto& vec = plot.data;
+    const auto se = vec.begin() + vec.sorted_end();
+    auto tmin = se->time.Val();
+    for( auto it = se + 1; it != vec.end(); ++it ) tmin = std::min( tmin, it->time.Val() );
+    const auto valid = uint32_t( std::lower_bound( vec.begin(), se, tmin, [] ( const auto& l, const auto& r ) { return l.time.Val() < r; } ) - vec.begin() );
+    for( size_t i=0; i<plot.lod.size(); i++ )
+    {
+        auto& level = plot.lod[i];
+        level.resize( std::min<size_t>( level.size(), valid >> ( PlotLodBits + i ) ) );
+    }
+
+    vec.sort();
+}
+
+void Worker::UpdatePlotLod( PlotData& plot )
+{
+    auto& vec = plot.data;
+    if( !vec.is_sorted() ) SortPlot( plot );
+
+    const auto blocks = vec.size() >> PlotLodBits;
+    if( blocks == 0 ) return;
+    if( plot.lod.empty() ) plot.lod.emplace_back();
+
+    auto& l0 = plot.lod[0];
+    for( auto b=l0.size(); b<blocks; b++ )
+    {
+        const auto i0 = uint32_t( b << PlotLodBits );
+        PlotLodItem item { i0, i0 };
+        for( auto i=i0+1; i<i0+PlotLodBlock; i++ )
+        {
+            if( vec[i].val < vec[item.min].val ) item.min = i;
+            else if( vec[i].val > vec[item.max].val ) item.max = i;
+        }
+        l0.emplace_back( item );
+    }
+
+    for( size_t i=1; plot.lod[i-1].size() >= 2; i++ )
+    {
+        if( plot.lod.size() == i ) plot.lod.emplace_back();
+        auto& prev = plot.lod[i-1];
+        auto& level = plot.lod[i];
+        for( auto b=level.size(); b<prev.size()/2; b++ )
+        {
+            const auto& v0 = prev[b*2];
+            const auto& v1 = prev[b*2+1];
+            level.emplace_back( PlotLodItem {
+                vec[v1.min].val < vec[v0.min].val ? v1.min : v0.min,
+                vec[v1.max].val > vec[v0.max].val ? v1.max : v0.max
+            } );
+        }
+    }
+}
+
+std::pair<uint32_t, uint32_t> Worker::GetPlotMinMax( const PlotData& plot, uint32_t begin, uint32_t end ) const
+{
+    assert( begin < end );
+    auto& vec = plot.data;
+    uint32_t imin = begin;
+    uint32_t imax = begin;
+    auto i = begin + 1;
+    while( i < end )
+    {
+        // Use the largest aligned block that fits in the remaining range.
+        size_t lvl = 0;
+        while( lvl < plot.lod.size() )
+        {
+            const auto bsz = PlotLodBlock << lvl;
+            if( ( i & ( bsz - 1 ) ) != 0 || i + bsz > end || ( i >> ( PlotLodBits + lvl ) ) >= plot.lod[lvl].size() ) break;
+            lvl++;
+        }
+        if( lvl == 0 )
+        {
+            if( vec[i].val < vec[imin].val ) imin = i;
+            else if( vec[i].val > vec[imax].val ) imax = i;
+            i++;
+        }
+        else
+        {
+            lvl--;
+            const auto& item = plot.lod[lvl][i >> ( PlotLodBits + lvl )];
+            if( vec[item.min].val < vec[imin].val ) imin = item.min;
+            if( vec[item.max].val > vec[imax].val ) imax = item.max;
+            i += PlotLodBlock << lvl;
+        }
+    }
+    return std::make_pair( imin, imax );
+}
+
 void Worker::HandlePlotName( uint64_t name, const char* str, size_t sz )
 {
     const auto sl = StoreString( str, sz );
@@ -4212,7 +4575,7 @@ void Worker::DoPostponedWorkAll()
 
     for( auto& plot : m_data.plots.Data() )
     {
-        if( !plot->data.is_sorted() ) plot->data.sort();
+        if( !plot->data.is_sorted() ) SortPlot( *plot );
     }
 }
 
@@ -4254,6 +4617,7 @@ void Worker::DoPostponedWork()
                             cit = std::lower_bound( cit, ctx->v.end(), sit->time.Val(), [] ( const auto& l, const auto& r ) { return (uint64_t)l.End() < (uint64_t)r; } );
                         }
                         while( cit != ctx->v.end() );
+                        UpdateOffCpuStacks( *td );
                         if( sit == td->postponedSamples.end() )
                         {
                             td->postponedSamples.clear();
@@ -5280,6 +5644,7 @@ void Worker::ProcessZoneText()
         memcpy( buf+len0+1, str1, len1 );
         extra.text = StringIdx( StoreString( buf, bsz ).idx );
     }
+    IndexZoneText( zone );
 }
 
 void Worker::ProcessZoneName()
@@ -5370,6 +5735,7 @@ void Worker::ProcessZoneValue( const QueueZoneValue& ev )
         memcpy( buf+len0+1, tmp, tsz );
         extra.text = StringIdx( StoreString( buf, bsz ).idx );
     }
+    IndexZoneText( zone );
 }
 
 void Worker::ProcessLockAnnounce( const QueueLockAnnounce& ev )
@@ -5942,16 +6308,12 @@ void Worker::ProcessGpuTime( const QueueGpuTime& ev )
         const auto timeSpan = gpuTime - gpuStart;
         if( timeSpan > 0 )
         {
-            GpuZoneThreadData ztd;
-            ztd.SetZone( zone );
-            ztd.SetThread( zone->Thread() );
             auto slz = GetGpuSourceLocationZones( zone->SrcLoc() );
-            slz->zones.push_back( ztd );
-            if( slz->min > timeSpan ) slz->min = timeSpan;
-            if( slz->max < timeSpan ) slz->max = timeSpan;
-            slz->total += timeSpan;
-            slz->sumSq += double( timeSpan ) * timeSpan;
+            AddGpuZoneStatistics( *slz, *zone, zone->Thread(), timeSpan );
         }
+        auto td = ctx->threadData.find( ctx->thread == 0 ? DecompressThread( zone->Thread() ) : 0 );
+        assert( td != ctx->threadData.end() );
+        UpdateGpuFlameGraph( *ctx, td->second );
 #else
         CountZoneStatistics( zone );
 #endif
@@ -6052,6 +6414,7 @@ MemEvent* Worker::ProcessMemAllocImpl( MemData& memdata, const QueueMemAlloc& ev
     memdata.high = std::max( high, ptrend );
     memdata.usage += size;
 
+    UpdateMemoryCheckpoints( memdata );
     MemAllocChanged( memdata, time );
     return &mem;
 }
@@ -6324,6 +6687,7 @@ void Worker::ProcessCallstackSampleImpl( const SampleData& sd, ThreadData& td )
             else if( sd.time.Val() == it->Start() )
             {
                 td.ctxSwitchSamples.push_back( sd );
+                UpdateOffCpuStacks( td );
             }
             else
             {
@@ -6507,6 +6871,9 @@ void Worker::ProcessCallstackSampleContextSwitch( const QueueCallstackSample& ev
     ProcessCallstackSampleInsertSample( sd, td );
 
     td.ctxSwitchSamples.push_back( sd );
+#ifndef TRACY_NO_STATISTICS
+    UpdateOffCpuStacks( td );
+#endif
 }
 
 void Worker::ProcessCallstackFrameSize( const QueueCallstackFrameSize& ev )
@@ -6873,6 +7240,11 @@ void Worker::ProcessContextSwitch( const QueueContextSwitch& ev )
         item->SetState( -1 );
         item->SetThread( 0 );
 
+#ifndef TRACY_NO_STATISTICS
+        auto tit = m_threadMap.find( ev.newThread );
+        if( tit != m_threadMap.end() ) UpdateOffCpuStacks( *tit->second );
+#endif
+
         auto& cx = cs.push_next();
         cx.SetStart( time );
         cx.SetEnd( -1 );
@@ -7418,6 +7790,74 @@ void Worker::UpdateSampleStatisticsPostponed( decltype(Worker::DataBlock::postpo
     it = m_data.postponedSamples.erase( it );
 }
 
+void Worker::BuildSampleBlocks( ThreadData& td )
+{
+    const auto blocks = td.samples.size() / SampleBlockSize;
+    if( blocks == 0 ) return;
+    td.sampleBlocks.reserve( blocks );
+    unordered_flat_map<uint64_t, SymbolCount> counts;
+    for( size_t i=0; i<blocks; i++ )
+    {
+        counts.clear();
+        CountRangeSamples( td, i * SampleBlockSize, ( i+1 ) * SampleBlockSize, counts );
+        auto& block = td.sampleBlocks.push_next_no_space_check();
+        block.reserve( counts.size() );
+        for( auto& v : counts ) block.push_back_no_space_check( SampleBlockCount { v.first, v.second } );
+    }
+}
+
+void Worker::CountRangeSamples( const ThreadData& td, size_t begin, size_t end, unordered_flat_map<uint64_t, SymbolCount>& out ) const
+{
+    if( begin >= end ) return;
+    unordered_flat_map<uint32_t, uint32_t> counts;
+    auto cit = td.ctxSwitchSamples.begin();
+    for( size_t i=begin; i<end; i++ )
+    {
+        const auto& sd = td.samples[i];
+        if( cit != td.ctxSwitchSamples.end() )
+        {
+            const auto sdt = sd.time.Val();
+            cit = std::lower_bound( cit, td.ctxSwitchSamples.end(), sdt, []( const auto& l, const auto& r ) { return (uint64_t)l.time.Val() < (uint64_t)r; } );
+            if( cit != td.ctxSwitchSamples.end() && cit->time.Val() == sdt ) continue;
+        }
+        const auto cs = sd.callstack.Val();
+        auto it = counts.find( cs );
+        if( it == counts.end() )
+        {
+            counts.emplace( cs, 1 );
+        }
+        else
+        {
+            it->second++;
+        }
+    }
+    for( auto& v : counts ) AccumulateSymbolCounts( v.first, v.second, out );
+}
+
+void Worker::AccumulateSymbolCounts( uint32_t callstack, uint32_t count, unordered_flat_map<uint64_t, SymbolCount>& out ) const
+{
+    const auto& cs = GetCallstack( callstack );
+    const auto cssz = cs.size();
+
+    auto frames = (const CallstackFrameData**)alloca( cssz * sizeof( CallstackFrameData* ) );
+    for( uint16_t i=0; i<cssz; i++ )
+    {
+        auto frame = GetCallstackFrame( cs[i] );
+        if( !frame ) return;
+        frames[i] = frame;
+    }
+
+    // Same attribution as UpdateSampleStatisticsImpl().
+    const auto fexcl = frames[0];
+    out[fexcl->data[0].symAddr].excl += count;
+    for( uint8_t f=1; f<fexcl->size; f++ ) out[fexcl->data[f].symAddr].incl += count;
+    for( uint16_t c=1; c<cssz; c++ )
+    {
+        const auto fincl = frames[c];
+        for( uint8_t f=0; f<fincl->size; f++ ) out[fincl->data[f].symAddr].incl += count;
+    }
+}
+
 void Worker::UpdateSampleStatisticsImpl( const CallstackFrameData** frames, uint16_t framesCount, uint32_t count, const VarArray<CallstackFrameId>& cs )
 {
     const auto fexcl = frames[0];
@@ -7482,21 +7922,22 @@ void Worker::UpdateSampleStatisticsImpl( const CallstackFrameData** frames, uint
 
     uint32_t parentIdx;
     {
+        // If the leaf frame has no inlines, the parent call stack is a suffix of the sampled
+        // call stack, and can reference its frames instead of storing a copy.
         const auto sz = framesCount - ( fxsz == 1 );
-        const auto memsize = sizeof( VarArray<CallstackFrameId> ) + sz * sizeof( CallstackFrameId );
+        const auto dataSize = fxsz == 1 ? 0 : sz * sizeof( CallstackFrameId );
+        const auto memsize = sizeof( VarArray<CallstackFrameId> ) + dataSize;
         auto mem = (char*)m_slab.AllocRaw( memsize );
 
-        auto data = (CallstackFrameId*)mem;
-        auto dst = data;
+        const CallstackFrameId* data;
         if( fxsz == 1 )
         {
-            for( int i=0; i<sz; i++ )
-            {
-                *dst++ = cs[i+1];
-            }
+            data = cs.data() + 1;
         }
         else
         {
+            auto dst = (CallstackFrameId*)mem;
+            data = dst;
             *dst++ = parentFrameId;
             for( int i=1; i<sz; i++ )
             {
@@ -7504,7 +7945,7 @@ void Worker::UpdateSampleStatisticsImpl( const CallstackFrameData** frames, uint
             }
         }
 
-        auto arr = (VarArray<CallstackFrameId>*)( mem + sz * sizeof( CallstackFrameId ) );
+        auto arr = (VarArray<CallstackFrameId>*)( mem + dataSize );
         new(arr) VarArray<CallstackFrameId>( sz, data );
 
         auto it = m_data.parentCallstackMap.find( arr );
@@ -7535,18 +7976,9 @@ void Worker::UpdateSampleStatisticsImpl( const CallstackFrameData** frames, uint
     uint32_t baseParentIdx;
     {
         const auto sz = framesCount - 1;
-        const auto memsize = sizeof( VarArray<CallstackFrameId> ) + sz * sizeof( CallstackFrameId );
-        auto mem = (char*)m_slab.AllocRaw( memsize );
-
-        auto data = (CallstackFrameId*)mem;
-        auto dst = data;
-        for( int i=0; i<sz; i++ )
-        {
-            *dst++ = cs[i+1];
-        }
-
-        auto arr = (VarArray<CallstackFrameId>*)( mem + sz * sizeof( CallstackFrameId ) );
-        new(arr) VarArray<CallstackFrameId>( sz, data );
+        const auto memsize = sizeof( VarArray<CallstackFrameId> );
+        auto arr = (VarArray<CallstackFrameId>*)m_slab.AllocRaw( memsize );
+        new(arr) VarArray<CallstackFrameId>( sz, cs.data() + 1 );
 
         auto it = m_data.parentCallstackMap.find( arr );
         if( it == m_data.parentCallstackMap.end() )
@@ -7620,14 +8052,141 @@ void Worker::ReadTimelineHaveSize( FileRead& f, GpuEvent* zone, int64_t& refTime
 }
 
 #ifndef TRACY_NO_STATISTICS
-void Worker::ReconstructZoneStatistics( uint8_t* countMap, ZoneEvent& zone, uint16_t thread )
+void Worker::ReconstructSourceLocationZones()
+{
+    // Top-level zones are independent of each other, so each thread timeline is split into
+    // chunks that are processed by a pool of workers. Statistics of every chunk are gathered
+    // in its own partial map. The partial maps are merged into the global one, partitioned by
+    // srcloc, in chunk order, so the zone lists don't depend on the scheduling of the chunks.
+    struct Chunk
+    {
+        Vector<short_ptr<ZoneEvent>>* timeline;
+        uint32_t begin, end;
+        uint16_t thread;
+    };
+
+#ifdef __EMSCRIPTEN__
+    const size_t jobs = 1;
+#else
+    const size_t jobs = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+#endif
+
+    uint64_t total = 0;
+    uint64_t totalZones = 0;
+    for( auto& t : m_data.threads )
+    {
+        total += t->timeline.size();
+        totalZones += t->count;
+    }
+    const auto chunkTarget = std::max<uint64_t>( totalZones / ( jobs * 8 ), 1 );
+
+    std::vector<Chunk> chunks;
+    for( auto& t : m_data.threads )
+    {
+        const auto sz = t->timeline.size();
+        if( sz == 0 ) continue;
+        // Don't touch thread compression cache in a thread.
+        const auto thread = m_data.localThreadCompress.DecompressMustRaw( t->id );
+        const auto num = std::clamp<uint64_t>( t->count / chunkTarget, 1, sz );
+        for( uint64_t i=0; i<num; i++ )
+        {
+            chunks.emplace_back( Chunk { &t->timeline, uint32_t( sz * i / num ), uint32_t( sz * ( i+1 ) / num ), thread } );
+        }
+    }
+
+    s_loadProgress.statProgress.store( 0, std::memory_order_relaxed );
+    s_loadProgress.statTotal.store( total, std::memory_order_relaxed );
+
+    std::vector<unordered_flat_map<int16_t, SourceLocationZones>> partial( chunks.size() );
+    std::atomic<size_t> next = 0;
+    {
+        auto td = std::make_unique<TaskDispatch>( jobs, "Zone stats" );
+        for( size_t i=0; i<jobs; i++ )
+        {
+            td->Queue( [this, &chunks, &next, &partial] {
+                auto countMap = std::make_unique<uint8_t[]>( 64*1024 );
+                for(;;)
+                {
+                    if( m_shutdown.load( std::memory_order_relaxed ) ) return;
+                    const auto idx = next.fetch_add( 1, std::memory_order_relaxed );
+                    if( idx >= chunks.size() ) return;
+                    auto& chunk = chunks[idx];
+                    ReconstructTimelineStatistics( countMap.get(), partial[idx], *chunk.timeline, chunk.begin, chunk.end, chunk.thread );
+                    s_loadProgress.statProgress.fetch_add( chunk.end - chunk.begin, std::memory_order_relaxed );
+                }
+            } );
+        }
+        td->Sync();
+        if( m_shutdown.load( std::memory_order_relaxed ) ) return;
+
+        for( size_t i=0; i<jobs; i++ )
+        {
+            td->Queue( [this, i, jobs, &partial] {
+                for( auto& part : partial )
+                {
+                    for( auto& v : part )
+                    {
+                        if( uint16_t( v.first ) % jobs != i ) continue;
+                        auto it = m_data.sourceLocationZones.find( v.first );
+                        assert( it != m_data.sourceLocationZones.end() );
+                        auto& dst = it->second;
+                        auto& src = v.second;
+
+                        dst.zones.reserve( dst.zones.size() + src.zones.size() );
+                        for( auto& ztd : src.zones ) dst.zones.push_back( ztd );
+                        dst.min = std::min( dst.min, src.min );
+                        dst.max = std::max( dst.max, src.max );
+                        dst.total += src.total;
+                        dst.sumSq += src.sumSq;
+                        dst.selfMin = std::min( dst.selfMin, src.selfMin );
+                        dst.selfMax = std::max( dst.selfMax, src.selfMax );
+                        dst.selfTotal += src.selfTotal;
+                        dst.nonReentrantCount += src.nonReentrantCount;
+                        dst.nonReentrantMin = std::min( dst.nonReentrantMin, src.nonReentrantMin );
+                        dst.nonReentrantMax = std::max( dst.nonReentrantMax, src.nonReentrantMax );
+                        dst.nonReentrantTotal += src.nonReentrantTotal;
+                        for( auto& tc : src.threadCnt ) dst.threadCnt[tc.first] += tc.second;
+                    }
+                }
+            } );
+        }
+        td->Sync();
+    }
+
+    std::lock_guard<std::mutex> lock( m_data.lock );
+    m_data.sourceLocationZonesReady = true;
+}
+
+void Worker::ReconstructTimelineStatistics( uint8_t* countMap, unordered_flat_map<int16_t, SourceLocationZones>& slzMap, Vector<short_ptr<ZoneEvent>>& _vec, uint32_t begin, uint32_t end, uint16_t thread )
+{
+    if( m_shutdown.load( std::memory_order_relaxed ) ) return;
+    assert( _vec.is_magic() );
+    auto& vec = *(Vector<ZoneEvent>*)( &_vec );
+    for( uint32_t i=begin; i<end; i++ )
+    {
+        auto& zone = vec[i];
+        if( zone.IsEndValid() ) ReconstructZoneStatistics( countMap, slzMap, zone, thread );
+        if( zone.HasChildren() )
+        {
+            auto& children = GetZoneChildrenMutable( zone.Child() );
+            countMap[uint16_t(zone.SrcLoc())]++;
+            ReconstructTimelineStatistics( countMap, slzMap, children, 0, children.size(), thread );
+            countMap[uint16_t(zone.SrcLoc())]--;
+        }
+    }
+}
+
+void Worker::ReconstructZoneStatistics( uint8_t* countMap, unordered_flat_map<int16_t, SourceLocationZones>& slzMap, ZoneEvent& zone, uint16_t thread )
 {
     assert( zone.IsEndValid() );
     auto timeSpan = zone.End() - zone.Start();
     if( timeSpan > 0 )
     {
-        auto it = m_data.sourceLocationZones.find( zone.SrcLoc() );
-        assert( it != m_data.sourceLocationZones.end() );
+        auto it = slzMap.find( zone.SrcLoc() );
+        if( it == slzMap.end() )
+        {
+            it = slzMap.emplace( zone.SrcLoc(), SourceLocationZones() ).first;
+        }
 
         ZoneThreadData ztd;
         ztd.SetZone( &zone );
@@ -7687,15 +8246,181 @@ void Worker::ReconstructZoneStatistics( GpuEvent& zone, uint16_t thread )
         {
             it = m_data.gpuSourceLocationZones.emplace( zone.SrcLoc(), GpuSourceLocationZones {} ).first;
         }
-        GpuZoneThreadData ztd;
-        ztd.SetZone( &zone );
-        ztd.SetThread( thread );
-        auto& slz = it->second;
-        slz.zones.push_back( ztd );
-        if( slz.min > timeSpan ) slz.min = timeSpan;
-        if( slz.max < timeSpan ) slz.max = timeSpan;
-        slz.total += timeSpan;
-        slz.sumSq += double( timeSpan ) * timeSpan;
+        AddGpuZoneStatistics( it->second, zone, thread, timeSpan );
+    }
+}
+
+static tracy_force_inline int GpuLatencyBucket( int64_t latency )
+{
+    if( latency <= 0 ) return 0;
+    return std::min<int>( 64 - TracyLzcnt( latency ), Worker::GpuLatencyBuckets - 1 );
+}
+
+void Worker::AddGpuZoneStatistics( GpuSourceLocationZones& slz, GpuEvent& zone, uint16_t thread, int64_t timeSpan )
+{
+    GpuZoneThreadData ztd;
+    ztd.SetZone( &zone );
+    ztd.SetThread( thread );
+    slz.zones.push_back( ztd );
+    if( slz.min > timeSpan ) slz.min = timeSpan;
+    if( slz.max < timeSpan ) slz.max = timeSpan;
+    slz.total += timeSpan;
+    slz.sumSq += double( timeSpan ) * timeSpan;
+
+    // Children resolve their timestamps before the parent end query in the common case.
+    // A child that is still pending is accounted as parent self time.
+    const auto selfSpan = timeSpan - GetGpuZoneChildTime( zone );
+    if( slz.selfMin > selfSpan ) slz.selfMin = selfSpan;
+    if( slz.selfMax < selfSpan ) slz.selfMax = selfSpan;
+    slz.selfTotal += selfSpan;
+
+    const auto latency = zone.GpuStart() - zone.CpuStart();
+    if( slz.latencyMin > latency ) slz.latencyMin = latency;
+    if( slz.latencyMax < latency ) slz.latencyMax = latency;
+    slz.latencyTotal += latency;
+    slz.latencySumSq += double( latency ) * latency;
+    slz.latency[GpuLatencyBucket( latency )]++;
+}
+
+int64_t Worker::GetGpuZoneChildTime( const GpuEvent& zone ) const
+{
+    int64_t time = 0;
+    if( zone.Child() >= 0 )
+    {
+        auto& children = GetGpuChildren( zone.Child() );
+        if( children.is_magic() )
+        {
+            auto& vec = *(Vector<GpuEvent>*)&children;
+            for( auto& v : vec )
+            {
+                if( v.GpuEnd() >= 0 ) time += std::max( int64_t( 0 ), v.GpuEnd() - v.GpuStart() );
+            }
+        }
+        else
+        {
+            for( auto& v : children )
+            {
+                if( v->GpuEnd() >= 0 ) time += std::max( int64_t( 0 ), v->GpuEnd() - v->GpuStart() );
+            }
+        }
+    }
+    return time;
+}
+
+// Top level zones are merged into the context flame graph in timeline order, as soon
+// as their end timestamp is known. Zones are never revisited afterwards. In a loaded
+// trace no more timestamps will arrive, and zones left unresolved are skipped.
+void Worker::UpdateGpuFlameGraph( GpuCtxData& ctx, GpuCtxThreadData& td, bool complete )
+{
+    auto& timeline = td.timeline;
+    if( timeline.is_magic() )
+    {
+        auto& vec = *(Vector<GpuEvent>*)&timeline;
+        while( td.flameGraphIdx < vec.size() )
+        {
+            auto& zone = vec[td.flameGraphIdx];
+            if( zone.GpuEnd() >= 0 ) AddGpuFlameGraph( ctx.flameGraph, zone );
+            else if( !complete ) break;
+            td.flameGraphIdx++;
+        }
+    }
+    else
+    {
+        while( td.flameGraphIdx < timeline.size() )
+        {
+            auto& zone = *timeline[td.flameGraphIdx];
+            if( zone.GpuEnd() >= 0 ) AddGpuFlameGraph( ctx.flameGraph, zone );
+            else if( !complete ) break;
+            td.flameGraphIdx++;
+        }
+    }
+}
+
+void Worker::AddGpuFlameGraph( std::vector<FlameGraphItem>& data, const GpuEvent& zone )
+{
+    const auto srcloc = zone.SrcLoc();
+    const auto duration = std::max( int64_t( 0 ), zone.GpuEnd() - zone.GpuStart() );
+    auto it = std::find_if( data.begin(), data.end(), [srcloc]( const auto& v ) { return v.srcloc == srcloc; } );
+    if( it == data.end() )
+    {
+        data.emplace_back( FlameGraphItem { srcloc, duration } );
+        it = data.end() - 1;
+    }
+    else
+    {
+        it->time += duration;
+    }
+    if( zone.Child() < 0 ) return;
+
+    auto& item = *it;
+    auto& children = GetGpuChildren( zone.Child() );
+    if( children.is_magic() )
+    {
+        auto& vec = *(Vector<GpuEvent>*)&children;
+        for( auto& v : vec )
+        {
+            if( v.GpuEnd() >= 0 ) AddGpuFlameGraph( item.children, v );
+        }
+    }
+    else
+    {
+        for( auto& v : children )
+        {
+            if( v->GpuEnd() >= 0 ) AddGpuFlameGraph( item.children, *v );
+        }
+    }
+}
+
+// Context switch call stacks are weighted by the time the thread stayed switched out. Stacks
+// captured when the thread is switched out (Linux) can only be attributed once the thread is
+// scheduled again. Stacks captured when the thread resumes (Windows) close the preceding
+// off-CPU period.
+void Worker::UpdateOffCpuStacks( ThreadData& td )
+{
+    auto& samples = td.ctxSwitchSamples;
+    if( td.offCpuIdx == samples.size() ) return;
+    auto ctx = GetContextSwitchData( td.id );
+    if( !ctx ) return;
+
+    auto& v = ctx->v;
+    auto it = v.begin();
+    while( td.offCpuIdx < samples.size() )
+    {
+        const auto& sd = samples[td.offCpuIdx];
+        const auto t = sd.time.Val();
+        it = std::lower_bound( it, v.end(), t, [] ( const auto& l, const auto& r ) { return (uint64_t)l.End() < (uint64_t)r; } );
+        if( it == v.end() || it->Reason() == ContextSwitchData::Wakeup ) break;
+
+        int64_t wait = 0;
+        if( it->Start() == t )
+        {
+            if( it != v.begin() && ( it-1 )->IsEndValid() ) wait = t - ( it-1 )->End();
+        }
+        else if( !it->IsEndValid() )
+        {
+            break;
+        }
+        else if( it->End() == t )
+        {
+            auto next = it + 1;
+            if( next == v.end() || next->Reason() == ContextSwitchData::Wakeup ) break;
+            wait = next->Start() - t;
+        }
+
+        if( wait > 0 )
+        {
+            const auto cs = sd.callstack.Val();
+            auto sit = td.offCpuStacks.find( cs );
+            if( sit == td.offCpuStacks.end() )
+            {
+                td.offCpuStacks.emplace( cs, wait );
+            }
+            else
+            {
+                sit->second += wait;
+            }
+        }
+        td.offCpuIdx++;
     }
 }
 #else
@@ -22,6 +22,7 @@
 #include "TracyShortPtr.hpp"
 #include "TracySlab.hpp"
 #include "TracyStringDiscovery.hpp"
+#include "TracyTextIndex.hpp"
 #include "TracyTextureCompression.hpp"
 #include "TracyThreadCompress.hpp"
 #include "TracyVarArray.hpp"
@@ -32,6 +33,7 @@ namespace tracy
 
 class FileRead;
 class FileWrite;
+class TaskDispatch;
 
 namespace EventType
 {
@@ -87,12 +89,16 @@ struct LoadProgress
         ContextSwitchesPerCpu
     };
 
-    LoadProgress() : total( 0 ), progress( 0 ), subTotal( 0 ), subProgress( 0 ) {}
+    LoadProgress() : total( 0 ), progress( 0 ), subTotal( 0 ), subProgress( 0 ), statTotal( 0 ), statProgress( 0 ) {}
 
     std::atomic<uint64_t> total;
     std::atomic<uint64_t> progress;
     std::atomic<uint64_t> subTotal;
     std::atomic<uint64_t> subProgress;
+
+    // Background zone statistics reconstruction, counted in top-level zones
+    std::atomic<uint64_t> statTotal;
+    std::atomic<uint64_t> statProgress;
 };
 
 class Worker
@@ -145,6 +151,11 @@ public:
     };
     enum { GpuZoneThreadDataSize = sizeof( GpuZoneThreadData ) };
 
+    // CPU submit to GPU execution latency histogram. Bucket 0 counts zones that started
+    // on the GPU before they were submitted (clock domain skew), bucket n counts latencies
+    // in the [2^(n-1), 2^n) ns range.
+    enum { GpuLatencyBuckets = 48 };
+
     struct CpuThreadTopology
     {
         uint32_t package;
@@ -224,6 +235,14 @@ private:
         int64_t max = std::numeric_limits<int64_t>::min();
         int64_t total = 0;
         double sumSq = 0;
+        int64_t selfMin = std::numeric_limits<int64_t>::max();
+        int64_t selfMax = std::numeric_limits<int64_t>::min();
+        int64_t selfTotal = 0;
+        int64_t latencyMin = std::numeric_limits<int64_t>::max();
+        int64_t latencyMax = std::numeric_limits<int64_t>::min();
+        int64_t latencyTotal = 0;
+        double latencySumSq = 0;
+        uint64_t latency[GpuLatencyBuckets] = {};
     };
 
     struct CallstackFrameIdHash
@@ -285,6 +304,12 @@ private:
         StringDiscovery<PlotData*> plots;
         Vector<ThreadData*> threads;
         Vector<ZoneExtra> zoneExtra;
+        TextIndex messageIndex;
+        Vector<short_ptr<MessageData>> messageIndexDocs;
+        Vector<short_ptr<MessageData>> messageIndexPending;
+        TextIndex zoneTextIndex;
+        Vector<short_ptr<ZoneEvent>> zoneTextDocs;
+        bool textIndexReady = false;
         MemData* memory;
         unordered_flat_map<uint64_t, MemData*> memNameMap;
         uint64_t zonesCnt = 0;
@@ -347,6 +372,7 @@ private:
         bool ghostZonesReady = false;
         bool ghostZonesPostponed = false;
         bool symbolSamplesReady = false;
+        bool sampleBlocksReady = false;
 #endif
 
         unordered_flat_map<uint32_t, LockMap*> lockMap;
@@ -458,6 +484,14 @@ public:
     Worker( FileRead& f, EventType::Type eventMask = EventType::All, bool bgTasks = true, bool allowStringModification = false);
     ~Worker();
 
+    // Incremental import. Timeline and message events may be passed in any number of batches, but must be sorted by
+    // timestamp across all calls. FinishImport() has to be called once, after all events were passed in.
+    Worker( const char* name, const char* program );
+    void ImportTimeline( const ImportEventTimeline* events, size_t count );
+    void ImportMessages( const ImportEventMessages* events, size_t count );
+    void ImportPlot( const ImportEventPlots& plot );
+    void FinishImport( const std::unordered_map<uint64_t, std::string>& threadNames );
+
     const std::string& GetAddr() const { return m_addr; }
     uint16_t GetPort() const { return m_port; }
     const std::string& GetCaptureName() const { return m_captureName; }
@@ -486,6 +520,7 @@ public:
     uint64_t GetContextSwitchCount() const;
     uint64_t GetContextSwitchPerCpuCount() const;
     bool HasContextSwitches() const { return !m_data.ctxSwitch.empty(); }
+    const unordered_flat_map<uint64_t, ContextSwitch*>& GetContextSwitchMap() const { return m_data.ctxSwitch; }
     uint64_t GetSrcLocCount() const { return m_data.sourceLocationPayload.size() + m_data.sourceLocation.size(); }
     uint64_t GetCallstackPayloadCount() const { return m_data.callstackPayload.size() - 1; }
 #ifndef TRACY_NO_STATISTICS
@@ -534,11 +569,22 @@ public:
 
     const unordered_flat_map<uint32_t, LockMap*>& GetLockMap() const { return m_data.lockMap; }
     const Vector<short_ptr<MessageData>>& GetMessages() const { return m_data.messages; }
+
+    // Substring lookup through the trigram index of message and zone text strings. Case is
+    // ignored. Returned candidates must still be matched against the searched text. A false
+    // return value means the index cannot answer the query and a full scan is needed.
+    bool IsTextIndexReady() const { return m_data.textIndexReady; }
+    bool GetMessageCandidates( const char* text, size_t len, std::vector<const MessageData*>& out ) const;
+    bool GetZoneTextCandidates( const char* text, size_t len, std::vector<const ZoneEvent*>& out ) const;
     const Vector<GpuCtxData*>& GetGpuData() const { return m_data.gpuData; }
     const Vector<PlotData*>& GetPlots() const { return m_data.plots.Data(); }
     const Vector<ThreadData*>& GetThreadData() const { return m_data.threads; }
     const ThreadData* GetThreadData( uint64_t tid ) const;
     const MemData& GetMemoryNamed( uint64_t name ) const;
+    void GetMemoryLive( const MemData& mem, int64_t time, std::vector<uint32_t>& out ) const { GetMemoryLive( mem, time, time, out ); }
+    void GetMemoryLive( const MemData& mem, int64_t t0, int64_t t1, std::vector<uint32_t>& out ) const;
+    void UpdatePlotLod( PlotData& plot );
+    std::pair<uint32_t, uint32_t> GetPlotMinMax( const PlotData& plot, uint32_t begin, uint32_t end ) const;
     const unordered_flat_map<uint64_t, MemData*>& GetMemNameMap() const { return m_data.memNameMap; }
     const Vector<short_ptr<FrameImage>>& GetFrameImages() const { return m_data.frameImage; }
     const Vector<StringRef>& GetAppInfo() const { return m_data.appInfo; }
@@ -564,6 +610,7 @@ public:
     const CallstackFrameData* GetParentCallstackFrame( const CallstackFrameId& ptr ) const;
     const Vector<SampleDataRange>* GetSamplesForSymbol( uint64_t symAddr ) const;
     const Vector<ChildSample>* GetChildSamples( uint64_t addr ) const;
+    void GetSymbolCountsForRange( int64_t min, int64_t max, unordered_flat_map<uint64_t, SymbolCount>& out, TaskDispatch& td ) const;
 #endif
 
     const CrashEvent& GetCrashEvent() const { return m_data.crashEvent; }
@@ -622,6 +669,7 @@ public:
     bool AreCallstackSamplesReady() const { return m_data.callstackSamplesReady; }
     bool AreGhostZonesReady() const { return m_data.ghostZonesReady; }
     bool AreSymbolSamplesReady() const { return m_data.symbolSamplesReady; }
+    bool AreSampleBlocksReady() const { return m_data.sampleBlocksReady; }
 #endif
 
     tracy_force_inline uint16_t CompressThread( uint64_t thread ) { return m_data.localThreadCompress.CompressThread( thread ); }
@@ -819,8 +867,13 @@ private:
     tracy_force_inline void MemAllocChanged( MemData& memdata, int64_t time );
     void CreateMemAllocPlot( MemData& memdata );
     void ReconstructMemAllocPlot( MemData& memdata );
+    void UpdateMemoryCheckpoints( MemData& memdata );
 
     void InsertMessageData( MessageData* msg );
+    void IndexMessage( const MessageData* msg );
+    void AddMessageToIndex( const MessageData* msg );
+    void IndexZoneText( const ZoneEvent* zone );
+    void BuildTextIndex( const Vector<short_ptr<ZoneEvent>>& vec );
 
     ThreadData* NoticeThreadReal( uint64_t thread );
     ThreadData* NewThread( uint64_t thread, bool fiber, int32_t groupHint );
@@ -897,6 +950,7 @@ private:
     uint32_t MergeCallstacks( uint32_t first, uint32_t second );
 
     void InsertPlot( PlotData* plot, int64_t time, double val );
+    void SortPlot( PlotData& plot );
     void HandlePlotName( uint64_t name, const char* str, size_t sz );
     void HandleFrameName( uint64_t name, const char* str, size_t sz );
 
@@ -930,6 +984,9 @@ private:
     void UpdateSampleStatisticsImpl( const CallstackFrameData** frames, uint16_t framesCount, uint32_t count, const VarArray<CallstackFrameId>& cs );
     tracy_force_inline void GetStackWithInlines( Vector<InlineStackData>& ret, const VarArray<CallstackFrameId>& cs );
     tracy_force_inline int AddGhostZone( const VarArray<CallstackFrameId>& cs, Vector<GhostZone>* vec, uint64_t t );
+    void BuildSampleBlocks( ThreadData& td );
+    void CountRangeSamples( const ThreadData& td, size_t begin, size_t end, unordered_flat_map<uint64_t, SymbolCount>& out ) const;
+    void AccumulateSymbolCounts( uint32_t callstack, uint32_t count, unordered_flat_map<uint64_t, SymbolCount>& out ) const;
 #endif
 
     tracy_force_inline int64_t ReadTimeline( FileRead& f, ZoneEvent* zone, int64_t refTime, int32_t& childIdx );
@@ -938,8 +995,15 @@ private:
     tracy_force_inline void ReadTimelineHaveSize( FileRead& f, GpuEvent* zone, int64_t& refTime, int64_t& refGpuTime, int32_t& childIdx, uint64_t sz );
 
 #ifndef TRACY_NO_STATISTICS
-    tracy_force_inline void ReconstructZoneStatistics( uint8_t* countMap, ZoneEvent& zone, uint16_t thread );
+    void ReconstructSourceLocationZones();
+    void ReconstructTimelineStatistics( uint8_t* countMap, unordered_flat_map<int16_t, SourceLocationZones>& slzMap, Vector<short_ptr<ZoneEvent>>& vec, uint32_t begin, uint32_t end, uint16_t thread );
+    tracy_force_inline void ReconstructZoneStatistics( uint8_t* countMap, unordered_flat_map<int16_t, SourceLocationZones>& slzMap, ZoneEvent& zone, uint16_t thread );
     tracy_force_inline void ReconstructZoneStatistics( GpuEvent& zone, uint16_t thread );
+    tracy_force_inline void AddGpuZoneStatistics( GpuSourceLocationZones& slz, GpuEvent& zone, uint16_t thread, int64_t timeSpan );
+    int64_t GetGpuZoneChildTime( const GpuEvent& zone ) const;
+    void UpdateGpuFlameGraph( GpuCtxData& ctx, GpuCtxThreadData& td, bool complete = false );
+    void AddGpuFlameGraph( std::vector<FlameGraphItem>& data, const GpuEvent& zone );
+    void UpdateOffCpuStacks( ThreadData& td );
 #else
     tracy_force_inline void CountZoneStatistics( ZoneEvent* zone );
     tracy_force_inline void CountZoneStatistics( GpuEvent* zone );
@@ -1063,6 +1127,7 @@ private:
 
     uint64_t m_threadCtx = 0;
     ThreadData* m_threadCtxData = nullptr;
+    std::unordered_map<std::string, uint64_t> m_importFrameNames;
     int64_t m_refTimeThread = 0;
     int64_t m_refTimeSerial = 0;
     int64_t m_refTimeCtx = 0;
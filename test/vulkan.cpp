@@ -0,0 +1,166 @@
+// Vulkan GPU zone collection through the readback buffer. Enough zones are recorded to wrap the query
+// pool and the readback ring several times. Every few frames the zones are recorded before the
+// collection but submitted after it, so that queries which were not written yet get copied. The number
+// of recorded zones is printed on exit, to be compared with the GPU zones in the capture.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vulkan/vulkan.h>
+#include "tracy/Tracy.hpp"
+#include "tracy/TracyVulkan.hpp"
+
+#define VK_CHECK( call ) do { const VkResult res = ( call ); if( res != VK_SUCCESS ) { fprintf( stderr, "%s failed (%i)\n", #call, (int)res ); exit( 1 ); } } while( 0 )
+
+enum { Frames = 200 };
+enum { ZonesPerFrame = 700 };
+enum { FramesInFlight = 3 };
+enum { LateFrameInterval = 7 };
+
+int main()
+{
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "tracy-test-vulkan";
+    appInfo.apiVersion = VK_MAKE_VERSION( 1, 0, 0 );
+
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+
+    VkInstance instance;
+    VK_CHECK( vkCreateInstance( &instanceInfo, nullptr, &instance ) );
+
+    uint32_t count = 1;
+    VkPhysicalDevice physdev;
+    if( vkEnumeratePhysicalDevices( instance, &count, &physdev ) < 0 || count == 0 )
+    {
+        fprintf( stderr, "No Vulkan device\n" );
+        return 1;
+    }
+
+    VkQueueFamilyProperties families[16];
+    count = 16;
+    vkGetPhysicalDeviceQueueFamilyProperties( physdev, &count, families );
+    uint32_t family = 0;
+    while( family < count && ( ( families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT ) == 0 || families[family].timestampValidBits == 0 ) ) family++;
+    if( family == count )
+    {
+        fprintf( stderr, "No queue family with timestamp support\n" );
+        return 1;
+    }
+
+    const float priority = 1.f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = family;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+
+    VkDevice device;
+    VK_CHECK( vkCreateDevice( physdev, &deviceInfo, nullptr, &device ) );
+    VkQueue queue;
+    vkGetDeviceQueue( device, family, 0, &queue );
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = family;
+    VkCommandPool pool;
+    VK_CHECK( vkCreateCommandPool( device, &poolInfo, nullptr, &pool ) );
+
+    // A collect and a work command buffer for each frame in flight, and one for the context setup.
+    VkCommandBuffer cmdbufs[FramesInFlight * 2 + 1];
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = pool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = FramesInFlight * 2 + 1;
+    VK_CHECK( vkAllocateCommandBuffers( device, &allocInfo, cmdbufs ) );
+
+    VkFence fences[FramesInFlight];
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    for( auto& fence : fences ) VK_CHECK( vkCreateFence( device, &fenceInfo, nullptr, &fence ) );
+
+    while( !TracyIsConnected ) std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+
+    TracyVkCtx ctx = TracyVkContext( physdev, device, queue, cmdbufs[FramesInFlight * 2] );
+    if( !TracyVkEnableReadbackBuffer( ctx ) )
+    {
+        fprintf( stderr, "Readback buffer not available\n" );
+        return 1;
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+
+    for( int frame=0; frame<Frames; frame++ )
+    {
+        const auto slot = frame % FramesInFlight;
+        VK_CHECK( vkWaitForFences( device, 1, &fences[slot], VK_TRUE, UINT64_MAX ) );
+        VK_CHECK( vkResetFences( device, 1, &fences[slot] ) );
+
+        auto collect = cmdbufs[slot * 2];
+        auto work = cmdbufs[slot * 2 + 1];
+        const bool late = frame % LateFrameInterval == LateFrameInterval / 2;
+
+        if( !late )
+        {
+            VK_CHECK( vkBeginCommandBuffer( collect, &beginInfo ) );
+            TracyVkCollect( ctx, collect );
+            VK_CHECK( vkEndCommandBuffer( collect ) );
+        }
+        VK_CHECK( vkBeginCommandBuffer( work, &beginInfo ) );
+        for( int i=0; i<ZonesPerFrame; i++ )
+        {
+            TracyVkZone( ctx, work, "Work" );
+        }
+        VK_CHECK( vkEndCommandBuffer( work ) );
+        if( late )
+        {
+            VK_CHECK( vkBeginCommandBuffer( collect, &beginInfo ) );
+            TracyVkCollect( ctx, collect );
+            VK_CHECK( vkEndCommandBuffer( collect ) );
+        }
+
+        submitInfo.pCommandBuffers = &collect;
+        VK_CHECK( vkQueueSubmit( queue, 1, &submitInfo, VK_NULL_HANDLE ) );
+        submitInfo.pCommandBuffers = &work;
+        VK_CHECK( vkQueueSubmit( queue, 1, &submitInfo, fences[slot] ) );
+        FrameMark;
+    }
+
+    // Each collection picks up the copies recorded by the previous one.
+    auto collect = cmdbufs[0];
+    submitInfo.pCommandBuffers = &collect;
+    for( int i=0; i<3; i++ )
+    {
+        VK_CHECK( vkDeviceWaitIdle( device ) );
+        VK_CHECK( vkBeginCommandBuffer( collect, &beginInfo ) );
+        TracyVkCollect( ctx, collect );
+        VK_CHECK( vkEndCommandBuffer( collect ) );
+        VK_CHECK( vkQueueSubmit( queue, 1, &submitInfo, VK_NULL_HANDLE ) );
+    }
+    VK_CHECK( vkDeviceWaitIdle( device ) );
+
+    TracyVkDestroy( ctx );
+    for( auto& fence : fences ) vkDestroyFence( device, fence, nullptr );
+    vkDestroyCommandPool( device, pool, nullptr );
+    vkDestroyDevice( device, nullptr );
+    vkDestroyInstance( instance, nullptr );
+
+    printf( "%i\n", Frames * ZonesPerFrame );
+}
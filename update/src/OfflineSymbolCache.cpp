@@ -0,0 +1,198 @@
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "OfflineSymbolCache.h"
+
+static constexpr char CacheMagic[4] = { 't', 'S', 'y', 'C' };
+static constexpr uint32_t CacheVersion = 2;
+
+template<typename T>
+static T ReadValue( const char* ptr )
+{
+    T val;
+    memcpy( &val, ptr, sizeof( T ) );
+    return val;
+}
+
+// Looks for the NT_GNU_BUILD_ID note in the section headers of an ELF file in host byte order.
+bool GetImageBuildId( const std::string& imagePath, std::string& buildId )
+{
+    std::ifstream f( imagePath, std::ios::binary );
+    if( !f ) return false;
+
+    char ehdr[64];
+    if( !f.read( ehdr, sizeof( ehdr ) ) ) return false;
+    if( memcmp( ehdr, "\x7f" "ELF", 4 ) != 0 ) return false;
+
+    const uint16_t endianTest = 1;
+    const uint8_t hostData = *(const uint8_t*)&endianTest == 1 ? 1 : 2;
+    if( ehdr[5] != hostData ) return false;
+
+    const bool is64 = ehdr[4] == 2;
+    const uint64_t shoff = is64 ? ReadValue<uint64_t>( ehdr + 0x28 ) : ReadValue<uint32_t>( ehdr + 0x20 );
+    const uint16_t shentsize = ReadValue<uint16_t>( ehdr + ( is64 ? 0x3A : 0x2E ) );
+    const uint16_t shnum = ReadValue<uint16_t>( ehdr + ( is64 ? 0x3C : 0x30 ) );
+    if( shoff == 0 || shnum == 0 || shentsize < ( is64 ? 0x28 : 0x18 ) ) return false;
+
+    std::vector<char> shdrs( size_t( shentsize ) * shnum );
+    f.seekg( shoff );
+    if( !f.read( shdrs.data(), shdrs.size() ) ) return false;
+
+    for( uint16_t i=0; i<shnum; i++ )
+    {
+        const char* shdr = shdrs.data() + size_t( i ) * shentsize;
+        enum { SHT_NOTE = 7 };
+        if( ReadValue<uint32_t>( shdr + 4 ) != SHT_NOTE ) continue;
+        const uint64_t offset = is64 ? ReadValue<uint64_t>( shdr + 0x18 ) : ReadValue<uint32_t>( shdr + 0x10 );
+        const uint64_t size = is64 ? ReadValue<uint64_t>( shdr + 0x20 ) : ReadValue<uint32_t>( shdr + 0x14 );
+        if( size > 64 * 1024 ) continue;
+
+        std::vector<char> notes( size );
+        f.seekg( offset );
+        if( !f.read( notes.data(), size ) ) return false;
+
+        size_t pos = 0;
+        while( pos + 12 <= size )
+        {
+            const auto namesz = ReadValue<uint32_t>( notes.data() + pos );
+            const auto descsz = ReadValue<uint32_t>( notes.data() + pos + 4 );
+            const auto type = ReadValue<uint32_t>( notes.data() + pos + 8 );
+            const size_t name = pos + 12;
+            const size_t desc = name + ( ( namesz + 3 ) & ~3 );
+            if( desc + descsz > size ) break;
+
+            enum { NT_GNU_BUILD_ID = 3 };
+            if( type == NT_GNU_BUILD_ID && namesz == 4 && memcmp( notes.data() + name, "GNU", 4 ) == 0 && descsz != 0 )
+            {
+                static constexpr char Hex[] = "0123456789abcdef";
+                buildId.clear();
+                for( uint32_t j=0; j<descsz; j++ )
+                {
+                    const auto c = (uint8_t)notes[desc + j];
+                    buildId.push_back( Hex[c >> 4] );
+                    buildId.push_back( Hex[c & 0xF] );
+                }
+                return true;
+            }
+            pos = desc + ( ( descsz + 3 ) & ~3 );
+        }
+    }
+    return false;
+}
+
+std::string GetDefaultSymbolCacheDirectory()
+{
+#ifdef _WIN32
+    const char* base = getenv( "LOCALAPPDATA" );
+    if( !base ) return "";
+    return std::string( base ) + "/tracy/symbols";
+#else
+    const char* base = getenv( "XDG_CACHE_HOME" );
+    if( base && *base ) return std::string( base ) + "/tracy/symbols";
+    base = getenv( "HOME" );
+    if( !base ) return "";
+    return std::string( base ) + "/.cache/tracy/symbols";
+#endif
+}
+
+SymbolCache::SymbolCache( const std::string& cacheDir, const std::string& imagePath )
+{
+    if( cacheDir.empty() ) return;
+    std::string buildId;
+    if( !GetImageBuildId( imagePath, buildId ) ) return;
+    m_path = cacheDir + "/" + buildId + ".symbols";
+    Load();
+}
+
+const SymbolEntry* SymbolCache::Find( uint64_t offset ) const
+{
+    auto it = m_entries.find( offset );
+    return it != m_entries.end() ? &it->second : nullptr;
+}
+
+void SymbolCache::Add( uint64_t offset, const SymbolEntry& entry )
+{
+    if( entry.file.empty() ) return;
+    m_entries[offset] = entry;
+    m_dirty = true;
+}
+
+// File layout: magic, version, entry count, followed by the entries, each being
+// offset (u64), line (i32), name length (u32), file length (u32), name, file.
+void SymbolCache::Load()
+{
+    std::ifstream f( m_path, std::ios::binary | std::ios::ate );
+    if( !f ) return;
+    std::vector<char> buf( (size_t)f.tellg() );
+    f.seekg( 0 );
+    if( !f.read( buf.data(), buf.size() ) ) return;
+
+    if( buf.size() < 12 || memcmp( buf.data(), CacheMagic, 4 ) != 0 ) return;
+    if( ReadValue<uint32_t>( buf.data() + 4 ) != CacheVersion ) return;
+    const auto count = ReadValue<uint32_t>( buf.data() + 8 );
+    if( count > ( buf.size() - 12 ) / 20 ) return;
+
+    const char* ptr = buf.data() + 12;
+    const char* end = buf.data() + buf.size();
+    m_entries.reserve( count );
+    for( uint32_t i=0; i<count; i++ )
+    {
+        if( end - ptr < 20 ) break;
+        const auto offset = ReadValue<uint64_t>( ptr );
+        const auto line = ReadValue<int32_t>( ptr + 8 );
+        const auto nameLen = ReadValue<uint32_t>( ptr + 12 );
+        const auto fileLen = ReadValue<uint32_t>( ptr + 16 );
+        ptr += 20;
+        if( size_t( end - ptr ) < size_t( nameLen ) + fileLen ) break;
+
+        auto& entry = m_entries[offset];
+        entry.name.assign( ptr, nameLen );
+        entry.file.assign( ptr + nameLen, fileLen );
+        entry.line = line;
+        ptr += nameLen + fileLen;
+    }
+}
+
+bool SymbolCache::Save()
+{
+    if( !m_dirty || m_path.empty() ) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories( std::filesystem::path( m_path ).parent_path(), ec );
+
+    // Written to a temporary file first, so that a concurrent reader never sees a partial cache.
+    static std::atomic<uint32_t> tmpCounter = 0;
+    const auto tmpPath = m_path + ".tmp" + std::to_string( tmpCounter.fetch_add( 1, std::memory_order_relaxed ) );
+    {
+        std::ofstream f( tmpPath, std::ios::binary | std::ios::trunc );
+        if( !f ) return false;
+
+        const uint32_t count = (uint32_t)m_entries.size();
+        f.write( CacheMagic, 4 );
+        f.write( (const char*)&CacheVersion, sizeof( CacheVersion ) );
+        f.write( (const char*)&count, sizeof( count ) );
+        for( auto& v : m_entries )
+        {
+            const int32_t line = v.second.line;
+            const uint32_t nameLen = (uint32_t)v.second.name.size();
+            const uint32_t fileLen = (uint32_t)v.second.file.size();
+            f.write( (const char*)&v.first, sizeof( v.first ) );
+            f.write( (const char*)&line, sizeof( line ) );
+            f.write( (const char*)&nameLen, sizeof( nameLen ) );
+            f.write( (const char*)&fileLen, sizeof( fileLen ) );
+            f.write( v.second.name.data(), nameLen );
+            f.write( v.second.file.data(), fileLen );
+        }
+        if( !f ) return false;
+    }
+
+    std::filesystem::rename( tmpPath, m_path, ec );
+    if( ec ) return false;
+    m_dirty = false;
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef __OFFLINESYMBOLCACHE_HPP__
+#define __OFFLINESYMBOLCACHE_HPP__
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+#include "OfflineSymbolResolver.h"
+
+// Symbols resolved in previous runs for a single image. The cache file is named after the
+// build-id of the image, so a rebuilt binary never picks up stale entries.
+class SymbolCache
+{
+public:
+    SymbolCache( const std::string& cacheDir, const std::string& imagePath );
+
+    bool IsValid() const { return !m_path.empty(); }
+    size_t Size() const { return m_entries.size(); }
+
+    const SymbolEntry* Find( uint64_t offset ) const;
+    // Entries without a source file are ignored. A stripped image and its separate debug file
+    // share the build-id, so such an entry may still be resolved in a later run.
+    void Add( uint64_t offset, const SymbolEntry& entry );
+    bool Save();
+
+private:
+    void Load();
+
+    std::string m_path;
+    std::unordered_map<uint64_t, SymbolEntry> m_entries;
+    bool m_dirty = false;
+};
+
+std::string GetDefaultSymbolCacheDirectory();
+bool GetImageBuildId( const std::string& imagePath, std::string& buildId );
+
+#endif // __OFFLINESYMBOLCACHE_HPP__
@@ -1,14 +1,20 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
 #include <unordered_map>
 #include <zstd.h>
 
+#include "../../server/TracyPrint.hpp"
 #include "../../server/TracyWorker.hpp"
 
+#include "OfflineSymbolCache.h"
 #include "OfflineSymbolResolver.h"
 
 bool ApplyPathSubstitutions( std::string& path, const PathSubstitutionList& pathSubstitutionlist )
@@ -31,7 +37,69 @@ tracy::StringIdx AddSymbolString( tracy::Worker& worker, const std::string& str
     return tracy::StringIdx( location.idx );
 }
 
-bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& pathSubstitutionlist, bool verbose )
+// All unresolved frames of a single image. Each offset is resolved once, no matter how many
+// frames share it.
+struct ImageJob
+{
+    std::string imagePath;
+    std::string resolvePath;
+    bool substituted = false;
+    FrameEntryList entries;
+    std::vector<std::pair<tracy::CallstackFrame*, uint32_t>> frames;
+    SymbolEntryList resolvedEntries;
+    size_t cached = 0;
+    bool resolved = false;
+    bool cacheFailed = false;
+};
+
+// Runs on a worker thread, so it must not touch the worker's string storage.
+static void ResolveImage( ImageJob& job, const PathSubstitutionList& pathSubstitutionlist, const std::string& cacheDir )
+{
+    job.resolvePath = job.imagePath;
+    job.substituted = ApplyPathSubstitutions( job.resolvePath, pathSubstitutionlist );
+
+    // only the offsets missing from the cache are passed to the resolver
+    SymbolCache cache( cacheDir, job.resolvePath );
+    FrameEntryList missingEntries;
+    if( cache.IsValid() )
+    {
+        for( auto& entry : job.entries )
+        {
+            if( !cache.Find( entry.symbolOffset ) ) missingEntries.push_back( entry );
+        }
+        job.cached = job.entries.size() - missingEntries.size();
+    }
+    const FrameEntryList& queryEntries = cache.IsValid() ? missingEntries : job.entries;
+
+    if( !queryEntries.empty() )
+    {
+        ResolveSymbols( job.resolvePath, queryEntries, job.resolvedEntries );
+        if( job.resolvedEntries.size() != queryEntries.size() ) return;
+    }
+
+    if( cache.IsValid() )
+    {
+        // missing entries were resolved in the order they appear in the job
+        SymbolEntryList mergedEntries;
+        mergedEntries.reserve( job.entries.size() );
+        size_t idx = 0;
+        for( auto& entry : job.entries )
+        {
+            auto cached = cache.Find( entry.symbolOffset );
+            mergedEntries.push_back( cached ? *cached : job.resolvedEntries[idx++] );
+        }
+
+        for( size_t i = 0; i < job.resolvedEntries.size(); ++i )
+        {
+            cache.Add( missingEntries[i].symbolOffset, job.resolvedEntries[i] );
+        }
+        job.cacheFailed = !cache.Save();
+        job.resolvedEntries = std::move( mergedEntries );
+    }
+    job.resolved = true;
+}
+
+bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& pathSubstitutionlist, const std::string& cacheDir, bool verbose )
 {
     uint64_t callstackFrameCount = worker.GetCallstackFrameCount();
     std::string relativeSoNameMatch = "[unresolved]";
@@ -39,8 +107,10 @@ bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& p
     std::cout << "Found " << callstackFrameCount << " callstack frames. Batching into image groups..." << std::endl;
 
     // batch the symbol queries by .so so we issue the least amount of requests
-    using FrameEntriesPerImageIdx = std::unordered_map<uint32_t, FrameEntryList>;
-    FrameEntriesPerImageIdx entriesPerImageIdx;
+    std::vector<ImageJob> jobs;
+    std::vector<std::unordered_map<uint64_t, uint32_t>> offsetsPerJob;
+    std::unordered_map<uint32_t, size_t> jobPerImageIdx;
+    size_t unresolvedFrames = 0;
 
     auto& callstackFrameMap = worker.GetCallstackFrameMap();
     for( auto it = callstackFrameMap.begin(); it != callstackFrameMap.end(); ++it )
@@ -52,10 +122,17 @@ bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& p
         }
 
         tracy::CallstackFrameData& frameData = *frameDataPtr;
-        const char* imageName = worker.GetString( frameData.imageName );
 
         const uint32_t imageNameIdx = frameData.imageName.Idx();
-        FrameEntryList& entries = entriesPerImageIdx[imageNameIdx];
+        auto jit = jobPerImageIdx.emplace( imageNameIdx, jobs.size() );
+        if( jit.second )
+        {
+            jobs.emplace_back();
+            jobs.back().imagePath = worker.GetString( frameData.imageName );
+            offsetsPerJob.emplace_back();
+        }
+        ImageJob& job = jobs[jit.first->second];
+        auto& offsets = offsetsPerJob[jit.first->second];
 
         for( uint8_t f = 0; f < frameData.size; f++ )
         {
@@ -67,75 +144,115 @@ bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& p
             {
                 // when doing offline resolving we pass the offset from the start of the shared library in the "symAddr"
                 const uint64_t decodedOffset = frame.symAddr;
-                entries.push_back( {&frame, decodedOffset} );
+                auto oit = offsets.emplace( decodedOffset, (uint32_t)job.entries.size() );
+                if( oit.second ) job.entries.push_back( {&frame, decodedOffset} );
+                job.frames.emplace_back( &frame, oit.first->second );
+                unresolvedFrames++;
             }
         }
     }
 
-    std::cout << "Batched into " << entriesPerImageIdx.size() << " unique image groups" << std::endl;
+    size_t uniqueAddresses = 0;
+    for( auto& job : jobs ) uniqueAddresses += job.entries.size();
+    std::cout << "Batched " << unresolvedFrames << " unresolved frames into " << uniqueAddresses
+              << " unique addresses in " << jobs.size() << " image groups" << std::endl;
 
-    // FIXME: the resolving of symbols here can be slow and could be done in parallel per "image"
-    // - be careful with string allocation though as that would be not safe to do in parallel
-    for( FrameEntriesPerImageIdx::iterator imageIt = entriesPerImageIdx.begin(),
-         imageItEnd = entriesPerImageIdx.end(); imageIt != imageItEnd; ++imageIt )
+    // images are resolved in parallel, the results are patched in afterwards, as string
+    // storage is not thread safe
+    const auto t0 = std::chrono::high_resolution_clock::now();
     {
-        tracy::StringIdx imageIdx( imageIt->first );
-        std::string imagePath = worker.GetString( imageIdx );
-
-        FrameEntryList& entries = imageIt->second;
+        std::atomic<size_t> nextJob = 0;
+        auto resolveJobs = [&] {
+            for(;;)
+            {
+                const auto idx = nextJob.fetch_add( 1, std::memory_order_relaxed );
+                if( idx >= jobs.size() ) break;
+                if( !jobs[idx].entries.empty() ) ResolveImage( jobs[idx], pathSubstitutionlist, cacheDir );
+            }
+        };
+        const size_t threadCount = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), jobs.size() );
+        std::vector<std::thread> threads;
+        for( size_t i = 1; i < threadCount; i++ ) threads.emplace_back( resolveJobs );
+        resolveJobs();
+        for( auto& thread : threads ) thread.join();
+    }
+    const auto t1 = std::chrono::high_resolution_clock::now();
 
-        if( !entries.size() ) continue;
+    size_t cachedAddresses = 0;
+    size_t resolvedAddresses = 0;
+    for( ImageJob& job : jobs )
+    {
+        if( job.entries.empty() ) continue;
 
-        std::cout << "Resolving " << entries.size() << " symbols for image: '" 
-                  << imagePath << "'" << std::endl;
-        const bool substituted = ApplyPathSubstitutions( imagePath, pathSubstitutionlist );
-        if( substituted )
+        std::cout << "Resolving " << job.entries.size() << " symbols for image: '"
+                  << job.imagePath << "'" << std::endl;
+        if( job.substituted )
         {
-            std::cout << "\tPath substituted to: '" << imagePath << "'" << std::endl;
+            std::cout << "\tPath substituted to: '" << job.resolvePath << "'" << std::endl;
         }
-
-        SymbolEntryList resolvedEntries;
-        ResolveSymbols( imagePath, entries, resolvedEntries );
-
-        if( resolvedEntries.size() != entries.size() )
+        if( job.cached != 0 )
         {
-            std::cerr << " failed to resolve all entries! (got: " 
-                      << resolvedEntries.size() << ")" << std::endl;
+            std::cout << "\tFound " << job.cached << " symbols in cache" << std::endl;
+        }
+        if( job.cacheFailed )
+        {
+            std::cerr << "\tFailed to write symbol cache" << std::endl;
+        }
+        if( !job.resolved )
+        {
+            std::cerr << " failed to resolve all entries! (got: "
+                      << job.resolvedEntries.size() << ")" << std::endl;
             continue;
         }
+        resolvedAddresses += job.entries.size() - job.cached;
+        cachedAddresses += job.cached;
 
-        // finally patch the string with the resolved symbol data
-        for ( size_t i = 0; i < resolvedEntries.size(); ++i )
+        // finally patch the string with the resolved symbol data, storing each string only once
+        std::vector<std::pair<tracy::StringIdx, tracy::StringIdx>> strings( job.resolvedEntries.size() );
+        std::vector<bool> stored( job.resolvedEntries.size() );
+        for( auto& v : job.frames )
         {
-            FrameEntry& frameEntry = entries[i];
-            const SymbolEntry& symbolEntry = resolvedEntries[i];
-
-            tracy::CallstackFrame& frame = *frameEntry.frame;
+            tracy::CallstackFrame& frame = *v.first;
+            const SymbolEntry& symbolEntry = job.resolvedEntries[v.second];
 
             if( !symbolEntry.name.length() ) continue;
 
             if( verbose )
             {
                 const char* nameStr = worker.GetString( frame.name );
-                std::cout << "patching '" << nameStr << "' of '" << imagePath 
+                std::cout << "patching '" << nameStr << "' of '" << job.resolvePath
                           << "' -> '" << symbolEntry.name << "'" << std::endl;
             }
 
-            frame.name = AddSymbolString( worker, symbolEntry.name );
-            const char* newName = worker.GetString( frame.name );
+            if( !stored[v.second] )
+            {
+                strings[v.second].first = AddSymbolString( worker, symbolEntry.name );
+                if( symbolEntry.file.length() ) strings[v.second].second = AddSymbolString( worker, symbolEntry.file );
+                stored[v.second] = true;
+            }
 
+            frame.name = strings[v.second].first;
             if( symbolEntry.file.length() )
             {
-                frame.file = AddSymbolString( worker, symbolEntry.file );
+                frame.file = strings[v.second].second;
                 frame.line = symbolEntry.line;
             }
         }
     }
 
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( t1 - t0 ).count();
+    std::cout << "Resolved " << resolvedAddresses << " addresses (" << cachedAddresses << " from cache) in "
+              << tracy::TimeToString( elapsed );
+    if( elapsed > 0 && resolvedAddresses > 0 )
+    {
+        std::cout << ", " << uint64_t( resolvedAddresses * 1000000000. / elapsed ) << " addresses/s";
+    }
+    std::cout << std::endl;
+
     return true;
 }
 
-void PatchSymbols( tracy::Worker& worker, const std::vector<std::string>& pathSubstitutionsStrings, bool verbose )
+void PatchSymbols( tracy::Worker& worker, const std::vector<std::string>& pathSubstitutionsStrings, const std::string& cacheDir, bool verbose )
 {
     std::cout << "Resolving and patching symbols..." << std::endl;
 
@@ -164,7 +281,7 @@ void PatchSymbols( tracy::Worker& worker, const std::vector<std::string>& pathSu
         }
     }
 
-    if ( !PatchSymbolsWithRegex(worker, pathSubstitutionList, verbose) )
+    if ( !PatchSymbolsWithRegex(worker, pathSubstitutionList, cacheDir, verbose) )
     {
         std::cerr << "Failed to patch symbols" << std::endl;
     }
@@ -32,9 +32,9 @@ using SymbolEntryList = std::vector<SymbolEntry>;
 bool ResolveSymbols( const std::string& imagePath, const FrameEntryList& inputEntryList,
                      SymbolEntryList& resolvedEntries );
 
-void PatchSymbols( tracy::Worker& worker, const std::vector<std::string>& pathSubstitutionsStrings, bool verbose = false );
+void PatchSymbols( tracy::Worker& worker, const std::vector<std::string>& pathSubstitutionsStrings, const std::string& cacheDir, bool verbose = false );
 
 using PathSubstitutionList = std::vector<std::pair<std::regex, std::string> >;
-bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& pathSubstituionlist, bool verbose = false );
+bool PatchSymbolsWithRegex( tracy::Worker& worker, const PathSubstitutionList& pathSubstituionlist, const std::string& cacheDir, bool verbose = false );
 
 #endif // __SYMBOLRESOLVER_HPP__
\ No newline at end of file
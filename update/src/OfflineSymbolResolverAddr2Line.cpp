@@ -1,4 +1,4 @@
-#ifndef _WIN32
+#if !defined _WIN32 && !defined __linux__
 
 #include "OfflineSymbolResolver.h"
 
@@ -156,4 +156,4 @@ bool ResolveSymbols( const std::string& imagePath, const FrameEntryList& inputEn
     return symbolResolver.ResolveSymbols( imagePath, inputEntryList, resolvedEntries );
 }
 
-#endif // #ifndef _WIN32
+#endif // #if !defined _WIN32 && !defined __linux__
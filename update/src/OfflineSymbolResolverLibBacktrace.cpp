@@ -0,0 +1,77 @@
+#ifdef __linux__
+
+#include <cxxabi.h>
+#include <stdlib.h>
+#include <string>
+
+#include "../../public/libbacktrace/backtrace.hpp"
+
+#include "OfflineSymbolResolver.h"
+
+static std::string Demangle( const char* name )
+{
+    int status;
+    char* demangled = abi::__cxa_demangle( name, nullptr, nullptr, &status );
+    if( !demangled ) return name;
+    std::string ret( demangled );
+    free( demangled );
+    return ret;
+}
+
+static int FileLineCallback( void* data, uintptr_t /*pc*/, uintptr_t /*lowaddr*/, const char* fn, int lineno, const char* function )
+{
+    // Inlined functions are reported innermost first. Only the innermost one is kept, as a frame
+    // has a single name and source location.
+    auto entry = (SymbolEntry*)data;
+    if( function ) entry->name = Demangle( function );
+    if( fn )
+    {
+        entry->file = fn;
+        entry->line = lineno;
+    }
+    return 1;
+}
+
+static void SymInfoCallback( void* data, uintptr_t /*pc*/, const char* symname, uintptr_t /*symval*/, uintptr_t /*symsize*/ )
+{
+    if( symname ) ((SymbolEntry*)data)->name = Demangle( symname );
+}
+
+static void ErrorCallback( void* /*data*/, const char* /*msg*/, int /*errnum*/ )
+{
+}
+
+bool ResolveSymbols( const std::string& imagePath, const FrameEntryList& inputEntryList,
+                     SymbolEntryList& resolvedEntries )
+{
+    // Each image gets its own state, so that images can be resolved on separate threads. The
+    // state is released when done, as a trace may reference hundreds of images.
+    auto state = tracy::backtrace_create_state( imagePath.c_str(), 0, ErrorCallback, nullptr );
+    if( !state ) return false;
+    if( !tracy::backtrace_initialize_file( state, imagePath.c_str(), ErrorCallback, nullptr ) )
+    {
+        tracy::backtrace_free_state( state );
+        return false;
+    }
+
+    resolvedEntries.reserve( resolvedEntries.size() + inputEntryList.size() );
+    for( const FrameEntry& entry : inputEntryList )
+    {
+        SymbolEntry newEntry;
+        tracy::backtrace_pcinfo( state, entry.symbolOffset, FileLineCallback, ErrorCallback, &newEntry );
+        if( newEntry.name.empty() )
+        {
+            tracy::backtrace_syminfo( state, entry.symbolOffset, SymInfoCallback, ErrorCallback, &newEntry );
+        }
+        if( newEntry.name.empty() )
+        {
+            newEntry.name = "[unknown] + " + std::to_string( entry.symbolOffset );
+        }
+        resolvedEntries.push_back( std::move( newEntry ) );
+    }
+
+    tracy::backtrace_free_state( state );
+    return true;
+}
+
+#endif // #ifdef __linux__
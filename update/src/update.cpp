@@ -15,6 +15,7 @@
 #include "../../server/TracyWorker.hpp"
 #include "../../getopt/getopt.h"
 
+#include "OfflineSymbolCache.h"
 #include "OfflineSymbolResolver.h"
 
 #ifdef __APPLE__
@@ -37,6 +38,8 @@ void Usage()
     printf( "  -c: scan for source files missing in cache and add if found\n" );
     printf( "  -r: resolve symbols and patch callstack frames\n");
     printf( "  -p: substitute symbol resolution path with an alternative: \"REGEX_MATCH;REPLACEMENT\"\n");
+    printf( "  -k dir: directory of the resolved symbol cache (default: %s)\n", GetDefaultSymbolCacheDirectory().c_str() );
+    printf( "  -n: don't use the resolved symbol cache\n" );
     printf( "  -j: number of threads to use for compression (-1 to use all cores)\n" );
 
     exit( 1 );
@@ -60,9 +63,10 @@ int main( int argc, char** argv )
     bool cacheSource = false;
     bool resolveSymbols = false;
     std::vector<std::string> pathSubstitutions;
+    std::string symbolCacheDir = GetDefaultSymbolCacheDirectory();
 
     int c;
-    while( ( c = getopt( argc, argv, "4hez:ds:crp:j:" ) ) != -1 )
+    while( ( c = getopt( argc, argv, "4hez:ds:crp:k:nj:" ) ) != -1 )
     {
         switch( c )
         {
@@ -138,6 +142,12 @@ int main( int argc, char** argv )
         case 'p':
             pathSubstitutions.push_back(optarg);
             break;
+        case 'k':
+            symbolCacheDir = optarg;
+            break;
+        case 'n':
+            symbolCacheDir.clear();
+            break;
         case 'j':
             streams = atoi( optarg );
             break;
@@ -179,7 +189,7 @@ int main( int argc, char** argv )
             const auto t1 = std::chrono::high_resolution_clock::now();
 
             if( cacheSource ) worker.CacheSourceFiles();
-            if( resolveSymbols ) PatchSymbols( worker, pathSubstitutions );
+            if( resolveSymbols ) PatchSymbols( worker, pathSubstitutions, symbolCacheDir );
 
             auto w = std::unique_ptr<tracy::FileWrite>( tracy::FileWrite::Open( output, clev, zstdLevel, streams ) );
             if( !w )